@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "AliasIndex.h"
+
+namespace {
+constexpr std::string_view kDesktopSuffix = ".desktop";
+
+void appendKey(std::string &key, const AliasIndex::Kind kind, const std::string_view alias) {
+    key.push_back(static_cast<char>(kind));
+    key.append(AliasIndex::normalize(kind, alias));
+}
+}
+
+void AliasIndex::add(const Component &component) {
+    std::vector<std::string> keys;
+    const auto addKey = [&](const Kind kind, const std::string_view alias) {
+        if (!alias.empty()) {
+            appendKey(keys.emplace_back(), kind, alias);
+        }
+    };
+    addKey(Kind::DESKTOP_ID, component.launchable.desktop_id);
+    // Shells also look desktop applications up by their own ID, e.g. for legacy "foo.desktop" IDs
+    if (component.type == Component::ComponentType::DESKTOP_APPLICATION) {
+        addKey(Kind::DESKTOP_ID, component.id);
+    }
+    addKey(Kind::PKGNAME, component.pkgname);
+    addKey(Kind::SOURCE_PKGNAME, component.source_pkgname);
+    addKey(Kind::BUNDLE, component.bundle.id);
+    index_.add(keys, keys_);
+}
+
+void AliasIndex::finish() {
+    index_.finish(keys_.size());
+}
+
+IdRange AliasIndex::find(const Kind kind, const std::string_view alias) const {
+    std::string key;
+    return find(kind, alias, key);
+}
+
+std::vector<IdRange> AliasIndex::resolve(const Kind kind, const std::vector<std::string_view> &aliases) const {
+    std::vector<IdRange> ordinals;
+    ordinals.reserve(aliases.size());
+    std::string key;
+    for (const auto alias: aliases) {
+        ordinals.push_back(find(kind, alias, key));
+    }
+    return ordinals;
+}
+
+IdRange AliasIndex::find(const Kind kind, const std::string_view alias, std::string &key) const {
+    key.clear();
+    appendKey(key, kind, alias);
+    const auto term = keys_.find(key);
+    return term ? index_.postings(*term) : IdRange{};
+}
+
+std::string_view AliasIndex::normalize(const Kind kind, std::string_view alias) {
+    if (kind == Kind::DESKTOP_ID) {
+        if (const auto slash = alias.rfind('/'); slash != std::string_view::npos) {
+            alias.remove_prefix(slash + 1);
+        }
+        if (alias.size() > kDesktopSuffix.size() &&
+            alias.compare(alias.size() - kDesktopSuffix.size(), kDesktopSuffix.size(), kDesktopSuffix) == 0) {
+            alias.remove_suffix(kDesktopSuffix.size());
+        }
+    } else if (kind == Kind::BUNDLE && alias.find('/') != std::string_view::npos) {
+        // Flatpak refs are kind/name/arch/branch; a bare name/arch/branch is accepted too
+        if (alias.rfind("app/", 0) == 0 || alias.rfind("runtime/", 0) == 0) {
+            alias.remove_prefix(alias.find('/') + 1);
+        }
+        alias = alias.substr(0, alias.find('/'));
+    }
+    return alias;
+}
+
+std::optional<AliasIndex::Kind> AliasIndex::stringToKind(const std::string_view kind) {
+    if (kind == "desktop-id") {
+        return Kind::DESKTOP_ID;
+    }
+    if (kind == "pkgname") {
+        return Kind::PKGNAME;
+    }
+    if (kind == "source-pkgname") {
+        return Kind::SOURCE_PKGNAME;
+    }
+    if (kind == "bundle") {
+        return Kind::BUNDLE;
+    }
+    return std::nullopt;
+}
+
+std::string_view AliasIndex::kindToString(const Kind kind) {
+    switch (kind) {
+        case Kind::DESKTOP_ID: return "desktop-id";
+        case Kind::PKGNAME: return "pkgname";
+        case Kind::SOURCE_PKGNAME: return "source-pkgname";
+        case Kind::BUNDLE: return "bundle";
+    }
+    return {};
+}
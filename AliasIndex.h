@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ALIASINDEX_H
+#define ALIASINDEX_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+#include "FacetIndex.h"
+#include "TermDictionary.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Components by the names desktop shells know them under.
+ *
+ * Maps desktop file IDs, binary and source package names and bundle IDs to
+ * ordinals through one hash table, so resolving a running app or a .desktop
+ * file is a lookup instead of a catalog scan. Keys are normalized on both
+ * sides, see normalize().
+ */
+class AS_EXPORT AliasIndex {
+public:
+    enum class Kind : uint8_t { DESKTOP_ID, PKGNAME, SOURCE_PKGNAME, BUNDLE };
+
+    /// Appends the aliases of the next component.
+    void add(const Component &component);
+
+    /// Builds the postings; call once after the last add().
+    void finish();
+
+    /// Heap bytes of the keys and postings.
+    [[nodiscard]] size_t memoryFootprint() const { return keys_.memoryFootprint() + index_.memoryFootprint(); }
+
+    /// Ordinals of the components known by alias, ascending.
+    [[nodiscard]] IdRange find(Kind kind, std::string_view alias) const;
+
+    /// find() for each alias, in order; normalizes into one reused buffer.
+    [[nodiscard]] std::vector<IdRange> resolve(Kind kind, const std::vector<std::string_view> &aliases) const;
+
+    /**
+     * @brief Lookup form of an alias.
+     *
+     * Desktop IDs lose a directory and a ".desktop" suffix, so
+     * "/usr/share/applications/org.gnome.Maps.desktop" becomes "org.gnome.Maps".
+     * Flatpak refs ("app/org.gnome.Maps/x86_64/stable") become their application
+     * ID. Package names are kept as they are.
+     */
+    static std::string_view normalize(Kind kind, std::string_view alias);
+
+    static std::optional<Kind> stringToKind(std::string_view kind);
+
+    static std::string_view kindToString(Kind kind);
+
+private:
+    // Keys are the kind as one byte, then the normalized alias
+    TermDictionary keys_;
+    FacetIndex index_;
+
+    [[nodiscard]] IdRange find(Kind kind, std::string_view alias, std::string &key) const;
+};
+
+#endif // ALIASINDEX_H
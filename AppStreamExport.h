@@ -0,0 +1,30 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APPSTREAM_EXPORT_H
+#define APPSTREAM_EXPORT_H
+
+/*
+ * The library is built with hidden symbol visibility; AS_EXPORT marks the
+ * classes and functions that make up its public C and C++ interface.
+ */
+#if defined(__GNUC__)
+#define AS_EXPORT __attribute__((visibility("default")))
+#else
+#define AS_EXPORT
+#endif
+
+#endif // APPSTREAM_EXPORT_H
@@ -19,28 +19,38 @@
 #include <spdlog/spdlog.h>
 #include <set>
 #include <cassert>
+#include <cctype>
+#include <charconv>
 #include <cstring>
+#include <ctime>
 #include <algorithm>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <iomanip>
+#include <filesystem>
+#include <numeric>
+#include <stdexcept>
 #include <unistd.h>
 #include <unordered_set>
 
 // Define the chunk size
 constexpr size_t CHUNK_SIZE = 1024;
+// Parsed pages of the mapped file are dropped in steps of this size, so the
+// resident set does not grow with the file
+constexpr size_t RELEASE_SIZE = 4 * 1024 * 1024;
 
-int convertToInt(const std::string &str) {
-    try {
-        return std::stoi(str);
-    } catch (const std::invalid_argument &e) {
-        spdlog::error("Invalid argument: could not convert to int: {}", str);
-        throw;
-    } catch (const std::out_of_range &e) {
+int convertToInt(const std::string_view str) {
+    int value = 0;
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec == std::errc::result_out_of_range) {
         spdlog::error("Out of range: value is too large to fit in an int:  {}", str);
-        throw;
+        throw std::out_of_range("convertToInt");
+    }
+    if (ec != std::errc() || end == str.data()) {
+        spdlog::error("Invalid argument: could not convert to int: {}", str);
+        throw std::invalid_argument("convertToInt");
     }
+    return value;
 }
 
 size_t convertToSizeT(const char *str) {
@@ -57,24 +67,74 @@ size_t convertToSizeT(const char *str) {
     return result;
 }
 
-// Function to parse a const char* as a Unix timestamp and convert to ISO 8601
-std::string unixEpochToISO8601(const char *epochStr) {
-    const std::time_t epoch = std::stoll(epochStr);
-    const std::tm tm = *std::gmtime(&epoch);
-    std::stringstream ss;
-    ss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S") << 'Z';
-    return ss.str();
+// Formats a Unix timestamp as ISO 8601 into buffer and returns the formatted part
+std::string_view unixEpochToISO8601(const char *epochStr, char (&buffer)[32]) {
+    long long epoch = 0;
+    if (std::from_chars(epochStr, epochStr + std::strlen(epochStr), epoch).ec != std::errc()) {
+        throw std::invalid_argument(std::string("Invalid timestamp: ") + epochStr);
+    }
+    const auto time = static_cast<std::time_t>(epoch);
+    std::tm tm{};
+    gmtime_r(&time, &tm);
+    return {buffer, std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm)};
+}
+
+// Appends character data to description markup, escaping it back to XML
+void appendEscaped(std::string &out, const char *text, const int len) {
+    for (int i = 0; i < len; ++i) {
+        switch (text[i]) {
+            case '&': out.append("&amp;");
+                break;
+            case '<': out.append("&lt;");
+                break;
+            case '>': out.append("&gt;");
+                break;
+            default: out.push_back(text[i]);
+        }
+    }
 }
 
 void AppStreamParser::startElementCallback(void *user_data, const xmlChar *name, const xmlChar **attrs) {
     auto *parser = static_cast<AppStreamParser *>(user_data);
     const auto tag = reinterpret_cast<const char *>(name);
-    parser->state_.currentElement = reinterpret_cast<const char *>(name);
+    ++parser->state_.depth;
+
+    // Rejected components and other-language elements are skipped wholesale
+    if (parser->state_.skipComponent || parser->state_.skipLanguageDepth) {
+        return;
+    }
+
+    // Description markup (p, ul, li, em, code) is kept as-is
+    if (parser->state_.insideDescription) {
+        if (!parser->state_.skipDescription) {
+            parser->state_.descriptionMarkup.push_back('<');
+            parser->state_.descriptionMarkup.append(tag);
+            parser->state_.descriptionMarkup.push_back('>');
+        }
+        return;
+    }
+
+    parser->state_.collectText = true;
     parser->state_.currentData.clear();
 
     if (strcmp(tag, "component") == 0) {
         parser->state_.insideComponent = true;
+        parser->state_.componentDepth = parser->state_.depth;
         parser->state_.currentComponent = std::make_shared<Component>();
+        parser->state_.releaseMark = parser->releases_.mark();
+        if (parser->textStore_) {
+            parser->state_.textMark = parser->textStore_->mark();
+        }
+        if (attrs) {
+            for (int i = 0; attrs[i]; i += 2) {
+                if (strcmp(reinterpret_cast<const char *>(attrs[i]), "type") == 0) {
+                    parser->state_.currentComponent->type = Component::stringToComponentType(
+                        reinterpret_cast<const char *>(attrs[i + 1]));
+                    break;
+                }
+            }
+        }
+        parser->acceptComponent(ComponentFilter::Stage::TYPE);
         return;
     }
 
@@ -83,29 +143,60 @@ void AppStreamParser::startElementCallback(void *user_data, const xmlChar *name,
         return;
     }
 
+    if (strcmp(tag, "suggests") == 0) {
+        parser->state_.insideSuggests = true;
+        return;
+    }
+
+    if (strcmp(tag, "description") == 0) {
+        parser->state_.insideDescription = true;
+        parser->state_.skipDescription = false;
+        parser->state_.descriptionMarkup.clear();
+        if (attrs) {
+            for (int i = 0; attrs[i]; i += 2) {
+                if (strcmp(reinterpret_cast<const char *>(attrs[i]), "xml:lang") == 0) {
+                    const auto value = reinterpret_cast<const char *>(attrs[i + 1]);
+                    parser->state_.skipDescription =
+                            !parser->state_.language.empty() && parser->state_.language != value;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
     if (parser->state_.insideReleases) {
         if (strcmp(tag, "release") == 0) {
-            parser->state_.currentRelease = Component::Release();
             // spec defaults
-            parser->state_.currentRelease.type = Component::ReleaseType::STABLE;
-            parser->state_.currentRelease.urgency = Component::ReleaseUrgency::MEDIUM;
+            auto type = Component::ReleaseType::STABLE;
+            auto urgency = Component::ReleaseUrgency::MEDIUM;
             if (attrs) {
                 for (int i = 0; attrs[i]; i += 2) {
                     const auto key = reinterpret_cast<const char *>(attrs[i]);
                     const auto value = reinterpret_cast<const char *>(attrs[i + 1]);
-                    long unsigned int value_len = xmlStrlen(attrs[i + 1]);
                     if (strcmp(key, "type") == 0) {
-                        parser->state_.currentRelease.type = Component::stringToReleaseType({value, value_len});
-                    } else if (strcmp(key, "version") == 0) {
-                        parser->state_.currentRelease.version = {value, value_len};
+                        type = Component::stringToReleaseType(value);
+                    } else if (strcmp(key, "urgency") == 0) {
+                        urgency = Component::stringToReleaseUrgency(value);
+                    }
+                }
+            }
+            auto &releases = parser->releases_;
+            releases.addRelease(type, urgency);
+            parser->state_.insideRelease = true;
+            if (attrs) {
+                for (int i = 0; attrs[i]; i += 2) {
+                    const auto key = reinterpret_cast<const char *>(attrs[i]);
+                    const auto value = reinterpret_cast<const char *>(attrs[i + 1]);
+                    if (strcmp(key, "version") == 0) {
+                        releases.setField(ReleaseStore::Field::VERSION, value);
                     } else if (strcmp(key, "date") == 0) {
-                        parser->state_.currentRelease.date = {value, value_len};
+                        releases.setField(ReleaseStore::Field::DATE, value);
                     } else if (strcmp(key, "timestamp") == 0) {
-                        parser->state_.currentRelease.timestamp = unixEpochToISO8601(value);
+                        char timestamp[32];
+                        releases.setField(ReleaseStore::Field::TIMESTAMP, unixEpochToISO8601(value, timestamp));
                     } else if (strcmp(key, "date_eol") == 0) {
-                        parser->state_.currentRelease.date_eol = {value, value_len};
-                    } else if (strcmp(key, "urgency") == 0) {
-                        parser->state_.currentRelease.urgency = Component::stringToReleaseUrgency({value, value_len});
+                        releases.setField(ReleaseStore::Field::DATE_EOL, value);
                     }
                 }
             }
@@ -116,29 +207,53 @@ void AppStreamParser::startElementCallback(void *user_data, const xmlChar *name,
             return;
         }
         if (strcmp(tag, "issue") == 0) {
-            parser->state_.currentIssue = Component::Issue();
-            // spec default
+            parser->state_.currentIssueType = Component::IssueType::UNKNOWN;
+            parser->state_.currentIssueUrl.clear();
             if (attrs) {
                 for (int i = 0; attrs[i]; i += 2) {
                     const auto key = reinterpret_cast<const char *>(attrs[i]);
                     if (strcmp(key, "type") == 0) {
                         const auto value = reinterpret_cast<const char *>(attrs[i + 1]);
                         long unsigned int value_len = xmlStrlen(attrs[i + 1]);
-                        parser->state_.currentIssue.type = Component::stringToIssueType({value, value_len});
+                        parser->state_.currentIssueType = Component::stringToIssueType({value, value_len});
                     }
                     if (strcmp(key, "url") == 0) {
-                        const auto value = reinterpret_cast<const char *>(attrs[i + 1]);
-                        long unsigned int value_len = xmlStrlen(attrs[i + 1]);
-                        parser->state_.currentIssue.url = {value, value_len};
+                        parser->state_.currentIssueUrl = reinterpret_cast<const char *>(attrs[i + 1]);
                     }
                 }
             }
             return;
         }
-        if (strcmp(tag, "artifact") == 0) {
+        if (strcmp(tag, "artifact") == 0 && parser->state_.insideRelease) {
             parser->state_.insideArtifact = true;
-            parser->state_.currentArtifact = Component::Artifact();
+            parser->releases_.addArtifact();
+        }
+    }
+
+    if (strcmp(tag, "content_rating") == 0) {
+        parser->state_.currentComponent->contentRating.setRated();
+        if (attrs) {
+            for (int i = 0; attrs[i]; i += 2) {
+                if (strcmp(reinterpret_cast<const char *>(attrs[i]), "type") == 0) {
+                    parser->state_.currentComponent->content_rating = reinterpret_cast<const char *>(attrs[i + 1]);
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    if (strcmp(tag, "content_attribute") == 0) {
+        parser->state_.contentAttribute.clear();
+        if (attrs) {
+            for (int i = 0; attrs[i]; i += 2) {
+                if (strcmp(reinterpret_cast<const char *>(attrs[i]), "id") == 0) {
+                    parser->state_.contentAttribute = reinterpret_cast<const char *>(attrs[i + 1]);
+                    break;
+                }
+            }
         }
+        return;
     }
 
     if (strcmp(tag, "icon") == 0) {
@@ -168,9 +283,17 @@ void AppStreamParser::startElementCallback(void *user_data, const xmlChar *name,
             const auto value = reinterpret_cast<const char *>(attrs[i + 1]);
             long unsigned int value_len = xmlStrlen(attrs[i + 1]);
             if (strcmp(key, "xml:lang") == 0) {
-                if (const std::string lang(value);
-                    !parser->state_.language.empty() && lang != parser->state_.language) {
-                    parser->state_.currentElement = {};
+                if (!parser->state_.language.empty() && parser->state_.language != value) {
+                    parser->state_.collectText = false;
+                    parser->state_.skipLanguageDepth = parser->state_.depth;
+                }
+                break;
+            }
+            if (parser->state_.insideArtifact && strcmp(key, "type") == 0) {
+                if (strcmp(tag, "checksum") == 0) {
+                    parser->state_.currentArtifactChecksumKey = value;
+                } else if (strcmp(tag, "size") == 0) {
+                    parser->state_.currentArtifactSizeKey = value;
                 }
                 break;
             }
@@ -197,11 +320,46 @@ void AppStreamParser::startElementCallback(void *user_data, const xmlChar *name,
 
 void AppStreamParser::endElementCallback(void *user_data, const xmlChar *name) {
     auto *parser = static_cast<AppStreamParser *>(user_data);
-    const std::string currentElement(reinterpret_cast<const char *>(name));
+    const int depth = parser->state_.depth--;
+
+    if (parser->state_.skipComponent) {
+        if (strcmp(reinterpret_cast<const char *>(name), "component") == 0) {
+            parser->resetComponentState();
+        }
+        return;
+    }
+
+    if (parser->state_.skipLanguageDepth) {
+        if (depth == parser->state_.skipLanguageDepth) {
+            parser->state_.skipLanguageDepth = 0;
+            parser->state_.currentData.clear();
+            parser->state_.collectText = false;
+        }
+        return;
+    }
+
+    if (parser->state_.insideDescription && strcmp(reinterpret_cast<const char *>(name), "description") != 0) {
+        if (!parser->state_.skipDescription) {
+            parser->state_.descriptionMarkup.append("</");
+            parser->state_.descriptionMarkup.append(reinterpret_cast<const char *>(name));
+            parser->state_.descriptionMarkup.push_back('>');
+        }
+        return;
+    }
+
+    const std::string_view currentElement(reinterpret_cast<const char *>(name));
 
     if (parser->state_.insideComponent) {
         if (currentElement == "id") {
-            parser->state_.currentComponent->id = parser->state_.currentData;
+            // <id> also appears in <suggests>, <extends>, <requires> and the like
+            if (depth == parser->state_.componentDepth + 1) {
+                parser->state_.currentComponent->id = parser->state_.currentData;
+                parser->acceptComponent(ComponentFilter::Stage::ID);
+            } else if (parser->state_.insideSuggests) {
+                parser->state_.currentComponent->suggests.push_back(parser->state_.currentData);
+            }
+        } else if (currentElement == "suggests") {
+            parser->state_.insideSuggests = false;
         } else if (currentElement == "pkgname") {
             parser->state_.currentComponent->pkgname = parser->state_.currentData;
         } else if (currentElement == "source_pkgname") {
@@ -217,15 +375,23 @@ void AppStreamParser::endElementCallback(void *user_data, const xmlChar *name) {
         } else if (currentElement == "summary") {
             parser->state_.currentComponent->summary = parser->state_.currentData;
         } else if (currentElement == "description") {
-            if (parser->state_.insideReleases) {
-                parser->state_.currentRelease.description = parser->state_.currentData;
-            } else {
-                parser->state_.currentComponent->description = parser->state_.currentData;
+            parser->state_.insideDescription = false;
+            if (parser->state_.skipDescription) {
+                // translation for another language
+            } else if (parser->state_.insideRelease) {
+                if (parser->textStore_) {
+                    parser->releases_.setDescriptionHandle(
+                        parser->textStore_->append(parser->state_.descriptionMarkup));
+                } else {
+                    parser->releases_.setField(ReleaseStore::Field::DESCRIPTION, parser->state_.descriptionMarkup);
+                }
+            } else if (!parser->state_.insideReleases) {
+                parser->state_.currentComponent->description = parser->state_.descriptionMarkup;
             }
         } else if (currentElement == "url") {
-            if (parser->state_.insideReleases) {
-                parser->state_.currentRelease.url = parser->state_.currentData;
-            } else {
+            if (parser->state_.insideRelease) {
+                parser->releases_.setField(ReleaseStore::Field::URL, parser->state_.currentData);
+            } else if (!parser->state_.insideReleases) {
                 if (parser->state_.urlType == Component::UrlType::HELP) {
                     parser->state_.currentComponent->url.help = parser->state_.currentData;
                 } else if (parser->state_.urlType == Component::UrlType::CONTACT) {
@@ -269,19 +435,22 @@ void AppStreamParser::endElementCallback(void *user_data, const xmlChar *name) {
             }
         } else if (currentElement == "artifact") {
             parser->state_.insideArtifact = false;
-            parser->state_.currentRelease.artifacts.push_back(parser->state_.currentArtifact);
         } else if (parser->state_.insideArtifact && currentElement == "location") {
-            parser->state_.currentArtifact.location = parser->state_.currentData;
+            parser->releases_.setLocation(parser->state_.currentData);
         } else if (parser->state_.insideArtifact && currentElement == "checksum") {
-            parser->state_.currentArtifact.checksum[parser->state_.currentArtifactChecksumKey] = parser->state_.
-                    currentData;
+            parser->releases_.addChecksum(parser->state_.currentArtifactChecksumKey, parser->state_.currentData);
         } else if (parser->state_.insideArtifact && currentElement == "size") {
-            parser->state_.currentArtifact.size[parser->state_.currentArtifactSizeKey] = convertToSizeT(
-                parser->state_.currentData.c_str());
+            parser->releases_.setSize(parser->state_.currentArtifactSizeKey,
+                                      convertToSizeT(parser->state_.currentData.c_str()));
         } else if (currentElement == "bundle") {
             parser->state_.currentComponent->bundle.id = parser->state_.currentData;
-        } else if (currentElement == "content_rating") {
-            parser->state_.currentComponent->content_rating = parser->state_.currentData;
+            parser->acceptComponent(ComponentFilter::Stage::BUNDLE);
+        } else if (currentElement == "content_attribute") {
+            if (!parser->state_.currentComponent->contentRating.set(parser->state_.contentAttribute,
+                                                                    parser->state_.currentData)) {
+                SPDLOG_DEBUG("Ignoring content attribute {} = {}", parser->state_.contentAttribute,
+                             parser->state_.currentData);
+            }
         } else if (currentElement == "agreement") {
             parser->state_.currentComponent->agreement = parser->state_.currentData;
         } else if (currentElement == "keyword") {
@@ -290,49 +459,264 @@ void AppStreamParser::endElementCallback(void *user_data, const xmlChar *name) {
             parser->state_.currentComponent->categories.push_back(parser->state_.currentData);
         } else if (currentElement == "icon") {
             parser->state_.currentIcon.value = parser->state_.currentData;
-            parser->state_.currentComponent->icons.push_back(parser->state_.currentIcon);
-        } else if (currentElement == "suggest") {
-            parser->state_.currentComponent->suggests.push_back(parser->state_.currentData);
+            parser->state_.currentComponent->icons.push_back(std::move(parser->state_.currentIcon));
         } else if (currentElement == "media_baseurl") {
             parser->state_.currentComponent->media_baseurl = parser->state_.currentData;
         } else if (currentElement == "architecture") {
             parser->state_.currentComponent->architecture = parser->state_.currentData;
+            parser->acceptComponent(ComponentFilter::Stage::ARCHITECTURE);
         } else if (currentElement == "releases") {
             parser->state_.insideReleases = false;
         } else if (currentElement == "release") {
-            parser->state_.currentComponent->releases.push_back(parser->state_.currentRelease);
+            parser->state_.insideRelease = false;
         } else if (currentElement == "issues") {
             parser->state_.insideIssues = false;
-        } else if (currentElement == "issue") {
-            parser->state_.currentRelease.issues.push_back(parser->state_.currentIssue);
+        } else if (currentElement == "issue" && parser->state_.insideRelease) {
+            parser->releases_.addIssue(parser->state_.currentIssueType, parser->state_.currentIssueUrl,
+                                       parser->state_.currentData);
         } else if (currentElement == "language") {
             parser->state_.currentComponent->addSupportedLanguage(parser->state_.currentData);
         } else if (currentElement == "component") {
             parser->state_.insideComponent = false;
             assert(!parser->state_.currentComponent->id.empty());
-            if (!parser->components_.count(parser->state_.currentComponent->id)) {
-                parser->components_[parser->state_.currentComponent->id] = std::move(parser->state_.currentComponent);
-            } else {
-                SPDLOG_WARN("Duplicate: [{}]", parser->state_.currentComponent->id);
+            if (parser->acceptComponent(ComponentFilter::Stage::END)) {
+                if (parser->textStore_) {
+                    parser->compressDescriptions(*parser->state_.currentComponent);
+                }
+                const auto &mark = parser->state_.releaseMark;
+                parser->state_.currentComponent->releases = {
+                    &parser->releases_, mark.releases, parser->releases_.size() - mark.releases
+                };
+                if (parser->options_.sink) {
+                    parser->options_.sink(*parser->state_.currentComponent);
+                    ++parser->state_.sunkComponents;
+                    parser->state_.currentComponent.reset();
+                    parser->rollbackComponent();
+                } else if (!parser->addComponent(std::move(parser->state_.currentComponent))) {
+                    parser->rollbackComponent();
+                }
             }
         }
     }
 
     parser->state_.currentData.clear();
-    parser->state_.currentElement = {};
-    parser->state_.currentIcon = {};
+    parser->state_.collectText = false;
 }
 
 void AppStreamParser::charactersCallback(void *user_data, const xmlChar *ch, const int len) {
-    if (auto *parser = static_cast<AppStreamParser *>(user_data); !parser->state_.currentElement.empty()) {
-        parser->state_.currentData.append(reinterpret_cast<const char *>(ch), len);
+    auto *parser = static_cast<AppStreamParser *>(user_data);
+    if (parser->state_.skipComponent || parser->state_.skipLanguageDepth) {
+        return;
+    }
+    const auto text = reinterpret_cast<const char *>(ch);
+    if (parser->state_.insideDescription) {
+        // Drop indentation between markup elements
+        if (parser->state_.skipDescription ||
+            (std::memchr(text, '\n', len) && std::all_of(text, text + len, [](const char c) { return std::isspace(
+                static_cast<unsigned char>(c)); }))) {
+            return;
+        }
+        appendEscaped(parser->state_.descriptionMarkup, text, len);
+        return;
+    }
+    if (parser->state_.collectText) {
+        parser->state_.currentData.append(text, len);
     }
 }
 
 AppStreamParser::AppStreamParser(const std::string &filename, const std::string &language)
-    : language_(language) {
+    : AppStreamParser(filename, language, Options()) {
+}
+
+AppStreamParser::AppStreamParser(const std::string &filename, const std::string &language, const Options &options)
+    : AppStreamParser(filename, language, options, Deferred()) {
+    while (!parseStep({}).done) {
+    }
+}
+
+AppStreamParser::AppStreamParser(const std::string &filename, const std::string &language, const Options &options,
+                                 Deferred)
+    : language_(language),
+      iconsDirectory_((std::filesystem::path(filename).parent_path() / kIconsDirectoryName).string()),
+      queryCache_(options.memoryBudget ? 0 : options.queryCacheBytes),
+      options_(options) {
     state_.language = language;
-    parseFile(filename);
+    if (options_.compressDescriptions && !options_.sink) {
+        textStore_ = std::make_unique<TextStore>(options_.textBlockSize, options_.textCacheBlocks);
+    }
+    if (options_.memoryBudget && !options_.sink) {
+        spillStore_ = std::make_unique<SpillStore>(
+            options_.spillDirectory.empty() ? std::filesystem::temp_directory_path().string() : options_.spillDirectory,
+            options_.memoryBudget, &releases_);
+    }
+
+    mmapFile(filename);
+    xmlSAXHandler saxHandler = {
+        .startElement = startElementCallback,
+        .endElement = endElementCallback,
+        .characters = charactersCallback,
+    };
+    spdlog::info("Parsing file: {}", filename);
+    state_.filename = filename;
+    state_.offset = std::min<size_t>(4, fileSize_);
+    state_.context.reset(xmlCreatePushParserCtxt(&saxHandler, this, static_cast<const char *>(fileData_),
+                                                 static_cast<int>(state_.offset), filename.c_str()));
+}
+
+AppStreamParser::ParseProgress AppStreamParser::parseStep(const ParseBudget &budget) {
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = budget.time.count() ? Clock::now() + budget.time : Clock::time_point::max();
+    const auto start = state_.offset;
+    const auto exhausted = [&] {
+        return (budget.bytes && state_.offset - start >= budget.bytes) ||
+               (deadline != Clock::time_point::max() && Clock::now() >= deadline);
+    };
+
+    while (state_.phase == ParsingState::Phase::PARSING) {
+        parseChunk();
+        if (exhausted()) {
+            return getParseProgress();
+        }
+    }
+    // End-of-input work is split so that each piece can take a step of its own
+    if (state_.phase == ParsingState::Phase::COMPACTING) {
+        releases_.shrinkToFit();
+        if (textStore_) {
+            textStore_->flush();
+        }
+        state_.phase = ParsingState::Phase::ORDERING;
+        if (exhausted()) {
+            return getParseProgress();
+        }
+    }
+    if (state_.phase == ParsingState::Phase::ORDERING) {
+        buildOrdinals();
+        contentRatings_.reserve(ids_.size());
+        updateMemoryOverhead();
+        state_.phase = ParsingState::Phase::INDEXING;
+        if (exhausted()) {
+            return getParseProgress();
+        }
+    }
+    // Index in slices small enough to keep a step close to its time budget
+    constexpr size_t kIndexSlice = 64;
+    while (state_.phase == ParsingState::Phase::INDEXING) {
+        const auto last = std::min(state_.indexedOrdinals + kIndexSlice, ids_.size());
+        indexComponents(state_.indexedOrdinals, last);
+        state_.indexedOrdinals = last;
+        if (last == ids_.size()) {
+            finishIndexes();
+            state_.phase = ParsingState::Phase::DONE;
+        }
+        updateMemoryOverhead();
+        if (state_.phase != ParsingState::Phase::DONE && exhausted()) {
+            break;
+        }
+    }
+    return getParseProgress();
+}
+
+void AppStreamParser::parseChunk() {
+    const auto fail = [&](const int ret) {
+        spdlog::error("Failed to parse XML, error code: {}", ret);
+        state_.context.reset();
+        munmapFile();
+        throw std::runtime_error("Failed to parse XML: " + state_.filename);
+    };
+
+    if (state_.offset < fileSize_) {
+        if (state_.offset - state_.released >= RELEASE_SIZE) {
+            // libxml2 copies every chunk, so nothing refers to the parsed part of the mapping
+            const auto length = (state_.offset - state_.released) & ~(RELEASE_SIZE - 1);
+            madvise(static_cast<char *>(fileData_) + state_.released, length, MADV_DONTNEED);
+            state_.released += length;
+        }
+        const size_t chunkSize = std::min(CHUNK_SIZE, fileSize_ - state_.offset);
+        if (const int ret = xmlParseChunk(state_.context.get(), static_cast<const char *>(fileData_) + state_.offset,
+                                          static_cast<int>(chunkSize), 0); ret != 0) {
+            fail(ret);
+        }
+        state_.offset += chunkSize;
+        return;
+    }
+
+    // Send an EOF indication
+    if (const int ret = xmlParseChunk(state_.context.get(), nullptr, 0, 1); ret != 0) {
+        fail(ret);
+    }
+    state_.context.reset();
+    munmapFile();
+    state_.phase = ParsingState::Phase::COMPACTING;
+}
+
+void AppStreamParser::cancelParse() {
+    if (state_.phase == ParsingState::Phase::DONE) {
+        return;
+    }
+    state_.context.reset();
+    munmapFile();
+    resetComponentState();
+    clearCatalog();
+    state_.phase = ParsingState::Phase::CANCELLED;
+}
+
+void AppStreamParser::clearCatalog() {
+    components_.clear();
+    ordered_.clear();
+    ids_.clear();
+    terms_ = {};
+    categoryFacet_ = {};
+    keywordFacet_ = {};
+    publisherFacet_ = {};
+    contentRatings_ = {};
+    licenses_ = {};
+    aliases_ = {};
+    // Indexes built by queries made while the parse was running
+    {
+        std::lock_guard lock(iconMutex_);
+        iconIndexes_.clear();
+    }
+    {
+        std::lock_guard lock(searchMutex_);
+        searchIndex_.reset();
+    }
+    {
+        std::lock_guard lock(substringMutex_);
+        substringSearch_.reset();
+    }
+    {
+        std::lock_guard lock(completionMutex_);
+        completionIndex_.reset();
+    }
+    {
+        std::lock_guard lock(relationMutex_);
+        relations_.reset();
+    }
+    {
+        std::lock_guard lock(similarityMutex_);
+        similarity_.reset();
+    }
+    queryCache_.clear();
+    // The spill store reads releases_, so it goes first
+    spillStore_.reset();
+    slots_ = {};
+    pendingSlots_ = {};
+    textStore_.reset();
+    releases_ = {};
+    skippedComponents_ = 0;
+    idBytes_ = 0;
+    state_.sunkComponents = 0;
+    state_.indexedOrdinals = 0;
+}
+
+AppStreamParser::ParseProgress AppStreamParser::getParseProgress() const {
+    ParseProgress progress;
+    progress.bytesParsed = state_.offset;
+    progress.totalBytes = fileSize_;
+    progress.components = components_.size() + state_.sunkComponents;
+    progress.done = state_.phase == ParsingState::Phase::DONE;
+    progress.cancelled = state_.phase == ParsingState::Phase::CANCELLED;
+    return progress;
 }
 
 AppStreamParser::~AppStreamParser() {
@@ -343,14 +727,14 @@ void AppStreamParser::mmapFile(const std::string &filename) {
     const int fd = open(filename.c_str(), O_RDONLY);
     if (fd == -1) {
         spdlog::error("Failed to open file: {}", filename);
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Failed to open file: " + filename);
     }
 
     struct stat sb{};
     if (fstat(fd, &sb) == -1) {
         spdlog::error("Failed to get file size: {}", filename);
         close(fd);
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Failed to get file size: " + filename);
     }
     fileSize_ = sb.st_size;
 
@@ -359,7 +743,8 @@ void AppStreamParser::mmapFile(const std::string &filename) {
     close(fd);
     if (fileData_ == MAP_FAILED) {
         spdlog::error("Failed to memory-map file: {}", filename);
-        exit(EXIT_FAILURE);
+        fileData_ = nullptr;
+        throw std::runtime_error("Failed to memory-map file: " + filename);
     }
 }
 
@@ -370,122 +755,595 @@ void AppStreamParser::munmapFile() {
     }
 }
 
-void AppStreamParser::parseFile(const std::string &filename) {
-    mmapFile(filename);
+std::vector<std::string> AppStreamParser::getUniqueCategories() const {
+    std::vector<std::string> uniqueCategories;
+    uniqueCategories.reserve(categoryFacet_.counts().size());
+    for (const auto &[term, count]: categoryFacet_.counts()) {
+        uniqueCategories.emplace_back(terms_.term(term));
+    }
+    return uniqueCategories;
+}
 
-    xmlSAXHandler saxHandler = {
-        .startElement = startElementCallback,
-        .endElement = endElementCallback,
-        .characters = charactersCallback,
-    };
+std::vector<std::string> AppStreamParser::getUniqueKeywords() const {
+    std::vector<std::string> uniqueKeywords;
+    uniqueKeywords.reserve(keywordFacet_.counts().size());
+    for (const auto &[term, count]: keywordFacet_.counts()) {
+        uniqueKeywords.emplace_back(terms_.term(term));
+    }
+    return uniqueKeywords;
+}
 
-    spdlog::info("Parsing file: {}", filename);
+std::vector<std::shared_ptr<Component> > AppStreamParser::getSortedComponents(const SortOption option) const {
+    return *findSorted(option);
+}
+
+std::vector<std::shared_ptr<Component> > AppStreamParser::sortedComponents(const SortOption option) const {
+    // Ordinals are already in ID order
+    std::vector<std::shared_ptr<Component> > sortedComponents;
+    sortedComponents.reserve(ids_.size());
+    for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+        sortedComponents.push_back(getComponentAt(ordinal));
+    }
+
+    // Sort based on the option
+    switch (option) {
+        case SortOption::BY_ID:
+            break;
+        case SortOption::BY_NAME:
+            std::stable_sort(sortedComponents.begin(), sortedComponents.end(),
+                             [](const std::shared_ptr<Component> &a, const std::shared_ptr<Component> &b) {
+                                 return a->name < b->name;
+                             });
+            break;
+        default:
+            throw std::invalid_argument("Invalid sort option");
+    }
 
-    std::unique_ptr<xmlParserCtxt, decltype(&xmlFreeParserCtxt)> ctxt(
-        xmlCreatePushParserCtxt(&saxHandler, this, static_cast<const char *>(fileData_), 4, filename.c_str()),
-        xmlFreeParserCtxt);
+    return sortedComponents;
+}
 
-    size_t offset = 4;
-    while (offset < fileSize_) {
-        const size_t chunkSize = std::min(CHUNK_SIZE, fileSize_ - offset);
-        if (int ret = xmlParseChunk(ctxt.get(), static_cast<const char *>(fileData_) + offset,
-                                    static_cast<int>(chunkSize), 0);
-            ret != 0) {
-            spdlog::error("Failed to parse XML, error code: {}", ret);
-            munmapFile();
-            exit(EXIT_FAILURE);
+std::vector<uint32_t> AppStreamParser::getSortedOrdinals(const SortOption option) const {
+    std::vector<uint32_t> ordinals(ids_.size());
+    std::iota(ordinals.begin(), ordinals.end(), 0u);
+    switch (option) {
+        case SortOption::BY_ID:
+            break;
+        case SortOption::BY_NAME: {
+            // Only the names are kept, so spilled components are not all pulled back in at once
+            std::vector<std::string> names;
+            names.reserve(ids_.size());
+            for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+                names.push_back(getComponentAt(ordinal)->name);
+            }
+            std::stable_sort(ordinals.begin(), ordinals.end(), [&](const uint32_t a, const uint32_t b) {
+                return names[a] < names[b];
+            });
+            break;
         }
-        offset += chunkSize;
+        default:
+            throw std::invalid_argument("Invalid sort option");
     }
+    return ordinals;
+}
 
-    // Send an EOF indication
-    if (int ret = xmlParseChunk(ctxt.get(), nullptr, 0, 1); ret != 0) {
-        spdlog::error("Failed to parse XML, error code: {}", ret);
-        munmapFile();
-        exit(EXIT_FAILURE);
+std::vector<std::shared_ptr<Component> > AppStreamParser::searchByCategory(const std::string &category) const {
+    // Copying a cached result costs as much as collecting the postings, so only findByCategory() caches
+    return componentsAt(findOrdinals(Facet::CATEGORY, category));
+}
+
+std::vector<std::shared_ptr<Component> > AppStreamParser::searchByKeyword(const std::string &keyword) const {
+    return componentsAt(findOrdinals(Facet::KEYWORD, keyword));
+}
+
+QueryCache::Result AppStreamParser::findByCategory(const std::string_view category) const {
+    return queryCache_.get(QueryCache::makeKey("category", category), [&] {
+        return std::make_shared<const std::vector<std::shared_ptr<Component> > >(
+            componentsAt(findOrdinals(Facet::CATEGORY, category)));
+    });
+}
+
+QueryCache::Result AppStreamParser::findByKeyword(const std::string_view keyword) const {
+    return queryCache_.get(QueryCache::makeKey("keyword", keyword), [&] {
+        return std::make_shared<const std::vector<std::shared_ptr<Component> > >(
+            componentsAt(findOrdinals(Facet::KEYWORD, keyword)));
+    });
+}
+
+QueryCache::Result AppStreamParser::findSorted(const SortOption option) const {
+    const auto key = QueryCache::makeKey("sorted", option == SortOption::BY_NAME ? "name" : "id");
+    return queryCache_.get(key, [&] {
+        return std::make_shared<const std::vector<std::shared_ptr<Component> > >(sortedComponents(option));
+    });
+}
+
+QueryCache::Stats AppStreamParser::getQueryCacheStats() const {
+    return queryCache_.stats();
+}
+
+std::vector<std::shared_ptr<Component> > AppStreamParser::componentsAt(const IdRange ordinals) const {
+    std::vector<std::shared_ptr<Component> > result;
+    result.reserve(ordinals.size());
+    for (const auto ordinal: ordinals) {
+        result.push_back(getComponentAt(ordinal));
     }
+    return result;
+}
 
-    munmapFile();
+size_t AppStreamParser::getTotalComponentCount() const {
+    return components_.size();
 }
 
-std::vector<std::string> AppStreamParser::getUniqueCategories() {
-    std::unordered_set<std::string> uniqueCategories;
+const std::map<std::string, std::shared_ptr<Component> > &AppStreamParser::getComponents() const {
+    return components_;
+}
 
-    for (const auto &[key, component]: components_) {
-        uniqueCategories.insert(component->categories.begin(), component->categories.end());
+bool AppStreamParser::addComponent(std::shared_ptr<Component> component) {
+    auto [it, inserted] = components_.try_emplace(component->id);
+    if (!inserted) {
+        SPDLOG_WARN("Duplicate: [{}]", component->id);
+        return false;
+    }
+    if (spillStore_) {
+        pendingSlots_[it->first] = spillStore_->add(std::move(component));
+        // The ID map node and its key
+        constexpr size_t kNodeBytes = 4 * sizeof(void *) + sizeof(*it);
+        idBytes_ += kNodeBytes + (it->first.capacity() > sizeof(std::string) - 1 ? it->first.capacity() + 1 : 0);
+        updateMemoryOverhead();
+    } else {
+        it->second = std::move(component);
     }
+    return true;
+}
 
-    return {uniqueCategories.begin(), uniqueCategories.end()};
+void AppStreamParser::updateMemoryOverhead() {
+    if (!spillStore_) {
+        return;
+    }
+    // Pending slot entries give way to ids_ and slots_ once the parse is complete
+    constexpr size_t kSlotBytes = 2 * sizeof(void *) + sizeof(decltype(pendingSlots_)::value_type);
+    size_t bytes = idBytes_ + pendingSlots_.size() * kSlotBytes + pendingSlots_.bucket_count() * sizeof(void *) +
+                   ids_.capacity() * sizeof(ids_[0]) + slots_.capacity() * sizeof(slots_[0]);
+    bytes += releases_.stats().bytes + (textStore_ ? textStore_->stats().bytes : 0);
+    bytes += terms_.memoryFootprint() + categoryFacet_.memoryFootprint() + keywordFacet_.memoryFootprint() +
+            publisherFacet_.memoryFootprint() + licenses_.memoryFootprint() + aliases_.memoryFootprint() +
+            contentRatings_.capacity() * sizeof(contentRatings_[0]);
+    spillStore_->setOverhead(bytes);
 }
 
-std::vector<std::string> AppStreamParser::getUniqueKeywords() {
-    std::unordered_set<std::string> uniqueKeywords;
+std::shared_ptr<Component> AppStreamParser::getComponentAt(const size_t ordinal) const {
+    if (spillStore_) {
+        return spillStore_->get(slots_.at(ordinal));
+    }
+    return ordered_.at(ordinal);
+}
 
-    for (const auto &[key, component]: components_) {
-        uniqueKeywords.insert(component->keywords.begin(), component->keywords.end());
+std::optional<size_t> AppStreamParser::findOrdinal(const std::string_view id) const {
+    const auto it = std::lower_bound(ids_.begin(), ids_.end(), id, [](const std::string *a, const std::string_view b) {
+        return *a < b;
+    });
+    if (it == ids_.end() || **it != id) {
+        return std::nullopt;
     }
+    return static_cast<size_t>(it - ids_.begin());
+}
 
-    return {uniqueKeywords.begin(), uniqueKeywords.end()};
+std::shared_ptr<Component> AppStreamParser::findComponent(const std::string &id) const {
+    const auto ordinal = findOrdinal(id);
+    return ordinal ? getComponentAt(*ordinal) : nullptr;
 }
 
-std::vector<std::shared_ptr<Component> > AppStreamParser::getSortedComponents(const SortOption option) {
-    // Convert unordered_map to vector for sorting
-    std::vector<std::shared_ptr<Component> > sortedComponents;
-    sortedComponents.reserve(components_.size());
+SpillStore::Stats AppStreamParser::getMemoryStats() const {
+    return spillStore_ ? spillStore_->stats() : SpillStore::Stats{};
+}
+
+void AppStreamParser::buildOrdinals() {
+    ordered_.clear();
+    ids_.clear();
+    ids_.reserve(components_.size());
+    if (spillStore_) {
+        slots_.reserve(components_.size());
+    } else {
+        ordered_.reserve(components_.size());
+    }
     for (const auto &[key, component]: components_) {
-        sortedComponents.push_back(component);
+        ids_.push_back(&key);
+        if (spillStore_) {
+            slots_.push_back(pendingSlots_.at(key));
+        } else {
+            ordered_.push_back(component);
+        }
     }
+    pendingSlots_ = {};
+}
 
-    // Sort based on the option
-    switch (option) {
-        case SortOption::BY_ID:
-            std::sort(sortedComponents.begin(), sortedComponents.end(),
-                      [](const std::shared_ptr<Component> &a, const std::shared_ptr<Component> &b) {
-                          return a->id < b->id;
-                      });
-            break;
-        case SortOption::BY_NAME:
-            std::sort(sortedComponents.begin(), sortedComponents.end(),
-                      [](const std::shared_ptr<Component> &a, const std::shared_ptr<Component> &b) {
-                          return a->name < b->name;
-                      });
-            break;
-        default:
-            throw std::invalid_argument("Invalid sort option");
+const IconIndex &AppStreamParser::getBestIcons(const IconPolicy &policy) const {
+    std::lock_guard lock(iconMutex_);
+    for (const auto &index: iconIndexes_) {
+        if (index->policy() == policy) {
+            return *index;
+        }
     }
+    auto index = std::make_unique<IconIndex>(policy, ids_.size());
+    for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+        index->select(ordinal, *getComponentAt(ordinal), iconsDirectory_);
+    }
+    iconIndexes_.push_back(std::move(index));
+    return *iconIndexes_.back();
+}
 
-    return sortedComponents;
+void AppStreamParser::setIconsDirectory(const std::string &directory) {
+    std::lock_guard lock(iconMutex_);
+    iconsDirectory_ = directory;
+    iconIndexes_.clear();
 }
 
-std::vector<std::shared_ptr<Component> > AppStreamParser::searchByCategory(const std::string &category) {
-    std::vector<std::shared_ptr<Component> > result;
+const std::string &AppStreamParser::getIconsDirectory() const {
+    return iconsDirectory_;
+}
 
-    for (const auto &[key, component]: components_) {
-        if (std::find(component->categories.begin(), component->categories.end(), category) != component->categories.
-            end()) {
-            result.push_back(component);
+void AppStreamParser::rollbackComponent() {
+    releases_.rollback(state_.releaseMark);
+    if (textStore_) {
+        textStore_->rollback(state_.textMark);
+    }
+}
+
+bool AppStreamParser::acceptComponent(const ComponentFilter::Stage stage) {
+    if (options_.filter.empty() || options_.filter.accept(*state_.currentComponent, stage)) {
+        return true;
+    }
+    ++skippedComponents_;
+    rollbackComponent();
+    if (stage == ComponentFilter::Stage::END) {
+        resetComponentState();
+    } else {
+        // Ignore everything up to </component>
+        state_.skipComponent = true;
+        state_.currentComponent.reset();
+    }
+    return false;
+}
+
+void AppStreamParser::resetComponentState() {
+    state_.insideComponent = false;
+    state_.insideReleases = false;
+    state_.insideRelease = false;
+    state_.insideIssues = false;
+    state_.insideDescription = false;
+    state_.currentDeveloper = false;
+    state_.insideSuggests = false;
+    state_.insideArtifact = false;
+    state_.skipComponent = false;
+    state_.skipLanguageDepth = 0;
+    state_.currentComponent.reset();
+    state_.currentData.clear();
+    state_.collectText = false;
+}
+
+std::vector<SearchIndex::Hit> AppStreamParser::search(const std::string_view query, const size_t limit) const {
+    return getSearchIndex().search(query, limit);
+}
+
+const SearchIndex &AppStreamParser::getSearchIndex() const {
+    std::lock_guard lock(searchMutex_);
+    if (!searchIndex_) {
+        auto index = std::make_unique<SearchIndex>(options_.search);
+        for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+            const auto component = getComponentAt(ordinal);
+            index->add(*component, getDescription(*component));
         }
+        index->finish();
+        searchIndex_ = std::move(index);
     }
+    return *searchIndex_;
+}
 
-    return result;
+std::vector<uint32_t> AppStreamParser::searchSubstring(const std::string_view query, ThreadPool *pool) const {
+    return getSubstringSearch().search(query, pool);
 }
 
-std::vector<std::shared_ptr<Component> > AppStreamParser::searchByKeyword(const std::string &keyword) {
-    std::vector<std::shared_ptr<Component> > result;
+const SubstringSearch &AppStreamParser::getSubstringSearch() const {
+    std::lock_guard lock(substringMutex_);
+    if (!substringSearch_) {
+        auto search = std::make_unique<SubstringSearch>();
+        for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+            const auto component = getComponentAt(ordinal);
+            search->add(component->name, component->summary);
+        }
+        substringSearch_ = std::move(search);
+    }
+    return *substringSearch_;
+}
 
-    for (const auto &[key, component]: components_) {
-        if (std::find(component->keywords.begin(), component->keywords.end(), keyword) != component->keywords.end()) {
-            result.push_back(component);
+std::vector<CompletionIndex::Completion> AppStreamParser::complete(const std::string_view prefix,
+                                                                   const size_t limit) const {
+    return getCompletionIndex().complete(prefix, limit);
+}
+
+const CompletionIndex &AppStreamParser::getCompletionIndex() const {
+    std::lock_guard lock(completionMutex_);
+    if (!completionIndex_) {
+        const auto &relations = getRelations();
+        CompletionIndex::Builder builder;
+        for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+            const auto component = getComponentAt(ordinal);
+            const auto weight = 1 + static_cast<uint32_t>(relations.suggestedBy(static_cast<uint32_t>(ordinal)).size());
+            builder.add(component->name, CompletionIndex::Kind::NAME, static_cast<uint32_t>(ordinal), weight);
+            builder.add(component->id, CompletionIndex::Kind::ID, static_cast<uint32_t>(ordinal), weight);
+        }
+        for (const auto &[term, count]: keywordFacet_.counts()) {
+            builder.add(terms_.term(term), CompletionIndex::Kind::KEYWORD, CompletionIndex::kNoOrdinal, count);
         }
+        completionIndex_ = std::make_unique<CompletionIndex>(builder.build());
     }
+    return *completionIndex_;
+}
 
-    return result;
+const RelationGraph &AppStreamParser::getRelations() const {
+    std::lock_guard lock(relationMutex_);
+    if (!relations_) {
+        auto graph = std::make_unique<RelationGraph>();
+        std::vector<uint32_t> suggests;
+        for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+            const auto component = getComponentAt(ordinal);
+            suggests.clear();
+            for (const auto &id: component->suggests) {
+                if (const auto target = findOrdinal(id)) {
+                    suggests.push_back(static_cast<uint32_t>(*target));
+                }
+            }
+            const auto &developer = component->developer;
+            graph->add(suggests, developer.id.empty() ? developer.name : developer.id, component->project_group);
+        }
+        graph->finish();
+        relations_ = std::move(graph);
+    }
+    return *relations_;
 }
 
-size_t AppStreamParser::getTotalComponentCount() const {
-    return components_.size();
+std::vector<SimilarityIndex::Similar> AppStreamParser::findSimilar(const uint32_t ordinal, const size_t limit) const {
+    return getSimilarity().similar(ordinal, limit);
 }
 
-const std::map<std::string, std::shared_ptr<Component> > &AppStreamParser::getComponents() const {
-    return components_;
+const SimilarityIndex &AppStreamParser::getSimilarity() const {
+    std::lock_guard lock(similarityMutex_);
+    if (!similarity_) {
+        auto index = std::make_unique<SimilarityIndex>();
+        for (uint32_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+            index->add(categoryFacet_.terms(ordinal), keywordFacet_.terms(ordinal));
+        }
+        index->finish();
+        similarity_ = std::move(index);
+    }
+    return *similarity_;
+}
+
+void AppStreamParser::exportCatalog(CatalogExporter &exporter) const {
+    for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+        exportComponent(exporter, *getComponentAt(ordinal));
+    }
+}
+
+void AppStreamParser::exportComponents(CatalogExporter &exporter, const std::vector<uint32_t> &ordinals) const {
+    for (const auto ordinal: ordinals) {
+        exportComponent(exporter, *getComponentAt(ordinal));
+    }
+}
+
+void AppStreamParser::exportComponent(CatalogExporter &exporter, const Component &component) const {
+    exporter.add(component, textStore_.get());
+}
+
+std::vector<uint32_t> AppStreamParser::filterByContentRating(const ContentRating &limit,
+                                                             const bool includeUnrated) const {
+    std::vector<uint32_t> ordinals;
+    ContentRating::filter(contentRatings_.data(), contentRatings_.size(), limit, includeUnrated, ordinals);
+    return ordinals;
+}
+
+size_t AppStreamParser::getSkippedComponentCount() const {
+    return skippedComponents_;
+}
+
+void AppStreamParser::compressDescriptions(Component &component) const {
+    if (!component.description.empty()) {
+        component.descriptionHandle = textStore_->append(component.description);
+        std::string().swap(component.description);
+    }
+}
+
+std::string AppStreamParser::getDescription(const Component &component) const {
+    if (component.descriptionHandle != Component::kNoTextHandle && textStore_) {
+        return textStore_->get(component.descriptionHandle);
+    }
+    return component.description;
+}
+
+std::string AppStreamParser::getReleaseDescription(const ReleaseStore::Release &release) const {
+    if (release.descriptionHandle() != Component::kNoTextHandle && textStore_) {
+        return textStore_->get(release.descriptionHandle());
+    }
+    return std::string(release.description());
+}
+
+ReleaseStore::Releases AppStreamParser::getReleases(const Component &component) {
+    return ReleaseStore::releases(component);
+}
+
+ReleaseStore::Stats AppStreamParser::getReleaseStats() const {
+    return releases_.stats();
+}
+
+TextStore::Stats AppStreamParser::getTextStoreStats() const {
+    return textStore_ ? textStore_->stats() : TextStore::Stats{};
+}
+
+void AppStreamParser::indexComponents(const size_t first, const size_t last) {
+    std::vector<std::string> publishers;
+    for (auto ordinal = first; ordinal < last; ++ordinal) {
+        const auto component = getComponentAt(ordinal);
+        contentRatings_.push_back(component->contentRating.bits());
+        licenses_.add(component->projectLicense);
+        aliases_.add(*component);
+        categoryFacet_.add(component->categories, terms_);
+        keywordFacet_.add(component->keywords, terms_);
+        publishers.clear();
+        for (const auto *publisher: {&component->developer.id, &component->developer.name,
+                                     &component->project_group}) {
+            if (auto key = publisherKey(*publisher); !key.empty()) {
+                publishers.push_back(std::move(key));
+            }
+        }
+        publisherFacet_.add(publishers, terms_);
+    }
+}
+
+void AppStreamParser::finishIndexes() {
+    categoryFacet_.finish(terms_.size());
+    keywordFacet_.finish(terms_.size());
+    publisherFacet_.finish(terms_.size());
+    licenses_.finish();
+    aliases_.finish();
+}
+
+const FacetIndex &AppStreamParser::facetIndex(const Facet facet) const {
+    switch (facet) {
+        case Facet::CATEGORY: return categoryFacet_;
+        case Facet::KEYWORD: return keywordFacet_;
+        case Facet::PUBLISHER: return publisherFacet_;
+    }
+    return categoryFacet_;
+}
+
+const std::vector<FacetCount> &AppStreamParser::getFacetCounts(const Facet facet) const {
+    return facetIndex(facet).counts();
+}
+
+std::vector<FacetCount> AppStreamParser::getFacetCounts(const Facet facet,
+                                                        const std::vector<uint32_t> &ordinals) const {
+    return facetIndex(facet).counts(ordinals);
+}
+
+std::vector<FacetCount> AppStreamParser::getFacetCounts(
+    const Facet facet, const std::vector<std::shared_ptr<Component> > &components) const {
+    std::vector<uint32_t> ordinals;
+    ordinals.reserve(components.size());
+    for (const auto &component: components) {
+        if (const auto ordinal = findOrdinal(component->id)) {
+            ordinals.push_back(static_cast<uint32_t>(*ordinal));
+        }
+    }
+    return facetIndex(facet).counts(ordinals);
+}
+
+IdRange AppStreamParser::findOrdinals(const Facet facet, const std::string_view term) const {
+    const auto id = terms_.find(term);
+    return id ? facetIndex(facet).postings(*id) : IdRange{};
+}
+
+IdRange AppStreamParser::findPublisher(const std::string_view publisher) const {
+    return findOrdinals(Facet::PUBLISHER, publisherKey(publisher));
+}
+
+std::string AppStreamParser::publisherKey(std::string_view publisher) {
+    static constexpr std::string_view kTopLevelDomains[] = {"org", "com", "net", "io", "edu", "gov", "de", "eu", "uk"};
+    static constexpr std::string_view kSuffixes[] = {
+        "project", "team", "developers", "developer", "community", "contributors", "foundation", "inc", "ltd",
+        "llc", "gmbh"
+    };
+    // Bytes of multi-byte UTF-8 sequences count as word characters, so non-Latin names keep a key
+    const auto isWordByte = [](const char c) {
+        const auto byte = static_cast<unsigned char>(c);
+        return byte >= 0x80 || std::isalnum(byte) != 0;
+    };
+    const auto toLower = [](const char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    };
+
+    if (publisher.find_first_of(" \t") == std::string_view::npos && publisher.find('.') != std::string_view::npos) {
+        // Reverse-DNS ID, or a plain domain such as kde.org
+        std::string_view segment;
+        for (std::string_view rest = publisher; !rest.empty();) {
+            const auto dot = rest.find('.');
+            const auto part = rest.substr(0, dot);
+            if (!part.empty() && std::find(std::begin(kTopLevelDomains), std::end(kTopLevelDomains), part) ==
+                std::end(kTopLevelDomains)) {
+                segment = part;
+            }
+            rest = dot == std::string_view::npos ? std::string_view{} : rest.substr(dot + 1);
+        }
+        publisher = segment;
+    }
+
+    std::vector<std::string_view> words;
+    for (size_t i = 0; i < publisher.size();) {
+        while (i < publisher.size() && !isWordByte(publisher[i])) {
+            ++i;
+        }
+        const auto start = i;
+        while (i < publisher.size() && isWordByte(publisher[i])) {
+            ++i;
+        }
+        if (i > start) {
+            words.push_back(publisher.substr(start, i - start));
+        }
+    }
+    const auto is = [&](const std::string_view word, const std::string_view lower) {
+        return word.size() == lower.size() && std::equal(word.begin(), word.end(), lower.begin(), [&](const char a,
+            const char b) {
+                return toLower(a) == b;
+            });
+    };
+    size_t first = words.size() > 1 && is(words.front(), "the") ? 1 : 0;
+    size_t last = words.size();
+    while (last - first > 1 && std::any_of(std::begin(kSuffixes), std::end(kSuffixes), [&](const std::string_view s) {
+        return is(words[last - 1], s);
+    })) {
+        --last;
+    }
+
+    std::string key;
+    for (auto i = first; i < last; ++i) {
+        for (const char c: words[i]) {
+            key.push_back(toLower(c));
+        }
+    }
+    return key;
+}
+
+AppStreamParser::OrdinalRange AppStreamParser::findIdPrefix(const std::string_view prefix) const {
+    const auto lower = std::partition_point(ids_.begin(), ids_.end(), [&](const std::string *id) {
+        return id->compare(0, prefix.size(), prefix) < 0;
+    });
+    const auto upper = std::partition_point(lower, ids_.end(), [&](const std::string *id) {
+        return id->compare(0, prefix.size(), prefix) == 0;
+    });
+    return {static_cast<uint32_t>(lower - ids_.begin()), static_cast<uint32_t>(upper - ids_.begin())};
+}
+
+std::vector<AppStreamParser::IdSegment> AppStreamParser::getIdSegments(const std::string_view prefix) const {
+    std::vector<IdSegment> segments;
+    const auto range = findIdPrefix(prefix);
+    for (auto ordinal = range.first; ordinal < range.last;) {
+        const std::string_view id = *ids_[ordinal];
+        const auto dot = id.find('.', prefix.size());
+        if (dot == std::string_view::npos) {
+            segments.push_back({id, {ordinal, ordinal + 1}});
+            ++ordinal;
+            continue;
+        }
+        const auto segment = id.substr(0, dot + 1);
+        const auto end = std::partition_point(ids_.begin() + ordinal, ids_.begin() + range.last,
+                                              [&](const std::string *other) {
+                                                  return other->compare(0, segment.size(), segment) == 0;
+                                              });
+        const auto last = static_cast<uint32_t>(end - ids_.begin());
+        segments.push_back({segment, {ordinal, last}});
+        ordinal = last;
+    }
+    return segments;
+}
+
+std::string_view AppStreamParser::getTerm(const TermDictionary::TermId term) const {
+    return terms_.term(term);
 }
@@ -17,68 +17,433 @@
 #ifndef APPSTREAMPARSER_H
 #define APPSTREAMPARSER_H
 
+#include "AliasIndex.h"
+#include "AppStreamExport.h"
+#include "CatalogExporter.h"
 #include "Component.h"
+#include "CompletionIndex.h"
+#include "ComponentFilter.h"
+#include "FacetIndex.h"
+#include "IconIndex.h"
+#include "LicenseIndex.h"
+#include "QueryCache.h"
+#include "RelationGraph.h"
+#include "ReleaseStore.h"
+#include "SearchIndex.h"
+#include "SimilarityIndex.h"
+#include "SpillStore.h"
+#include "SubstringSearch.h"
+#include "TermDictionary.h"
+#include "TextStore.h"
 
+#include <chrono>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <libxml/parser.h>
 
 
-class AppStreamParser {
+/**
+ * @brief SAX parser and in-memory catalog of an AppStream collection.
+ *
+ * The catalog is immutable once constructed and all const methods may be
+ * called concurrently. Parse errors are reported by throwing std::runtime_error.
+ */
+class AS_EXPORT AppStreamParser {
 public:
+    struct Options {
+        /// Keep component and release descriptions deflated in blocks of several components.
+        /// Description fields are then left empty; read them through getDescription().
+        bool compressDescriptions = false;
+        size_t textBlockSize = 16 * 1024;
+        size_t textCacheBlocks = 8;
+
+        /// When non-zero, caps materialized components together with the ID map, ordinal tables and
+        /// the release, text, term, facet, license, alias and content rating stores; the least recently
+        /// used components are spilled to a file in spillDirectory and reloaded on access. Indexes that
+        /// queries build on first use and the XML parser are not counted, so this does not bound RSS.
+        size_t memoryBudget = 0;
+        /// Defaults to the system temporary directory.
+        std::string spillDirectory;
+
+        /// Components rejected by the filter are skipped while parsing and never stored.
+        ComponentFilter filter;
+
+        /// Field weights and BM25 parameters of search().
+        SearchIndex::Params search;
+
+        /// Byte budget of the query result cache; 0 disables it. With a memory budget the cache is
+        /// off, since cached results would keep spilled components resident.
+        size_t queryCacheBytes = 4 * 1024 * 1024;
+
+        /// When set, each accepted component is handed to sink as soon as it is complete and then
+        /// dropped, so the catalog stays empty and memory does not grow with the input. Its releases
+        /// are only valid during the call. Duplicate IDs are passed on as they are; descriptions
+        /// are never compressed and the memory budget is ignored. Used by DiskCatalog::build().
+        std::function<void(const Component &)> sink;
+    };
+
+    /// Selects the constructor that leaves parsing to parseStep().
+    struct Deferred {
+    };
+
+    /// Work allowed per parseStep() call; zero means unlimited.
+    struct ParseBudget {
+        std::chrono::steady_clock::duration time{};
+        size_t bytes = 0;
+    };
+
+    struct ParseProgress {
+        size_t bytesParsed = 0;
+        size_t totalBytes = 0;
+        /// Components stored so far, or handed to Options::sink.
+        size_t components = 0;
+        /// All bytes are parsed and the catalog is indexed and ready for use.
+        bool done = false;
+        bool cancelled = false;
+
+        [[nodiscard]] double fraction() const {
+            return totalBytes ? static_cast<double>(bytesParsed) / static_cast<double>(totalBytes) : 1.0;
+        }
+    };
+
     explicit AppStreamParser(const std::string &filename, const std::string &language);
 
+    AppStreamParser(const std::string &filename, const std::string &language, const Options &options);
+
+    /**
+     * @brief Opens a catalog for parsing in slices, for single-threaded event loops.
+     *
+     * Nothing is parsed until parseStep() is called. The catalog must not be
+     * queried before parseStep() reports done.
+     */
+    AppStreamParser(const std::string &filename, const std::string &language, const Options &options, Deferred);
+
+    /**
+     * @brief Parses until the budget is used up or the catalog is complete.
+     *
+     * The budget is checked after each 1 KiB chunk, and the indexes are then
+     * built in slices of components under the same budget, so a step
+     * overshoots by at most one chunk or slice. Every call makes progress.
+     * Throws std::runtime_error on malformed XML.
+     */
+    ParseProgress parseStep(const ParseBudget &budget);
+
+    /**
+     * @brief Abandons a parse started with Deferred.
+     *
+     * The XML context, the mapping and every store and index built so far are freed, and the
+     * catalog is empty. Components obtained before the call must not be used afterwards.
+     */
+    void cancelParse();
+
+    [[nodiscard]] ParseProgress getParseProgress() const;
+
     ~AppStreamParser();
 
-    std::vector<std::string> getUniqueCategories();
+    [[nodiscard]] std::vector<std::string> getUniqueCategories() const;
 
-    std::vector<std::string> getUniqueKeywords();
+    [[nodiscard]] std::vector<std::string> getUniqueKeywords() const;
 
-    std::vector<std::shared_ptr<Component> > searchByCategory(const std::string &category);
+    /**
+     * @brief Components carrying a category.
+     *
+     * The result holds every matching component at once, so with
+     * Options::memoryBudget it is not bounded by the budget; use findOrdinals()
+     * and getComponentAt() there instead. The same applies to searchByKeyword()
+     * and getSortedComponents().
+     */
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > searchByCategory(const std::string &category) const;
 
-    std::vector<std::shared_ptr<Component> > searchByKeyword(const std::string &keyword);
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > searchByKeyword(const std::string &keyword) const;
 
     enum class SortOption { BY_ID, BY_NAME };
 
-    std::vector<std::shared_ptr<Component> > getSortedComponents(SortOption option);
+    /// PUBLISHER terms are publisher keys, see publisherKey().
+    enum class Facet { CATEGORY, KEYWORD, PUBLISHER };
+
+    /// Ordinals [first, last) of components adjacent in ID order.
+    struct OrdinalRange {
+        uint32_t first = 0;
+        uint32_t last = 0;
+
+        [[nodiscard]] size_t size() const { return last - first; }
+        [[nodiscard]] bool empty() const { return first == last; }
+    };
+
+    /// A reverse-DNS ID prefix ending at a segment boundary, e.g. "org.kde.", and the components under it.
+    struct IdSegment {
+        std::string_view prefix;
+        OrdinalRange ordinals;
+    };
+
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > getSortedComponents(SortOption option) const;
+
+    /// Ordinals in the given order; with a memory budget, components are loaded one at a time to sort by name.
+    [[nodiscard]] std::vector<uint32_t> getSortedOrdinals(SortOption option) const;
+
+    /// Cached, shared result of searchByCategory(); the vector is never modified.
+    [[nodiscard]] QueryCache::Result findByCategory(std::string_view category) const;
+
+    /// Cached, shared result of searchByKeyword().
+    [[nodiscard]] QueryCache::Result findByKeyword(std::string_view keyword) const;
+
+    /// Cached, shared result of getSortedComponents().
+    [[nodiscard]] QueryCache::Result findSorted(SortOption option) const;
+
+    /// Hit rate and compute time saved by the query result cache.
+    [[nodiscard]] QueryCache::Stats getQueryCacheStats() const;
 
     [[nodiscard]] size_t getTotalComponentCount() const;
 
+    /// Components by ID. With a memory budget the values are null; use getComponentAt() or findComponent().
     [[nodiscard]] const std::map<std::string, std::shared_ptr<Component> > &getComponents() const;
 
+    /// Component at the given ordinal; ordinals follow ID order and are stable for the parser lifetime.
+    [[nodiscard]] std::shared_ptr<Component> getComponentAt(size_t ordinal) const;
+
+    [[nodiscard]] std::shared_ptr<Component> findComponent(const std::string &id) const;
+
+    /// Ordinal of the component with the given ID, or std::nullopt.
+    [[nodiscard]] std::optional<size_t> findOrdinal(std::string_view id) const;
+
+    /// Number of components per category or keyword over the whole catalog, most frequent first.
+    [[nodiscard]] const std::vector<FacetCount> &getFacetCounts(Facet facet) const;
+
+    /// Facet counts restricted to a result set given as ordinals.
+    [[nodiscard]] std::vector<FacetCount> getFacetCounts(Facet facet, const std::vector<uint32_t> &ordinals) const;
+
+    [[nodiscard]] std::vector<FacetCount> getFacetCounts(
+        Facet facet, const std::vector<std::shared_ptr<Component> > &components) const;
+
+    /// Ordinals of the components carrying a category or keyword, ascending.
+    [[nodiscard]] IdRange findOrdinals(Facet facet, std::string_view term) const;
+
+    /**
+     * @brief Components published by a developer ID, developer name or project group, ascending.
+     *
+     * "GNOME", "The GNOME Project" and "org.gnome" all find the same components;
+     * see publisherKey().
+     */
+    [[nodiscard]] IdRange findPublisher(std::string_view publisher) const;
+
+    /**
+     * @brief Publisher key of a developer ID, developer name or project group.
+     *
+     * A reverse-DNS ID stands for its last segment that is not a top-level domain.
+     * Names are reduced to their letters and digits with ASCII case folded, dropping a
+     * leading "the" and trailing words such as "project", "team" or "developers".
+     * Non-ASCII characters are kept byte for byte.
+     */
+    static std::string publisherKey(std::string_view publisher);
+
+    /// Components whose ID starts with prefix, found by two binary searches. End prefix with
+    /// a dot ("org.kde.") to leave out siblings such as org.kdenlive.
+    [[nodiscard]] OrdinalRange findIdPrefix(std::string_view prefix) const;
+
+    /**
+     * @brief The next reverse-DNS segments below prefix with their components, in ID order.
+     *
+     * Below "org." this lists "org.gnome.", "org.kde." and so on. An ID ending right
+     * after prefix is its own segment. Runs in time proportional to the number of
+     * segments, jumping over each segment's components by binary search.
+     */
+    [[nodiscard]] std::vector<IdSegment> getIdSegments(std::string_view prefix) const;
+
+    /// Text of an interned facet term.
+    [[nodiscard]] std::string_view getTerm(TermDictionary::TermId term) const;
+
+    /// Components matching any word of query, ranked by BM25 relevance, best first.
+    [[nodiscard]] std::vector<SearchIndex::Hit> search(std::string_view query, size_t limit = 20) const;
+
+    /// The full-text index behind search(); built on first use.
+    const SearchIndex &getSearchIndex() const;
+
+    /**
+     * @brief Ordinals of the components whose name or summary contains query, ignoring case, ascending.
+     *
+     * Finds partial words that search() misses, by scanning all names and
+     * summaries; see SubstringSearch. A pool splits the scan across its workers.
+     */
+    [[nodiscard]] std::vector<uint32_t> searchSubstring(std::string_view query, ThreadPool *pool = nullptr) const;
+
+    /// The text buffer behind searchSubstring(); built on first use.
+    const SubstringSearch &getSubstringSearch() const;
+
+    /// Completions of a typed prefix from component names, IDs and keywords, best first.
+    [[nodiscard]] std::vector<CompletionIndex::Completion> complete(std::string_view prefix, size_t limit = 8) const;
+
+    /**
+     * @brief The autocomplete index behind complete(); built on first use.
+     *
+     * Names and IDs are weighted by how many components suggest them, keywords
+     * by how many components carry them.
+     */
+    const CompletionIndex &getCompletionIndex() const;
+
+    /// Suggests, same-developer and same-project-group relations by ordinal; built on first use.
+    const RelationGraph &getRelations() const;
+
+    /// Components sharing the most categories and keywords with ordinal, best first; approximate, see SimilarityIndex.
+    [[nodiscard]] std::vector<SimilarityIndex::Similar> findSimilar(uint32_t ordinal, size_t limit = 10) const;
+
+    /// MinHash signatures and LSH buckets behind findSimilar(); built on first use.
+    const SimilarityIndex &getSimilarity() const;
+
+    /// Writes every component to exporter in ordinal order, with descriptions inflated.
+    void exportCatalog(CatalogExporter &exporter) const;
+
+    /// Writes the components at the given ordinals, e.g. a query result.
+    void exportComponents(CatalogExporter &exporter, const std::vector<uint32_t> &ordinals) const;
+
+    /**
+     * @brief Ordinals of the components whose OARS rating stays within limit, ascending.
+     *
+     * Evaluated in one pass over the packed per-ordinal ratings. Components
+     * without a <content_rating> only pass when includeUnrated is set.
+     */
+    [[nodiscard]] std::vector<uint32_t> filterByContentRating(const ContentRating &limit,
+                                                              bool includeUnrated = false) const;
+
+    /// Packed OARS rating per ordinal.
+    [[nodiscard]] const std::vector<uint64_t> &getContentRatings() const { return contentRatings_; }
+
+    /// Components by desktop ID, package name, source package name and bundle ID.
+    [[nodiscard]] const AliasIndex &getAliases() const { return aliases_; }
+
+    /// Compiled <project_license> expressions per ordinal, for license filters and audits.
+    [[nodiscard]] const LicenseIndex &getLicenses() const { return licenses_; }
+
+    /// Number of components rejected by Options::filter.
+    [[nodiscard]] size_t getSkippedComponentCount() const;
+
+    /// Spill statistics; all zero unless Options::memoryBudget is set.
+    [[nodiscard]] SpillStore::Stats getMemoryStats() const;
+
+    /**
+     * @brief Returns the best icon per component for a rendering policy.
+     *
+     * The selection is computed on first use and cached per policy, so subsequent
+     * calls for the same policy are a lookup.
+     */
+    const IconIndex &getBestIcons(const IconPolicy &policy) const;
+
+    /// Directory cached icons are resolved under; defaults to "icons" next to the catalog file.
+    void setIconsDirectory(const std::string &directory);
+
+    [[nodiscard]] const std::string &getIconsDirectory() const;
+
+    /// Component description, inflated from the text store when descriptions are compressed.
+    [[nodiscard]] std::string getDescription(const Component &component) const;
+
+    [[nodiscard]] std::string getReleaseDescription(const ReleaseStore::Release &release) const;
+
+    /// Releases of a component, read from the catalog-wide ReleaseStore; valid only while the parser is alive.
+    [[nodiscard]] static ReleaseStore::Releases getReleases(const Component &component);
+
+    /// Record counts and heap bytes of the release store.
+    [[nodiscard]] ReleaseStore::Stats getReleaseStats() const;
+
+    /// Text store statistics; all zero unless Options::compressDescriptions is set.
+    [[nodiscard]] TextStore::Stats getTextStoreStats() const;
+
 private:
     static constexpr char kEmptyString[] = "";
     static constexpr char kReleaseTypeStable[] = "stable";
     static constexpr char kReleaseUrgencyMedium[] = "medium";
     static constexpr char kIssueTypeGeneric[] = "generic";
+    static constexpr char kIconsDirectoryName[] = "icons";
 
     std::map<std::string, std::shared_ptr<Component> > components_;
+    std::vector<std::shared_ptr<Component> > ordered_;
+    std::vector<const std::string *> ids_;
     std::string language_;
+    std::string iconsDirectory_;
+    TermDictionary terms_;
+    FacetIndex categoryFacet_;
+    FacetIndex keywordFacet_;
+    FacetIndex publisherFacet_;
+    ReleaseStore releases_;
+    std::vector<uint64_t> contentRatings_;
+    LicenseIndex licenses_;
+    AliasIndex aliases_;
+    mutable std::vector<std::unique_ptr<IconIndex> > iconIndexes_;
+    mutable std::mutex iconMutex_;
+    mutable std::unique_ptr<SearchIndex> searchIndex_;
+    mutable std::mutex searchMutex_;
+    mutable std::unique_ptr<SubstringSearch> substringSearch_;
+    mutable std::mutex substringMutex_;
+    mutable std::unique_ptr<CompletionIndex> completionIndex_;
+    mutable std::mutex completionMutex_;
+    mutable std::unique_ptr<RelationGraph> relations_;
+    mutable std::mutex relationMutex_;
+    mutable std::unique_ptr<SimilarityIndex> similarity_;
+    mutable std::mutex similarityMutex_;
+    mutable QueryCache queryCache_;
+    Options options_;
+    std::unique_ptr<TextStore> textStore_;
+    std::unique_ptr<SpillStore> spillStore_;
+    // Spill slot per ordinal, and per ID while parsing
+    std::vector<uint32_t> slots_;
+    std::unordered_map<std::string_view, uint32_t> pendingSlots_;
+    // Heap bytes of the ID map under a memory budget
+    size_t idBytes_ = 0;
+    size_t skippedComponents_ = 0;
 
     struct ParsingState {
         bool insideComponent = false;
         bool insideReleases = false;
+        bool insideRelease = false;
         bool insideIssues = false;
-        bool insideArtifact = true;
+        bool insideArtifact = false;
         bool currentDeveloper = false;
+        bool insideDescription = false;
+        bool skipDescription = false;
+        bool skipComponent = false;
+        bool insideSuggests = false;
+        // Character data is kept for the innermost open element only
+        bool collectText = false;
+        // Element depth, the depth of the open <component>, and the depth of an
+        // element being skipped for its xml:lang
+        int depth = 0;
+        int componentDepth = 0;
+        int skipLanguageDepth = 0;
 
         std::shared_ptr<Component> currentComponent;
-        std::string currentElement;
         std::string currentData;
+        std::string descriptionMarkup;
 
         Component::Icon currentIcon;
         Component::UrlType urlType;
         Component::LaunchableType launchableType;
-        Component::Release currentRelease;
-        Component::Issue currentIssue;
-        Component::Artifact currentArtifact;
+        Component::IssueType currentIssueType = Component::IssueType::UNKNOWN;
+        std::string currentIssueUrl;
+        std::string contentAttribute;
+        // Release and text store positions at the start of the current component
+        ReleaseStore::Mark releaseMark;
+        TextStore::Mark textMark;
 
         std::string currentArtifactChecksumKey;
         std::string currentArtifactSizeKey;
         std::string language;
+
+        // Where a parse started with Deferred stands between parseStep() calls
+        enum class Phase { PARSING, COMPACTING, ORDERING, INDEXING, DONE, CANCELLED };
+        Phase phase = Phase::PARSING;
+        std::string filename;
+        std::unique_ptr<xmlParserCtxt, decltype(&xmlFreeParserCtxt)> context{nullptr, xmlFreeParserCtxt};
+        // Bytes fed to the push parser, and bytes of the mapping already returned to the kernel
+        size_t offset = 0;
+        size_t released = 0;
+        size_t sunkComponents = 0;
+        size_t indexedOrdinals = 0;
     };
 
     ParsingState state_;
@@ -92,11 +457,45 @@ private:
     size_t fileSize_ = 0;
     void *fileData_ = nullptr;
 
-    void parseFile(const std::string &filename);
+    /// Feeds the next chunk to the push parser, or the end of input once all bytes are in.
+    void parseChunk();
 
     void mmapFile(const std::string &filename);
 
     void munmapFile();
+
+    void buildOrdinals();
+
+    /// Adds the components at ordinals [first, last) to the load-time indexes.
+    void indexComponents(size_t first, size_t last);
+
+    void finishIndexes();
+
+    [[nodiscard]] const FacetIndex &facetIndex(Facet facet) const;
+
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > componentsAt(IdRange ordinals) const;
+
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > sortedComponents(SortOption option) const;
+
+    void compressDescriptions(Component &component) const;
+
+    /// Returns false for a duplicate ID, which is dropped.
+    bool addComponent(std::shared_ptr<Component> component);
+
+    /// Counts the ID map, ordinal tables and every catalog-wide store and index against the memory budget.
+    void updateMemoryOverhead();
+
+    bool acceptComponent(ComponentFilter::Stage stage);
+
+    void exportComponent(CatalogExporter &exporter, const Component &component) const;
+
+    void resetComponentState();
+
+    /// Frees the components and every store and index built from them.
+    void clearCatalog();
+
+    /// Drops the releases and texts stored for the current component.
+    void rollbackComponent();
 };
 
 #endif // APPSTREAMPARSER_H
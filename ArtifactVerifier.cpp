@@ -0,0 +1,222 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ArtifactVerifier.h"
+#include "AppStreamParser.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+struct Job {
+    std::string componentId;
+    ReleaseStore::Artifact artifact;
+};
+
+struct DigestDeleter {
+    void operator()(EVP_MD_CTX *context) const { EVP_MD_CTX_free(context); }
+};
+
+const EVP_MD *digestFor(const ReleaseStore::ChecksumType type) {
+    switch (type) {
+        case ReleaseStore::ChecksumType::SHA1: return EVP_sha1();
+        case ReleaseStore::ChecksumType::SHA256: return EVP_sha256();
+        case ReleaseStore::ChecksumType::SHA512: return EVP_sha512();
+        case ReleaseStore::ChecksumType::BLAKE2B: return EVP_blake2b512();
+        case ReleaseStore::ChecksumType::BLAKE2S: return EVP_blake2s256();
+    }
+    return nullptr;
+}
+}
+
+ArtifactVerifier::ArtifactVerifier(Options options) : options_(std::move(options)) {
+}
+
+const char *ArtifactVerifier::statusToString(const Status status) {
+    switch (status) {
+        case Status::OK: return "ok";
+        case Status::MISSING: return "missing";
+        case Status::SIZE_MISMATCH: return "size-mismatch";
+        case Status::CHECKSUM_MISMATCH: return "checksum-mismatch";
+        case Status::NO_CHECKSUM: return "no-checksum";
+        default: return "error";
+    }
+}
+
+std::string ArtifactVerifier::localPath(const std::string &location) const {
+    std::string_view rest = location;
+    if (const auto scheme = rest.find("://"); scheme != std::string_view::npos) {
+        rest.remove_prefix(scheme + 3);
+        if (!options_.keepHost) {
+            const auto slash = rest.find('/');
+            rest.remove_prefix(slash == std::string_view::npos ? rest.size() : slash);
+        }
+    }
+    rest = rest.substr(0, rest.find_first_of("?#"));
+    while (!rest.empty() && rest.front() == '/') {
+        rest.remove_prefix(1);
+    }
+    if (rest.empty()) {
+        return {};
+    }
+    // Refuse anything that could resolve outside the mirror
+    for (size_t start = 0; start <= rest.size();) {
+        const auto end = std::min(rest.find('/', start), rest.size());
+        if (rest.substr(start, end - start) == "..") {
+            return {};
+        }
+        start = end + 1;
+    }
+    return options_.mirrorRoot + "/" + std::string(rest);
+}
+
+ArtifactVerifier::Report ArtifactVerifier::verify(const AppStreamParser &parser) const {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Job> jobs;
+    for (size_t ordinal = 0; ordinal < parser.getTotalComponentCount(); ++ordinal) {
+        const auto component = parser.getComponentAt(ordinal);
+        for (const auto release: AppStreamParser::getReleases(*component)) {
+            for (size_t i = 0; i < release.artifactCount(); ++i) {
+                jobs.push_back({component->id, release.artifact(i)});
+            }
+        }
+    }
+
+    std::vector<Result> results(jobs.size());
+    std::atomic<size_t> bytesHashed{0};
+    ThreadPool pool(options_.threads);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        pool.submit([this, &job = jobs[i], &result = results[i], &bytesHashed] {
+            result.componentId = job.componentId;
+            const auto &artifact = job.artifact;
+            result.location = artifact.location();
+            result.path = localPath(result.location);
+            if (result.path.empty()) {
+                result.status = Status::ERROR;
+                result.detail = "location cannot be mapped to the mirror";
+                return;
+            }
+
+            struct stat info{};
+            if (stat(result.path.c_str(), &info) != 0) {
+                result.status = Status::MISSING;
+                return;
+            }
+            if (const auto size = artifact.size(ReleaseStore::SizeKind::DOWNLOAD);
+                size != ReleaseStore::kNoSize && static_cast<uint64_t>(info.st_size) != size) {
+                result.status = Status::SIZE_MISMATCH;
+                result.detail = std::to_string(info.st_size) + " != " + std::to_string(size);
+                return;
+            }
+
+            std::vector<std::pair<ReleaseStore::Checksum, std::unique_ptr<EVP_MD_CTX, DigestDeleter> > > digests;
+            for (size_t i = 0; i < artifact.checksumCount(); ++i) {
+                const auto checksum = artifact.checksum(i);
+                std::unique_ptr<EVP_MD_CTX, DigestDeleter> context(EVP_MD_CTX_new());
+                if (!context || EVP_DigestInit_ex(context.get(), digestFor(checksum.type), nullptr) != 1) {
+                    result.status = Status::ERROR;
+                    result.detail = "cannot initialize ";
+                    result.detail += ReleaseStore::checksumTypeToString(checksum.type);
+                    return;
+                }
+                digests.emplace_back(checksum, std::move(context));
+            }
+            if (digests.empty()) {
+                result.status = Status::NO_CHECKSUM;
+                return;
+            }
+
+            const int fd = open(result.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                result.status = Status::ERROR;
+                result.detail = std::strerror(errno);
+                return;
+            }
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            // One buffer per task; tasks run one at a time per worker
+            thread_local std::vector<unsigned char> buffer;
+            buffer.resize(options_.readBlockSize);
+            size_t total = 0;
+            for (;;) {
+                const auto n = read(fd, buffer.data(), buffer.size());
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0) {
+                    result.status = Status::ERROR;
+                    result.detail = std::strerror(errno);
+                    close(fd);
+                    return;
+                }
+                if (n == 0) {
+                    break;
+                }
+                for (const auto &[checksum, context]: digests) {
+                    if (EVP_DigestUpdate(context.get(), buffer.data(), static_cast<size_t>(n)) != 1) {
+                        result.status = Status::ERROR;
+                        result.detail = "cannot update ";
+                        result.detail += ReleaseStore::checksumTypeToString(checksum.type);
+                        close(fd);
+                        return;
+                    }
+                }
+                total += static_cast<size_t>(n);
+            }
+            close(fd);
+            bytesHashed.fetch_add(total, std::memory_order_relaxed);
+
+            for (const auto &[expected, context]: digests) {
+                unsigned char digest[EVP_MAX_MD_SIZE];
+                unsigned int length = 0;
+                if (EVP_DigestFinal_ex(context.get(), digest, &length) != 1) {
+                    result.status = Status::ERROR;
+                    result.detail = "cannot finalize ";
+                    result.detail += ReleaseStore::checksumTypeToString(expected.type);
+                    return;
+                }
+                if (length != expected.length || std::memcmp(digest, expected.digest, length) != 0) {
+                    result.status = Status::CHECKSUM_MISMATCH;
+                    result.detail = ReleaseStore::checksumTypeToString(expected.type);
+                    return;
+                }
+            }
+        });
+    }
+    pool.wait();
+
+    Report report;
+    report.artifacts = jobs.size();
+    report.bytesHashed = bytesHashed.load();
+    report.steals = pool.steals();
+    for (auto &result: results) {
+        if (result.status == Status::OK) {
+            ++report.verified;
+        } else {
+            report.failures.push_back(std::move(result));
+        }
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
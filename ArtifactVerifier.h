@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ARTIFACTVERIFIER_H
+#define ARTIFACTVERIFIER_H
+
+#include "AppStreamExport.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AppStreamParser;
+
+
+/**
+ * @brief Verifies release artifacts against a local mirror.
+ *
+ * Each artifact location is mapped below the mirror root (by default as
+ * host/path, the layout of wget -x). The file size is compared with the
+ * "download" size first; only files of the right size are read, once, in
+ * large sequential blocks that feed every listed checksum at the same time.
+ * Files are hashed in parallel on a work-stealing ThreadPool.
+ *
+ * Digests are compared in binary form as held by the ReleaseStore.
+ */
+class AS_EXPORT ArtifactVerifier {
+public:
+    struct Options {
+        std::string mirrorRoot;
+        /// Keep the URL host as the first path component below mirrorRoot.
+        bool keepHost = true;
+        /// 0 uses the number of hardware threads.
+        size_t threads = 0;
+        size_t readBlockSize = 1 << 20;
+    };
+
+    enum class Status { OK, MISSING, SIZE_MISMATCH, CHECKSUM_MISMATCH, NO_CHECKSUM, ERROR };
+
+    struct Result {
+        std::string componentId;
+        std::string location;
+        std::string path;
+        Status status = Status::OK;
+        /// Mismatching checksum type, or the error message.
+        std::string detail;
+    };
+
+    struct Report {
+        size_t artifacts = 0;
+        size_t verified = 0;
+        size_t bytesHashed = 0;
+        double seconds = 0;
+        size_t steals = 0;
+        /// Every artifact that did not verify, in catalog order.
+        std::vector<Result> failures;
+    };
+
+    explicit ArtifactVerifier(Options options);
+
+    [[nodiscard]] Report verify(const AppStreamParser &parser) const;
+
+    /// Local path of a location, or an empty string when it cannot be mapped safely.
+    [[nodiscard]] std::string localPath(const std::string &location) const;
+
+    static const char *statusToString(Status status);
+
+private:
+    Options options_;
+};
+
+#endif // ARTIFACTVERIFIER_H
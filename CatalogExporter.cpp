@@ -0,0 +1,488 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CatalogExporter.h"
+#include "ComponentCodec.h"
+#include "ReleaseStore.h"
+#include "TextStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+constexpr char kBinaryMagic[] = {'A', 'S', 'C', '2'};
+constexpr size_t kMinBuffer = 64 * 1024;
+// Worst case growth of escaped text: a control byte becomes \u00XX
+constexpr size_t kMaxEscape = 6;
+
+/// Length of the prefix of text (up to 16 bytes per step) that needs no escaping.
+size_t plainPrefix(const char *text, const size_t length, char *out) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= length; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        // v <= 0x1f unsigned, as max(v, 0x1f) == 0x1f
+        const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, control), control),
+                                             _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                          _mm_cmpeq_epi8(v, backslash)));
+        if (const int mask = _mm_movemask_epi8(special)) {
+            const auto plain = static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+            std::memcpy(out + i, text + i, plain);
+            return i + plain;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    for (; i + 16 <= length; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(text + i));
+        const uint8x16_t special = vorrq_u8(vcltq_u8(v, space), vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)));
+        // Narrow each byte of the mask to a nibble to locate the first match
+        const uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+        if (bits) {
+            const auto plain = static_cast<size_t>(__builtin_ctzll(bits) >> 2);
+            std::memcpy(out + i, text + i, plain);
+            return i + plain;
+        }
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + i), v);
+    }
+#endif
+    for (; i < length; ++i) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (c < 0x20 || c == '"' || c == '\\') {
+            break;
+        }
+        out[i] = static_cast<char>(c);
+    }
+    return i;
+}
+
+/// Escapes text into out, which has room for kMaxEscape bytes per input byte; returns the bytes written.
+size_t escape(const char *text, const size_t length, char *out) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    size_t o = 0;
+    for (size_t i = 0; i < length;) {
+        const size_t plain = plainPrefix(text + i, length - i, out + o);
+        i += plain;
+        o += plain;
+        if (i == length) {
+            break;
+        }
+        const auto c = static_cast<unsigned char>(text[i++]);
+        out[o++] = '\\';
+        switch (c) {
+            case '"': out[o++] = '"';
+                break;
+            case '\\': out[o++] = '\\';
+                break;
+            case '\n': out[o++] = 'n';
+                break;
+            case '\t': out[o++] = 't';
+                break;
+            case '\r': out[o++] = 'r';
+                break;
+            default:
+                out[o++] = 'u';
+                out[o++] = '0';
+                out[o++] = '0';
+                out[o++] = kHex[c >> 4];
+                out[o++] = kHex[c & 0xf];
+                break;
+        }
+    }
+    return o;
+}
+}
+
+CatalogExporter::CatalogExporter(const int fd, const Format format, const size_t bufferSize)
+    : fd_(fd), format_(format), capacity_(std::max(bufferSize, kMinBuffer)) {
+    buffer_ = std::make_unique<char[]>(capacity_);
+    if (format_ == Format::JSON) {
+        appendChar('[');
+    } else {
+        append({kBinaryMagic, sizeof(kBinaryMagic)});
+    }
+}
+
+CatalogExporter::~CatalogExporter() {
+    if (!finished_) {
+        try {
+            finish();
+        } catch (const std::exception &) {
+            // Reported by finish() when called explicitly
+        }
+    }
+}
+
+void CatalogExporter::escapeJson(const std::string_view text, std::string &out) {
+    const auto start = out.size();
+    out.resize(start + text.size() * kMaxEscape);
+    out.resize(start + escape(text.data(), text.size(), out.data() + start));
+}
+
+void CatalogExporter::flush() {
+    size_t done = 0;
+    while (done < size_) {
+        const auto n = ::write(fd_, buffer_.get() + done, size_ - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("CatalogExporter: write failed: ") + std::strerror(errno));
+        }
+        done += static_cast<size_t>(n);
+    }
+    flushed_ += size_;
+    size_ = 0;
+}
+
+void CatalogExporter::reserve(const size_t bytes) {
+    if (size_ + bytes > capacity_) {
+        flush();
+    }
+}
+
+void CatalogExporter::append(std::string_view bytes) {
+    while (!bytes.empty()) {
+        if (size_ == capacity_) {
+            flush();
+        }
+        const auto n = std::min(bytes.size(), capacity_ - size_);
+        std::memcpy(buffer_.get() + size_, bytes.data(), n);
+        size_ += n;
+        bytes.remove_prefix(n);
+    }
+}
+
+void CatalogExporter::appendChar(const char c) {
+    if (size_ == capacity_) {
+        flush();
+    }
+    buffer_[size_++] = c;
+}
+
+void CatalogExporter::string(std::string_view text) {
+    appendChar('"');
+    // Chunks small enough that their worst-case escape fits in the buffer
+    const size_t chunk = capacity_ / kMaxEscape - 1;
+    while (!text.empty()) {
+        const auto n = std::min(text.size(), chunk);
+        reserve(n * kMaxEscape);
+        size_ += escape(text.data(), n, buffer_.get() + size_);
+        text.remove_prefix(n);
+    }
+    appendChar('"');
+}
+
+void CatalogExporter::key(const std::string_view name) {
+    if (comma_) {
+        appendChar(',');
+    }
+    comma_ = true;
+    string(name);
+    appendChar(':');
+}
+
+void CatalogExporter::field(const std::string_view name, const std::string_view value) {
+    if (!value.empty()) {
+        key(name);
+        string(value);
+    }
+}
+
+void CatalogExporter::hex(const ReleaseStore::Checksum &checksum) {
+    reserve(2 * checksum.length + 2);
+    buffer_[size_++] = '"';
+    size_ = static_cast<size_t>(checksum.hex(buffer_.get() + size_) - buffer_.get());
+    buffer_[size_++] = '"';
+}
+
+void CatalogExporter::number(const uint64_t value) {
+    reserve(20);
+    const auto result = std::to_chars(buffer_.get() + size_, buffer_.get() + capacity_, value);
+    size_ = static_cast<size_t>(result.ptr - buffer_.get());
+}
+
+void CatalogExporter::list(const std::string_view name, const std::vector<std::string> &values) {
+    if (values.empty()) {
+        return;
+    }
+    key(name);
+    appendChar('[');
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i) {
+            appendChar(',');
+        }
+        string(values[i]);
+    }
+    appendChar(']');
+}
+
+void CatalogExporter::beginObject(const std::string_view name) {
+    if (!name.empty()) {
+        key(name);
+    }
+    appendChar('{');
+    comma_ = false;
+}
+
+void CatalogExporter::endObject() {
+    appendChar('}');
+    comma_ = true;
+}
+
+void CatalogExporter::add(const Component &component, const TextStore *text) {
+    text_ = text;
+    if (format_ == Format::BINARY) {
+        record_.clear();
+        if (text && component.descriptionHandle != Component::kNoTextHandle) {
+            text->get(component.descriptionHandle, description_);
+            ComponentCodec::encode(component, record_, description_);
+        } else {
+            ComponentCodec::encode(component, record_);
+        }
+        ComponentCodec::encodeReleases(component, record_, text, &description_);
+        char prefix[10];
+        size_t n = 0;
+        for (auto length = record_.size(); ; length >>= 7) {
+            prefix[n++] = static_cast<char>(length >= 0x80 ? (length & 0x7f) | 0x80 : length);
+            if (length < 0x80) {
+                break;
+            }
+        }
+        append({prefix, n});
+        append(record_);
+    } else {
+        append(count_ ? ",\n" : "\n");
+        writeJson(component);
+    }
+    ++count_;
+}
+
+void CatalogExporter::writeJson(const Component &c) {
+    beginObject({});
+    field("id", c.id);
+    field("type", Component::componentTypeToString(c.type));
+    field("name", c.name);
+    field("summary", c.summary);
+    if (text_ && c.descriptionHandle != Component::kNoTextHandle) {
+        text_->get(c.descriptionHandle, description_);
+        field("description", description_);
+    } else {
+        field("description", c.description);
+    }
+    field("project_license", c.projectLicense);
+    field("pkgname", c.pkgname);
+    field("source_pkgname", c.source_pkgname);
+    field("project_group", c.project_group);
+    if (!c.developer.id.empty() || !c.developer.name.empty()) {
+        beginObject("developer");
+        field("id", c.developer.id);
+        field("name", c.developer.name);
+        endObject();
+    }
+
+    const std::pair<std::string_view, const std::string *> urls[] = {
+        {"homepage", &c.url.homepage}, {"bugtracker", &c.url.bugtracker}, {"faq", &c.url.faq},
+        {"help", &c.url.help}, {"donation", &c.url.donation}, {"translate", &c.url.translate},
+        {"contact", &c.url.contact}, {"vcs-browser", &c.url.vcs_browser}, {"contribute", &c.url.contribute},
+        {"unknown", &c.url.unknown}
+    };
+    if (std::any_of(std::begin(urls), std::end(urls), [](const auto &url) { return !url.second->empty(); })) {
+        beginObject("urls");
+        for (const auto &[name, value]: urls) {
+            field(name, *value);
+        }
+        endObject();
+    }
+
+    if (!c.launchable.desktop_id.empty() || !c.launchable.service.empty() ||
+        !c.launchable.cockpit_manifest.empty() || !c.launchable.url.empty()) {
+        beginObject("launchable");
+        field("desktop-id", c.launchable.desktop_id);
+        field("service", c.launchable.service);
+        field("cockpit-manifest", c.launchable.cockpit_manifest);
+        field("url", c.launchable.url);
+        endObject();
+    }
+    if (!c.bundle.id.empty()) {
+        beginObject("bundle");
+        field("type", Component::bundleTypeToString(c.bundle.type));
+        field("id", c.bundle.id);
+        endObject();
+    }
+    field("architecture", c.architecture);
+    field("media_baseurl", c.media_baseurl);
+    field("content_rating", c.content_rating);
+    if (c.contentRating.exceeds(ContentRating::uniform(ContentRating::Intensity::NONE))) {
+        beginObject("content_attributes");
+        for (size_t i = 0; i < ContentRating::kAttributeCount; ++i) {
+            if (const auto intensity = c.contentRating.get(i); intensity != ContentRating::Intensity::NONE) {
+                field(ContentRating::attributeId(i), ContentRating::intensityToString(intensity));
+            }
+        }
+        endObject();
+    }
+    field("agreement", c.agreement);
+    list("categories", c.categories);
+    list("keywords", c.keywords);
+    list("suggests", c.suggests);
+    list("languages", c.supportedLanguages);
+
+    if (!c.compulsory_for_desktop.empty()) {
+        key("compulsory_for_desktop");
+        appendChar('[');
+        for (size_t i = 0; i < c.compulsory_for_desktop.size(); ++i) {
+            if (i) {
+                appendChar(',');
+            }
+            string(Component::compulsoryForDesktopToString(c.compulsory_for_desktop[i]));
+        }
+        appendChar(']');
+    }
+
+    if (!c.icons.empty()) {
+        key("icons");
+        appendChar('[');
+        for (size_t i = 0; i < c.icons.size(); ++i) {
+            const auto &icon = c.icons[i];
+            if (i) {
+                appendChar(',');
+            }
+            beginObject({});
+            field("type", Component::iconTypeToString(icon.type));
+            field("value", icon.value);
+            for (const auto &[name, value]: {std::pair{"width", icon.width}, {"height", icon.height},
+                                             {"scale", icon.scale}}) {
+                if (value && *value >= 0) {
+                    key(name);
+                    number(static_cast<uint64_t>(*value));
+                }
+            }
+            endObject();
+        }
+        appendChar(']');
+    }
+
+    if (const auto releases = ReleaseStore::releases(c); !releases.empty()) {
+        key("releases");
+        appendChar('[');
+        for (size_t i = 0; i < releases.size(); ++i) {
+            const auto release = releases[i];
+            if (i) {
+                appendChar(',');
+            }
+            beginObject({});
+            field("version", release.version());
+            field("type", Component::releaseTypeToString(release.type()));
+            field("urgency", Component::releaseUrgencyToString(release.urgency()));
+            field("date", release.date());
+            field("timestamp", release.timestamp());
+            field("date_eol", release.dateEol());
+            field("url", release.url());
+            if (text_ && release.descriptionHandle() != Component::kNoTextHandle) {
+                text_->get(release.descriptionHandle(), description_);
+                field("description", description_);
+            } else {
+                field("description", release.description());
+            }
+            if (release.issueCount()) {
+                key("issues");
+                appendChar('[');
+                for (size_t j = 0; j < release.issueCount(); ++j) {
+                    const auto issue = release.issue(j);
+                    if (j) {
+                        appendChar(',');
+                    }
+                    beginObject({});
+                    field("type", Component::issueTypeToString(issue.type()));
+                    field("url", issue.url());
+                    field("value", issue.value());
+                    endObject();
+                }
+                appendChar(']');
+            }
+            if (release.artifactCount()) {
+                key("artifacts");
+                appendChar('[');
+                for (size_t j = 0; j < release.artifactCount(); ++j) {
+                    const auto artifact = release.artifact(j);
+                    if (j) {
+                        appendChar(',');
+                    }
+                    beginObject({});
+                    field("location", artifact.location());
+                    if (artifact.checksumCount()) {
+                        beginObject("checksum");
+                        for (size_t k = 0; k < artifact.checksumCount(); ++k) {
+                            const auto checksum = artifact.checksum(k);
+                            key(ReleaseStore::checksumTypeToString(checksum.type));
+                            hex(checksum);
+                        }
+                        endObject();
+                    }
+                    const auto download = artifact.size(ReleaseStore::SizeKind::DOWNLOAD);
+                    const auto installed = artifact.size(ReleaseStore::SizeKind::INSTALLED);
+                    if (download != ReleaseStore::kNoSize || installed != ReleaseStore::kNoSize) {
+                        beginObject("size");
+                        for (const auto &[kind, value]: {std::pair{ReleaseStore::SizeKind::DOWNLOAD, download},
+                                                         {ReleaseStore::SizeKind::INSTALLED, installed}}) {
+                            if (value != ReleaseStore::kNoSize) {
+                                key(ReleaseStore::sizeKindToString(kind));
+                                number(value);
+                            }
+                        }
+                        endObject();
+                    }
+                    endObject();
+                }
+                appendChar(']');
+            }
+            endObject();
+        }
+        appendChar(']');
+    }
+    endObject();
+}
+
+void CatalogExporter::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    if (format_ == Format::JSON) {
+        append("\n]\n");
+    } else {
+        appendChar('\0');
+    }
+    flush();
+}
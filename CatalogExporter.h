@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CATALOGEXPORTER_H
+#define CATALOGEXPORTER_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+#include "ReleaseStore.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class TextStore;
+
+
+/**
+ * @brief Streams components to a file descriptor as JSON or length-prefixed binary.
+ *
+ * Output is assembled in one reusable buffer and handed to write(2) whenever
+ * it fills, so exporting allocates nothing per field. JSON strings are escaped
+ * 16 bytes at a time with SSE2 or NEON where available.
+ *
+ * The binary format is the magic "ASC2", then per component a varint byte
+ * length followed by its ComponentCodec record and ComponentCodec::encodeReleases()
+ * output, and a zero length at the end.
+ */
+class AS_EXPORT CatalogExporter {
+public:
+    enum class Format { JSON, BINARY };
+
+    /// Does not take ownership of fd.
+    CatalogExporter(int fd, Format format, size_t bufferSize = 1 << 20);
+
+    /// Flushes; call finish() first to surface write errors.
+    ~CatalogExporter();
+
+    CatalogExporter(const CatalogExporter &) = delete;
+
+    CatalogExporter &operator=(const CatalogExporter &) = delete;
+
+    /// Writes one component. Descriptions moved to a TextStore are inflated from text.
+    void add(const Component &component, const TextStore *text = nullptr);
+
+    /// Closes the document and flushes. Throws std::runtime_error if a write fails.
+    void finish();
+
+    /// Bytes produced so far, including buffered ones.
+    [[nodiscard]] size_t bytesWritten() const { return flushed_ + size_; }
+
+    /// Appends text to out as the contents of a JSON string, without the quotes.
+    static void escapeJson(std::string_view text, std::string &out);
+
+private:
+    int fd_;
+    Format format_;
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    size_t flushed_ = 0;
+    size_t count_ = 0;
+    bool finished_ = false;
+    // Whether the next JSON key needs a separating comma
+    bool comma_ = false;
+    // Reused for each binary record
+    std::string record_;
+    // Reused for each description inflated from text_
+    std::string description_;
+    // Text store of the component being written
+    const TextStore *text_ = nullptr;
+
+    void flush();
+
+    void reserve(size_t bytes);
+
+    void append(std::string_view bytes);
+
+    void appendChar(char c);
+
+    void string(std::string_view text);
+
+    void key(std::string_view name);
+
+    void field(std::string_view name, std::string_view value);
+
+    /// Writes the digest as a JSON string of hex digits.
+    void hex(const ReleaseStore::Checksum &checksum);
+
+    void number(uint64_t value);
+
+    void list(std::string_view name, const std::vector<std::string> &values);
+
+    /// Opens an object, as the value of name unless name is empty.
+    void beginObject(std::string_view name);
+
+    void endObject();
+
+    void writeJson(const Component &component);
+};
+
+#endif // CATALOGEXPORTER_H
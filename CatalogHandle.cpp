@@ -0,0 +1,257 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CatalogHandle.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+CatalogHandle::Snapshot::Snapshot(const CatalogHandle *handle, Generation *generation)
+    : handle_(handle), generation_(generation) {
+}
+
+CatalogHandle::Snapshot::Snapshot(Snapshot &&other) noexcept
+    : handle_(other.handle_), generation_(other.generation_) {
+    other.generation_ = nullptr;
+}
+
+CatalogHandle::Snapshot &CatalogHandle::Snapshot::operator=(Snapshot &&other) noexcept {
+    if (this != &other) {
+        release();
+        handle_ = other.handle_;
+        generation_ = other.generation_;
+        other.generation_ = nullptr;
+    }
+    return *this;
+}
+
+CatalogHandle::Snapshot::~Snapshot() {
+    release();
+}
+
+void CatalogHandle::Snapshot::release() {
+    if (!generation_) {
+        return;
+    }
+    // The last reader of a swapped out generation lets the background thread free it
+    if (generation_->readers.fetch_sub(1) == 1 && handle_->current_.load() != generation_) {
+        handle_->wake();
+    }
+    generation_ = nullptr;
+}
+
+const AppStreamParser *CatalogHandle::Snapshot::operator->() const {
+    return generation_->parser.get();
+}
+
+const AppStreamParser &CatalogHandle::Snapshot::operator*() const {
+    return *generation_->parser;
+}
+
+uint64_t CatalogHandle::Snapshot::generation() const {
+    return generation_->number;
+}
+
+CatalogHandle::CatalogHandle(std::string filename, std::string language, const AppStreamParser::Options &options,
+                             const bool watchFile)
+    : filename_(std::move(filename)), language_(std::move(language)), options_(options) {
+    auto *initial = new Generation;
+    initial->parser = std::make_unique<AppStreamParser>(filename_, language_, options_);
+    initial->number = 1;
+    current_.store(initial);
+
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd_ == -1) {
+        delete initial;
+        throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+    }
+
+    if (watchFile) {
+        inotifyFd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        const auto directory = std::filesystem::absolute(filename_).parent_path().string();
+        if (inotifyFd_ == -1 ||
+            inotify_add_watch(inotifyFd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+            spdlog::error("Failed to watch {}: {}", directory, strerror(errno));
+            if (inotifyFd_ != -1) {
+                close(inotifyFd_);
+                inotifyFd_ = -1;
+            }
+        }
+    }
+
+    thread_ = std::thread(&CatalogHandle::run, this);
+}
+
+CatalogHandle::~CatalogHandle() {
+    stop_.store(true);
+    wake();
+    thread_.join();
+
+    delete current_.load();
+    for (const auto *generation: retired_) {
+        delete generation;
+    }
+    if (inotifyFd_ != -1) {
+        close(inotifyFd_);
+    }
+    close(wakeFd_);
+}
+
+CatalogHandle::Snapshot CatalogHandle::acquire() const {
+    for (;;) {
+        const uint64_t epoch = epoch_.load();
+        auto &entering = entering_[epoch & 1];
+        entering.fetch_add(1);
+        // A flip in between means our bucket may already have been drained
+        if (epoch_.load() != epoch) {
+            entering.fetch_sub(1);
+            continue;
+        }
+        auto *generation = current_.load();
+        generation->readers.fetch_add(1);
+        entering.fetch_sub(1);
+        return {this, generation};
+    }
+}
+
+void CatalogHandle::reload() {
+    reloadRequested_.store(true);
+    wake();
+}
+
+void CatalogHandle::setReloadCallback(ReloadCallback callback) {
+    std::lock_guard lock(callbackMutex_);
+    callback_ = std::move(callback);
+}
+
+uint64_t CatalogHandle::generation() const {
+    return current_.load()->number;
+}
+
+size_t CatalogHandle::retiredGenerations() const {
+    return retiredCount_.load();
+}
+
+void CatalogHandle::wake() const {
+    constexpr uint64_t one = 1;
+    if (write(wakeFd_, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        spdlog::error("Failed to wake catalog thread: {}", strerror(errno));
+    }
+}
+
+void CatalogHandle::run() {
+    pollfd fds[2] = {{wakeFd_, POLLIN, 0}, {inotifyFd_, POLLIN, 0}};
+    const nfds_t count = inotifyFd_ != -1 ? 2 : 1;
+
+    while (!stop_.load()) {
+        if (poll(fds, count, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("Catalog thread poll failed: {}", strerror(errno));
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            uint64_t value;
+            (void) read(wakeFd_, &value, sizeof(value));
+        }
+        if (count > 1 && fds[1].revents & POLLIN && isCatalogEvent()) {
+            reloadRequested_.store(true);
+        }
+        if (stop_.load()) {
+            break;
+        }
+        if (reloadRequested_.exchange(false)) {
+            rebuild();
+        }
+        reclaim();
+    }
+}
+
+bool CatalogHandle::isCatalogEvent() {
+    const auto name = std::filesystem::path(filename_).filename().string();
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    bool matched = false;
+    ssize_t length;
+    while ((length = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            if (event->len && name == event->name) {
+                matched = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+    return matched;
+}
+
+void CatalogHandle::rebuild() {
+    auto *generation = new Generation;
+    try {
+        generation->parser = std::make_unique<AppStreamParser>(filename_, language_, options_);
+    } catch (const std::exception &e) {
+        // Keep serving the current generation
+        spdlog::error("Catalog reload failed: {}", e.what());
+        delete generation;
+        return;
+    }
+    generation->number = current_.load()->number + 1;
+    publish(generation);
+    spdlog::info("Catalog generation {} published", generation->number);
+    ReloadCallback callback;
+    {
+        std::lock_guard lock(callbackMutex_);
+        callback = callback_;
+    }
+    if (callback) {
+        callback(generation->number);
+    }
+}
+
+void CatalogHandle::publish(Generation *generation) {
+    auto *previous = current_.exchange(generation);
+
+    // Wait out readers that may have loaded the previous pointer but not yet
+    // counted themselves in it; this is a few instructions per reader.
+    const uint64_t epoch = epoch_.fetch_add(1);
+    while (entering_[epoch & 1].load() != 0) {
+        std::this_thread::yield();
+    }
+
+    retired_.push_back(previous);
+    retiredCount_.store(retired_.size());
+}
+
+void CatalogHandle::reclaim() {
+    const auto it = std::partition(retired_.begin(), retired_.end(), [](const Generation *generation) {
+        return generation->readers.load() != 0;
+    });
+    for (auto reclaimable = it; reclaimable != retired_.end(); ++reclaimable) {
+        spdlog::debug("Catalog generation {} reclaimed", (*reclaimable)->number);
+        delete *reclaimable;
+    }
+    retired_.erase(it, retired_.end());
+    retiredCount_.store(retired_.size());
+}
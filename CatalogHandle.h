@@ -0,0 +1,152 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CATALOGHANDLE_H
+#define CATALOGHANDLE_H
+
+#include "AppStreamExport.h"
+#include "AppStreamParser.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Shared catalog that is reloaded in the background and swapped atomically.
+ *
+ * Readers call acquire() and query the returned Snapshot. Acquiring and
+ * releasing a snapshot only performs atomic operations, so readers never wait
+ * for a reload. A background thread parses the new catalog while the current
+ * one keeps serving, publishes it with a single pointer swap and frees the
+ * previous generation once its last snapshot is released.
+ *
+ * Reloads are triggered by reload(), or by changes to the catalog file when
+ * constructed with watchFile set (inotify on the containing directory, so
+ * atomic replacement by rename is picked up).
+ *
+ * Snapshots must not outlive the handle.
+ */
+class AS_EXPORT CatalogHandle {
+    struct Generation;
+
+public:
+    /// Keeps its generation alive; components taken from it read their releases only while it is held.
+    class Snapshot {
+    public:
+        Snapshot(Snapshot &&other) noexcept;
+
+        Snapshot &operator=(Snapshot &&other) noexcept;
+
+        Snapshot(const Snapshot &) = delete;
+
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        ~Snapshot();
+
+        const AppStreamParser *operator->() const;
+
+        const AppStreamParser &operator*() const;
+
+        [[nodiscard]] uint64_t generation() const;
+
+    private:
+        friend class CatalogHandle;
+
+        Snapshot(const CatalogHandle *handle, Generation *generation);
+
+        void release();
+
+        const CatalogHandle *handle_;
+        Generation *generation_;
+    };
+
+    /// Called on the background thread after a new generation is published.
+    using ReloadCallback = std::function<void(uint64_t generation)>;
+
+    /// Parses the catalog synchronously, then starts the background thread.
+    CatalogHandle(std::string filename, std::string language, const AppStreamParser::Options &options = {},
+                  bool watchFile = false);
+
+    ~CatalogHandle();
+
+    CatalogHandle(const CatalogHandle &) = delete;
+
+    CatalogHandle &operator=(const CatalogHandle &) = delete;
+
+    [[nodiscard]] Snapshot acquire() const;
+
+    /// Requests a reload; returns immediately.
+    void reload();
+
+    /// May be called at any time; a reload already in progress calls the previous callback.
+    void setReloadCallback(ReloadCallback callback);
+
+    /// Number of the current generation; the initial catalog is generation 1.
+    [[nodiscard]] uint64_t generation() const;
+
+    /// Generations swapped out but still referenced by snapshots.
+    [[nodiscard]] size_t retiredGenerations() const;
+
+private:
+    struct Generation {
+        std::unique_ptr<AppStreamParser> parser;
+        uint64_t number;
+        std::atomic<uint32_t> readers{0};
+    };
+
+    std::string filename_;
+    std::string language_;
+    AppStreamParser::Options options_;
+
+    std::atomic<Generation *> current_{nullptr};
+    // Readers register in the bucket of the current epoch while taking a
+    // reference; flipping the epoch and draining the old bucket guarantees
+    // every reader of a retired generation is visible in its count.
+    std::atomic<uint64_t> epoch_{0};
+    mutable std::atomic<uint32_t> entering_[2]{};
+    std::atomic<size_t> retiredCount_{0};
+
+    std::vector<Generation *> retired_;
+    // Set from any thread while the background thread may be calling it
+    ReloadCallback callback_;
+    std::mutex callbackMutex_;
+
+    int wakeFd_ = -1;
+    int inotifyFd_ = -1;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> reloadRequested_{false};
+    std::thread thread_;
+
+    void wake() const;
+
+    void run();
+
+    void rebuild();
+
+    void publish(Generation *generation);
+
+    void reclaim();
+
+    bool isCatalogEvent();
+};
+
+#endif // CATALOGHANDLE_H
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompletionIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+// Longer keys add nodes without helping the user pick a completion
+constexpr size_t kMaxKeyLength = 64;
+constexpr uint32_t kMagic = 0x31494341; // "ACI1"
+
+bool isSeparator(const char c) {
+    return c == ' ' || c == '.' || c == '-' || c == '_' || c == '/';
+}
+
+template<typename T>
+void writeArray(std::string &out, const T *data, const size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto n = static_cast<uint32_t>(count);
+    out.append(reinterpret_cast<const char *>(&n), sizeof(n));
+    out.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+}
+
+class ArrayReader {
+public:
+    ArrayReader(const uint8_t *data, const size_t length) : cur_(data), end_(data + length) {
+    }
+
+    uint32_t u32() {
+        uint32_t value;
+        take(&value, sizeof(value));
+        return value;
+    }
+
+    template<typename C>
+    void array(C &out) {
+        const auto n = u32();
+        if (n > static_cast<size_t>(end_ - cur_) / sizeof(out[0])) {
+            throw std::runtime_error("CompletionIndex: truncated image");
+        }
+        out.resize(n);
+        take(out.data(), n * sizeof(out[0]));
+    }
+
+private:
+    const uint8_t *cur_;
+    const uint8_t *end_;
+
+    void take(void *out, const size_t bytes) {
+        if (bytes > static_cast<size_t>(end_ - cur_)) {
+            throw std::runtime_error("CompletionIndex: truncated image");
+        }
+        std::memcpy(out, cur_, bytes);
+        cur_ += bytes;
+    }
+};
+}
+
+void CompletionIndex::normalize(const std::string_view text, std::string &out) {
+    out.clear();
+    for (const char c: text) {
+        out.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+    }
+}
+
+void CompletionIndex::Builder::add(std::string_view text, const Kind kind, const uint32_t ordinal,
+                                   const uint32_t weight) {
+    text = text.substr(0, UINT16_MAX);
+    if (text.empty()) {
+        return;
+    }
+    const auto entry = static_cast<uint32_t>(entries_.size());
+    entries_.push_back({static_cast<uint32_t>(texts_.size()), ordinal, weight, static_cast<uint16_t>(text.size()),
+                        static_cast<uint8_t>(kind), 0});
+    texts_.append(text);
+
+    // Key the whole text and every word start within it
+    std::string normalized;
+    normalize(text, normalized);
+    for (size_t i = 0; i < normalized.size(); ++i) {
+        if (i == 0 || (isSeparator(normalized[i - 1]) && !isSeparator(normalized[i]))) {
+            keys_.push_back({normalized.substr(i, kMaxKeyLength), entry});
+        }
+    }
+}
+
+CompletionIndex CompletionIndex::Builder::build(const size_t completionsPerNode) {
+    std::sort(keys_.begin(), keys_.end(), [](const Key &a, const Key &b) {
+        return a.text != b.text ? a.text < b.text : a.entry < b.entry;
+    });
+    keys_.erase(std::unique(keys_.begin(), keys_.end(), [](const Key &a, const Key &b) {
+        return a.entry == b.entry && a.text == b.text;
+    }), keys_.end());
+
+    CompletionIndex index;
+    index.entries_ = std::move(entries_);
+    index.texts_ = std::move(texts_);
+    const auto &entries = index.entries_;
+    const auto &texts = index.texts_;
+    const auto better = [&](const uint32_t a, const uint32_t b) {
+        const auto &x = entries[a];
+        const auto &y = entries[b];
+        if (x.weight != y.weight) {
+            return x.weight > y.weight;
+        }
+        if (x.textLength != y.textLength) {
+            return x.textLength < y.textLength;
+        }
+        const auto c = texts.compare(x.text, x.textLength, texts, y.text, y.textLength);
+        return c != 0 ? c < 0 : a < b;
+    };
+
+    // Nodes are created a sibling group at a time, so children stay contiguous
+    std::vector<std::vector<uint32_t> > tops;
+    index.nodes_.push_back({0, 0, 0, 0});
+    tops.emplace_back();
+
+    const auto buildNode = [&](const auto &self, const uint32_t node, size_t lo, const size_t hi,
+                               const size_t depth) -> void {
+        // Held locally; recursing below grows tops
+        std::vector<uint32_t> top;
+        // Keys ending at this node sort first
+        for (; lo < hi && keys_[lo].text.size() == depth; ++lo) {
+            top.push_back(keys_[lo].entry);
+        }
+
+        std::vector<std::pair<size_t, size_t> > groups;
+        for (size_t a = lo; a < hi;) {
+            size_t b = a + 1;
+            while (b < hi && keys_[b].text[depth] == keys_[a].text[depth]) {
+                ++b;
+            }
+            groups.emplace_back(a, b);
+            a = b;
+        }
+
+        const auto firstChild = static_cast<uint32_t>(index.nodes_.size());
+        index.nodes_[node].firstChild = firstChild;
+        index.nodes_[node].childCount = static_cast<uint16_t>(groups.size());
+        std::vector<size_t> ends;
+        for (const auto &[a, b]: groups) {
+            // Sorted input: the group's common prefix is that of its first and last key
+            const auto &first = keys_[a].text;
+            const auto &last = keys_[b - 1].text;
+            size_t end = depth + 1;
+            while (end < first.size() && end < last.size() && first[end] == last[end]) {
+                ++end;
+            }
+            index.nodes_.push_back({static_cast<uint32_t>(index.labels_.size()), 0,
+                                    static_cast<uint16_t>(end - depth), 0});
+            index.labels_.append(first, depth, end - depth);
+            tops.emplace_back();
+            ends.push_back(end);
+        }
+        for (size_t i = 0; i < groups.size(); ++i) {
+            const auto child = firstChild + static_cast<uint32_t>(i);
+            self(self, child, groups[i].first, groups[i].second, ends[i]);
+            top.insert(top.end(), tops[child].begin(), tops[child].end());
+        }
+
+        std::sort(top.begin(), top.end(), better);
+        top.erase(std::unique(top.begin(), top.end()), top.end());
+        if (top.size() > completionsPerNode) {
+            top.resize(completionsPerNode);
+        }
+        tops[node] = std::move(top);
+    };
+    buildNode(buildNode, 0, 0, keys_.size(), 0);
+    keys_ = {};
+
+    index.topOffsets_.reserve(tops.size() + 1);
+    index.topOffsets_.push_back(0);
+    for (const auto &top: tops) {
+        index.top_.insert(index.top_.end(), top.begin(), top.end());
+        index.topOffsets_.push_back(static_cast<uint32_t>(index.top_.size()));
+    }
+    return index;
+}
+
+std::vector<CompletionIndex::Completion> CompletionIndex::complete(const std::string_view prefix,
+                                                                   const size_t limit) const {
+    if (nodes_.empty()) {
+        return {};
+    }
+    std::string key;
+    normalize(prefix.substr(0, kMaxKeyLength), key);
+
+    uint32_t node = 0;
+    size_t pos = 0;
+    while (pos < key.size()) {
+        const auto &parent = nodes_[node];
+        const auto first = nodes_.begin() + parent.firstChild;
+        const auto last = first + parent.childCount;
+        // Siblings are ordered by the first byte of their label
+        const auto child = std::lower_bound(first, last, key[pos], [&](const Node &n, const char c) {
+            return static_cast<unsigned char>(labels_[n.label]) < static_cast<unsigned char>(c);
+        });
+        if (child == last || labels_[child->label] != key[pos]) {
+            return {};
+        }
+        const size_t n = std::min<size_t>(child->labelLength, key.size() - pos);
+        if (labels_.compare(child->label, n, key, pos, n) != 0) {
+            return {};
+        }
+        pos += n;
+        node = static_cast<uint32_t>(child - nodes_.begin());
+    }
+
+    std::vector<Completion> completions;
+    const auto end = std::min<size_t>(topOffsets_[node + 1], topOffsets_[node] + limit);
+    for (auto i = topOffsets_[node]; i < end; ++i) {
+        completions.push_back(completion(top_[i]));
+    }
+    return completions;
+}
+
+CompletionIndex::Completion CompletionIndex::completion(const uint32_t entry) const {
+    const auto &e = entries_[entry];
+    return {std::string_view(texts_).substr(e.text, e.textLength), static_cast<Kind>(e.kind), e.ordinal, e.weight};
+}
+
+size_t CompletionIndex::memoryUsage() const {
+    return nodes_.capacity() * sizeof(Node) + labels_.capacity() + topOffsets_.capacity() * sizeof(uint32_t) +
+           top_.capacity() * sizeof(uint32_t) + entries_.capacity() * sizeof(Entry) + texts_.capacity();
+}
+
+void CompletionIndex::serialize(std::string &out) const {
+    out.append(reinterpret_cast<const char *>(&kMagic), sizeof(kMagic));
+    writeArray(out, nodes_.data(), nodes_.size());
+    writeArray(out, labels_.data(), labels_.size());
+    writeArray(out, topOffsets_.data(), topOffsets_.size());
+    writeArray(out, top_.data(), top_.size());
+    writeArray(out, entries_.data(), entries_.size());
+    writeArray(out, texts_.data(), texts_.size());
+}
+
+CompletionIndex CompletionIndex::deserialize(const uint8_t *data, const size_t length) {
+    ArrayReader r(data, length);
+    if (r.u32() != kMagic) {
+        throw std::runtime_error("CompletionIndex: bad image magic");
+    }
+    CompletionIndex index;
+    r.array(index.nodes_);
+    r.array(index.labels_);
+    r.array(index.topOffsets_);
+    r.array(index.top_);
+    r.array(index.entries_);
+    r.array(index.texts_);
+
+    // Every offset is checked once here so lookups can index without bounds checks
+    const auto malformed = [] { throw std::runtime_error("CompletionIndex: malformed image"); };
+    if (index.topOffsets_.size() != index.nodes_.size() + 1 || index.topOffsets_.front() != 0 ||
+        index.topOffsets_.back() != index.top_.size() ||
+        !std::is_sorted(index.topOffsets_.begin(), index.topOffsets_.end())) {
+        malformed();
+    }
+    for (size_t i = 0; i < index.nodes_.size(); ++i) {
+        const auto &node = index.nodes_[i];
+        if (static_cast<size_t>(node.label) + node.labelLength > index.labels_.size() ||
+            (i > 0 && node.labelLength == 0) ||
+            (node.childCount && (node.firstChild <= i ||
+                                 static_cast<size_t>(node.firstChild) + node.childCount > index.nodes_.size()))) {
+            malformed();
+        }
+    }
+    for (const auto entry: index.top_) {
+        if (entry >= index.entries_.size()) {
+            malformed();
+        }
+    }
+    for (const auto &entry: index.entries_) {
+        if (static_cast<size_t>(entry.text) + entry.textLength > index.texts_.size() ||
+            entry.kind > static_cast<uint8_t>(Kind::KEYWORD)) {
+            malformed();
+        }
+    }
+    return index;
+}
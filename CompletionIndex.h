@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPLETIONINDEX_H
+#define COMPLETIONINDEX_H
+
+#include "AppStreamExport.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Prefix autocomplete over component names, IDs and keywords.
+ *
+ * A radix trie over normalized (ASCII lower-cased) keys, stored as flat
+ * arrays: nodes with their children contiguous, edge labels in one blob, and
+ * at every node the best completions below it, precomputed. A lookup walks at
+ * most one node per label and returns the cached list, independent of how
+ * many keys share the prefix.
+ *
+ * Names and IDs are also keyed from every word start, so "edi" completes
+ * "Text Editor" and "gnome" completes "org.gnome.Maps".
+ */
+class AS_EXPORT CompletionIndex {
+public:
+    enum class Kind : uint8_t { NAME, ID, KEYWORD };
+
+    static constexpr uint32_t kNoOrdinal = UINT32_MAX;
+
+    struct Completion {
+        std::string_view text;
+        Kind kind;
+        /// Component the completion resolves to; kNoOrdinal for keywords.
+        uint32_t ordinal;
+        uint32_t weight;
+    };
+
+    class Builder;
+
+    CompletionIndex() = default;
+
+    /// Best completions of prefix, at most completionsPerNode of them.
+    [[nodiscard]] std::vector<Completion> complete(std::string_view prefix, size_t limit) const;
+
+    [[nodiscard]] size_t nodeCount() const { return nodes_.size(); }
+
+    [[nodiscard]] size_t memoryUsage() const;
+
+    /// Appends a self-contained binary image of the index to out.
+    void serialize(std::string &out) const;
+
+    /// Reads an image written by serialize(); throws std::runtime_error on malformed input.
+    static CompletionIndex deserialize(const uint8_t *data, size_t length);
+
+    /// Lower-cases ASCII letters; other bytes pass through.
+    static void normalize(std::string_view text, std::string &out);
+
+private:
+    // Both are written to the serialized image as-is, so they carry no padding
+    struct Node {
+        uint32_t label;
+        uint32_t firstChild;
+        uint16_t labelLength;
+        uint16_t childCount;
+    };
+
+    struct Entry {
+        uint32_t text;
+        uint32_t ordinal;
+        uint32_t weight;
+        uint16_t textLength;
+        uint8_t kind;
+        uint8_t reserved;
+    };
+
+    std::vector<Node> nodes_;
+    std::string labels_;
+    // Completions of node n are top_[topOffsets_[n], topOffsets_[n + 1]), best first
+    std::vector<uint32_t> topOffsets_;
+    std::vector<uint32_t> top_;
+    std::vector<Entry> entries_;
+    std::string texts_;
+
+    [[nodiscard]] Completion completion(uint32_t entry) const;
+};
+
+/// Collects entries, then build() produces the index.
+class AS_EXPORT CompletionIndex::Builder {
+public:
+    /// Higher weights rank first; ties prefer shorter text.
+    void add(std::string_view text, Kind kind, uint32_t ordinal, uint32_t weight);
+
+    [[nodiscard]] CompletionIndex build(size_t completionsPerNode = 8);
+
+private:
+    struct Key {
+        std::string text;
+        uint32_t entry;
+    };
+
+    std::vector<Key> keys_;
+    std::vector<Entry> entries_;
+    std::string texts_;
+};
+
+#endif // COMPLETIONINDEX_H
@@ -15,9 +15,30 @@
  */
 
 #include "Component.h"
+#include "ReleaseStore.h"
 
 #include "spdlog/spdlog.h"
 
+#include <unordered_map>
+
+constexpr char kGenericComponent[] = "generic";
+constexpr char kDesktopApplication[] = "desktop-application";
+constexpr char kDesktopLegacy[] = "desktop";
+constexpr char kConsoleApplication[] = "console-application";
+constexpr char kWebApplication[] = "web-application";
+constexpr char kServiceComponent[] = "service";
+constexpr char kAddon[] = "addon";
+constexpr char kRuntime[] = "runtime";
+constexpr char kFont[] = "font";
+constexpr char kCodec[] = "codec";
+constexpr char kInputMethod[] = "inputmethod";
+constexpr char kOperatingSystem[] = "operating-system";
+constexpr char kFirmware[] = "firmware";
+constexpr char kDriver[] = "driver";
+constexpr char kLocalization[] = "localization";
+constexpr char kRepository[] = "repository";
+constexpr char kIconTheme[] = "icon-theme";
+
 constexpr char kPackage[] = "package";
 constexpr char kLimba[] = "limba";
 constexpr char kFlatpak[] = "flatpak";
@@ -80,7 +101,49 @@ constexpr char kCritical[] = "critical";
 constexpr char kGeneric[] = "generic";
 constexpr char kCve[] = "cve";
 
-Component::BundleType Component::stringToBundleType(const std::string &typeStr) {
+Component::ComponentType Component::stringToComponentType(const std::string_view typeStr) {
+    if (typeStr == kDesktopApplication || typeStr == kDesktopLegacy) return ComponentType::DESKTOP_APPLICATION;
+    if (typeStr == kGenericComponent) return ComponentType::GENERIC;
+    if (typeStr == kConsoleApplication) return ComponentType::CONSOLE_APPLICATION;
+    if (typeStr == kWebApplication) return ComponentType::WEB_APPLICATION;
+    if (typeStr == kServiceComponent) return ComponentType::SERVICE;
+    if (typeStr == kAddon) return ComponentType::ADDON;
+    if (typeStr == kRuntime) return ComponentType::RUNTIME;
+    if (typeStr == kFont) return ComponentType::FONT;
+    if (typeStr == kCodec) return ComponentType::CODEC;
+    if (typeStr == kInputMethod) return ComponentType::INPUT_METHOD;
+    if (typeStr == kOperatingSystem) return ComponentType::OPERATING_SYSTEM;
+    if (typeStr == kFirmware) return ComponentType::FIRMWARE;
+    if (typeStr == kDriver) return ComponentType::DRIVER;
+    if (typeStr == kLocalization) return ComponentType::LOCALIZATION;
+    if (typeStr == kRepository) return ComponentType::REPOSITORY;
+    if (typeStr == kIconTheme) return ComponentType::ICON_THEME;
+    return ComponentType::UNKNOWN;
+}
+
+std::string_view Component::componentTypeToString(const ComponentType type) {
+    switch (type) {
+        case ComponentType::GENERIC: return kGenericComponent;
+        case ComponentType::DESKTOP_APPLICATION: return kDesktopApplication;
+        case ComponentType::CONSOLE_APPLICATION: return kConsoleApplication;
+        case ComponentType::WEB_APPLICATION: return kWebApplication;
+        case ComponentType::SERVICE: return kServiceComponent;
+        case ComponentType::ADDON: return kAddon;
+        case ComponentType::RUNTIME: return kRuntime;
+        case ComponentType::FONT: return kFont;
+        case ComponentType::CODEC: return kCodec;
+        case ComponentType::INPUT_METHOD: return kInputMethod;
+        case ComponentType::OPERATING_SYSTEM: return kOperatingSystem;
+        case ComponentType::FIRMWARE: return kFirmware;
+        case ComponentType::DRIVER: return kDriver;
+        case ComponentType::LOCALIZATION: return kLocalization;
+        case ComponentType::REPOSITORY: return kRepository;
+        case ComponentType::ICON_THEME: return kIconTheme;
+        default: return kUnknown;
+    }
+}
+
+Component::BundleType Component::stringToBundleType(const std::string_view typeStr) {
     if (typeStr == kPackage) return BundleType::PACKAGE;
     if (typeStr == kLimba) return BundleType::LIMBA;
     if (typeStr == kFlatpak) return BundleType::FLATPAK;
@@ -92,7 +155,7 @@ Component::BundleType Component::stringToBundleType(const std::string &typeStr)
     return BundleType::UNKNOWN;
 }
 
-std::string Component::bundleTypeToString(const BundleType type) {
+std::string_view Component::bundleTypeToString(const BundleType type) {
     switch (type) {
         case BundleType::PACKAGE: return kPackage;
         case BundleType::LIMBA: return kLimba;
@@ -106,7 +169,7 @@ std::string Component::bundleTypeToString(const BundleType type) {
     }
 }
 
-Component::IconType Component::stringToIconType(const std::string &typeStr) {
+Component::IconType Component::stringToIconType(const std::string_view typeStr) {
     if (typeStr == kStock) return IconType::STOCK;
     if (typeStr == kCached) return IconType::CACHED;
     if (typeStr == kLocal) return IconType::LOCAL;
@@ -115,7 +178,7 @@ Component::IconType Component::stringToIconType(const std::string &typeStr) {
     return IconType::UNKNOWN;
 }
 
-std::string Component::iconTypeToString(const IconType type) {
+std::string_view Component::iconTypeToString(const IconType type) {
     switch (type) {
         case IconType::STOCK: return kStock;
         case IconType::CACHED: return kCached;
@@ -126,8 +189,8 @@ std::string Component::iconTypeToString(const IconType type) {
     }
 }
 
-Component::CompulsoryForDesktop Component::stringToCompulsoryForDesktop(const std::string &desktopString) {
-    static const std::unordered_map<std::string, CompulsoryForDesktop> stringToEnumMap = {
+Component::CompulsoryForDesktop Component::stringToCompulsoryForDesktop(const std::string_view desktopString) {
+    static const std::unordered_map<std::string_view, CompulsoryForDesktop> stringToEnumMap = {
         {kCosmic, CompulsoryForDesktop::COSMIC}, {kGnome, CompulsoryForDesktop::GNOME},
         {kGnomeClassic, CompulsoryForDesktop::GNOME_Classic}, {kGnomeFlashback, CompulsoryForDesktop::GNOME_Flashback},
         {kKde, CompulsoryForDesktop::KDE}, {kLxde, CompulsoryForDesktop::LXDE},
@@ -146,7 +209,7 @@ Component::CompulsoryForDesktop Component::stringToCompulsoryForDesktop(const st
     return CompulsoryForDesktop::UNKNOWN;
 }
 
-std::string Component::compulsoryForDesktopToString(const CompulsoryForDesktop desktopEnum) {
+std::string_view Component::compulsoryForDesktopToString(const CompulsoryForDesktop desktopEnum) {
     static const std::unordered_map<CompulsoryForDesktop, std::string> enumToStringMap = {
         {CompulsoryForDesktop::COSMIC, kCosmic}, {CompulsoryForDesktop::GNOME, kGnome},
         {CompulsoryForDesktop::GNOME_Classic, kGnomeClassic}, {CompulsoryForDesktop::GNOME_Flashback, kGnomeFlashback},
@@ -166,7 +229,7 @@ std::string Component::compulsoryForDesktopToString(const CompulsoryForDesktop d
     return kUnknown;
 }
 
-Component::UrlType Component::stringToUrlType(const std::string &typeStr) {
+Component::UrlType Component::stringToUrlType(const std::string_view typeStr) {
     if (typeStr == kHomepage) return UrlType::HOMEPAGE;
     if (typeStr == kBugtracker) return UrlType::BUGTRACKER;
     if (typeStr == kFaq) return UrlType::FAQ;
@@ -179,7 +242,7 @@ Component::UrlType Component::stringToUrlType(const std::string &typeStr) {
     return UrlType::UNKNOWN;
 }
 
-Component::LaunchableType Component::stringToLaunchableType(const std::string &typeStr) {
+Component::LaunchableType Component::stringToLaunchableType(const std::string_view typeStr) {
     if (typeStr == kDesktopId) return LaunchableType::DESKTOP_ID;
     if (typeStr == kService) return LaunchableType::SERVICE;
     if (typeStr == kCockpitManifest) return LaunchableType::COCKPIT_MANIFEST;
@@ -187,14 +250,14 @@ Component::LaunchableType Component::stringToLaunchableType(const std::string &t
     return LaunchableType::UNKNOWN;
 }
 
-Component::ReleaseType Component::stringToReleaseType(const std::string &typeStr) {
+Component::ReleaseType Component::stringToReleaseType(const std::string_view typeStr) {
     if (typeStr == kStable) return ReleaseType::STABLE;
     if (typeStr == kDevelopment) return ReleaseType::DEVELOPMENT;
     if (typeStr == kSnapshot) return ReleaseType::SNAPSHOT;
     return ReleaseType::UNKNOWN;
 }
 
-Component::ReleaseUrgency Component::stringToReleaseUrgency(const std::string &typeStr) {
+Component::ReleaseUrgency Component::stringToReleaseUrgency(const std::string_view typeStr) {
     if (typeStr == kLow) return ReleaseUrgency::LOW;
     if (typeStr == kMedium) return ReleaseUrgency::MEDIUM;
     if (typeStr == kHigh) return ReleaseUrgency::HIGH;
@@ -202,7 +265,7 @@ Component::ReleaseUrgency Component::stringToReleaseUrgency(const std::string &t
     return ReleaseUrgency::UNKNOWN;
 }
 
-std::string Component::releaseUrgencyToString(const ReleaseUrgency type) {
+std::string_view Component::releaseUrgencyToString(const ReleaseUrgency type) {
     switch (type) {
         case ReleaseUrgency::LOW: return kLow;
         case ReleaseUrgency::MEDIUM: return kMedium;
@@ -212,13 +275,13 @@ std::string Component::releaseUrgencyToString(const ReleaseUrgency type) {
     }
 }
 
-Component::IssueType Component::stringToIssueType(const std::string &typeStr) {
+Component::IssueType Component::stringToIssueType(const std::string_view typeStr) {
     if (typeStr == kGeneric) return IssueType::GENERIC;
     if (typeStr == kCve) return IssueType::CVE;
     return IssueType::UNKNOWN;
 }
 
-std::string Component::releaseTypeToString(const ReleaseType type) {
+std::string_view Component::releaseTypeToString(const ReleaseType type) {
     switch (type) {
         case ReleaseType::STABLE: return kStable;
         case ReleaseType::SNAPSHOT: return kSnapshot;
@@ -227,7 +290,7 @@ std::string Component::releaseTypeToString(const ReleaseType type) {
     }
 }
 
-std::string Component::issueTypeToString(const IssueType type) {
+std::string_view Component::issueTypeToString(const IssueType type) {
     switch (type) {
         case IssueType::GENERIC: return kGeneric;
         case IssueType::CVE: return kCve;
@@ -239,8 +302,45 @@ void Component::addSupportedLanguage(const std::string &language) {
     supportedLanguages.push_back(language);
 }
 
+namespace {
+size_t heapBytes(const std::string &value) {
+    // Strings within the small string buffer do not allocate
+    return value.capacity() > sizeof(std::string) - 1 ? value.capacity() + 1 : 0;
+}
+
+size_t heapBytes(const std::vector<std::string> &values) {
+    size_t bytes = values.capacity() * sizeof(std::string);
+    for (const auto &value: values) {
+        bytes += heapBytes(value);
+    }
+    return bytes;
+}
+}
+
+size_t Component::memoryFootprint() const {
+    size_t bytes = sizeof(Component);
+    for (const auto *value: {
+             &id, &pkgname, &source_pkgname, &name, &summary, &projectLicense, &description, &url.homepage,
+             &url.bugtracker, &url.faq, &url.help, &url.donation, &url.translate, &url.contact, &url.vcs_browser,
+             &url.contribute, &url.unknown, &project_group, &developer.id, &developer.name, &launchable.desktop_id,
+             &launchable.service, &launchable.cockpit_manifest, &launchable.url, &media_baseurl, &architecture,
+             &bundle.id, &content_rating, &agreement
+         }) {
+        bytes += heapBytes(*value);
+    }
+    bytes += icons.capacity() * sizeof(Icon);
+    for (const auto &icon: icons) {
+        bytes += heapBytes(icon.value);
+    }
+    bytes += compulsory_for_desktop.capacity() * sizeof(CompulsoryForDesktop);
+    bytes += heapBytes(keywords) + heapBytes(categories) + heapBytes(suggests) + heapBytes(supportedLanguages);
+    // Release records are held by the catalog's ReleaseStore
+    return bytes;
+}
+
 void Component::Dump() const {
     spdlog::info("id: {}", id);
+    spdlog::info("\ttype: {}", componentTypeToString(type));
     spdlog::info("\tname: {}", name);
     spdlog::info("\tproject_license: {}", projectLicense);
     spdlog::info("\tsummary: {}", summary);
@@ -277,34 +377,35 @@ void Component::Dump() const {
         if (height) spdlog::info("\t\theight: {}", *height);
         if (scale) spdlog::info("\t\tscale: {}", *scale);
     }
-    for (const auto &[type, version, date, timestamp, date_eol, urgency, description, url, issues, artifacts]:
-         releases) {
+    for (const auto release: ReleaseStore::releases(*this)) {
         spdlog::info("\trelease");
-        spdlog::info("\t\ttype: {}", releaseTypeToString(type));
-        spdlog::info("\t\tversion: {}", version);
-        if (!date.empty()) spdlog::info("\t\tdate: {}", date);
-        if (!timestamp.empty()) spdlog::info("\t\ttimestamp: {}", timestamp);
-        if (!date_eol.empty()) spdlog::info("\t\tdate_eol: {}", date_eol);
-        spdlog::info("\t\turgency: {}", releaseUrgencyToString(urgency));
-        if (!description.empty()) spdlog::info("\t\tdescription: {}", description);
-        if (!url.empty()) spdlog::info("\t\turl: {}", url);
-        for (const auto &[type, url, value]: issues) {
+        spdlog::info("\t\ttype: {}", releaseTypeToString(release.type()));
+        spdlog::info("\t\tversion: {}", release.version());
+        if (!release.date().empty()) spdlog::info("\t\tdate: {}", release.date());
+        if (!release.timestamp().empty()) spdlog::info("\t\ttimestamp: {}", release.timestamp());
+        if (!release.dateEol().empty()) spdlog::info("\t\tdate_eol: {}", release.dateEol());
+        spdlog::info("\t\turgency: {}", releaseUrgencyToString(release.urgency()));
+        if (!release.description().empty()) spdlog::info("\t\tdescription: {}", release.description());
+        if (!release.url().empty()) spdlog::info("\t\turl: {}", release.url());
+        for (size_t i = 0; i < release.issueCount(); ++i) {
+            const auto issue = release.issue(i);
             spdlog::info("\t\tissue");
-            spdlog::info("\t\t\ttype: {}", issueTypeToString(type));
-            if (!url.empty()) spdlog::info("\t\t\turl: {}", url);
-            if (!value.empty()) spdlog::info("\t\t\tvalue: {}", value);
+            spdlog::info("\t\t\ttype: {}", issueTypeToString(issue.type()));
+            if (!issue.url().empty()) spdlog::info("\t\t\turl: {}", issue.url());
+            if (!issue.value().empty()) spdlog::info("\t\t\tvalue: {}", issue.value());
         }
-        for (const auto &[location, checksum, size]: artifacts) {
+        for (size_t i = 0; i < release.artifactCount(); ++i) {
+            const auto artifact = release.artifact(i);
             spdlog::info("\t\tartifact");
-            if (!location.empty()) spdlog::info("\t\t\tlocation: {}", location);
-            if (!checksum.empty()) {
-                for (const auto &[key, value]: checksum) {
-                    spdlog::info("\t\t\tchecksum: {} = {}", key, value);
-                }
+            if (!artifact.location().empty()) spdlog::info("\t\t\tlocation: {}", artifact.location());
+            for (size_t j = 0; j < artifact.checksumCount(); ++j) {
+                const auto checksum = artifact.checksum(j);
+                spdlog::info("\t\t\tchecksum: {} = {}", ReleaseStore::checksumTypeToString(checksum.type),
+                             checksum.hex());
             }
-            if (!size.empty()) {
-                for (const auto &[key, value]: size) {
-                    spdlog::info("\t\t\tsize: {} = {}", key, value);
+            for (const auto kind: {ReleaseStore::SizeKind::DOWNLOAD, ReleaseStore::SizeKind::INSTALLED}) {
+                if (const auto size = artifact.size(kind); size != ReleaseStore::kNoSize) {
+                    spdlog::info("\t\t\tsize: {} = {}", ReleaseStore::sizeKindToString(kind), size);
                 }
             }
         }
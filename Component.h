@@ -17,14 +17,42 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 
+#include "AppStreamExport.h"
+#include "ContentRating.h"
+
+#include <cstdint>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+class ReleaseStore;
 
-class Component {
+class AS_EXPORT Component {
 public:
+    /// Marks a description that is held inline rather than in the parser's compressed text store.
+    static constexpr uint32_t kNoTextHandle = 0xffffffff;
+
+    enum class ComponentType {
+        UNKNOWN = 0,
+        GENERIC,
+        DESKTOP_APPLICATION,
+        CONSOLE_APPLICATION,
+        WEB_APPLICATION,
+        SERVICE,
+        ADDON,
+        RUNTIME,
+        FONT,
+        CODEC,
+        INPUT_METHOD,
+        OPERATING_SYSTEM,
+        FIRMWARE,
+        DRIVER,
+        LOCALIZATION,
+        REPOSITORY,
+        ICON_THEME
+    };
+
     enum class BundleType {
         UNKNOWN = 0,
         PACKAGE,
@@ -124,31 +152,23 @@ public:
         CVE
     };
 
-    struct Artifact {
-        std::string location;
-        std::unordered_map<std::string, std::string> checksum;
-        std::unordered_map<std::string, size_t> size;
-    };
-
-    struct Issue {
-        IssueType type;
-        std::string url;
-        std::string value;
-    };
-
-    struct Release {
-        ReleaseType type;
-        std::string version;
-        std::string date;
-        std::string timestamp;
-        std::string date_eol;
-        ReleaseUrgency urgency;
-        std::string description;
-        std::string url;
-        std::vector<Issue> issues;
-        std::vector<Artifact> artifacts;
+    /**
+     * @brief Releases of a component within the catalog's ReleaseStore; read them with ReleaseStore::releases().
+     *
+     * The range points into the store owned by the parser, so a component that
+     * outlives its parser (a kept query result, a previous CatalogHandle
+     * generation) must not read its releases any more.
+     */
+    struct ReleaseRange {
+        const ReleaseStore *store = nullptr;
+        uint32_t first = 0;
+        uint32_t count = 0;
+
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
     };
 
+    ComponentType type;
     std::string id;
     std::string pkgname;
     std::string source_pkgname;
@@ -156,6 +176,7 @@ public:
     std::string summary;
     std::string projectLicense;
     std::string description;
+    uint32_t descriptionHandle = kNoTextHandle;
 
     struct {
         std::string homepage;
@@ -190,45 +211,54 @@ public:
     std::string media_baseurl;
     std::string architecture;
     Bundle bundle;
+    /// Rating scheme of <content_rating>, e.g. "oars-1.1".
     std::string content_rating;
+    ContentRating contentRating;
     std::string agreement;
     std::vector<std::string> keywords;
     std::vector<std::string> categories;
     std::vector<std::string> suggests;
-    std::vector<Release> releases;
+    ReleaseRange releases;
     std::vector<std::string> supportedLanguages;
 
     void Dump() const;
 
+    /// Approximate heap and object bytes held by this component, used for memory budgeting.
+    [[nodiscard]] size_t memoryFootprint() const;
+
     void addSupportedLanguage(const std::string &language);
 
-    static BundleType stringToBundleType(const std::string &typeStr);
+    static ComponentType stringToComponentType(std::string_view typeStr);
+
+    static BundleType stringToBundleType(std::string_view typeStr);
+
+    static IconType stringToIconType(std::string_view typeStr);
 
-    static IconType stringToIconType(const std::string &typeStr);
+    static CompulsoryForDesktop stringToCompulsoryForDesktop(std::string_view desktopString);
 
-    static CompulsoryForDesktop stringToCompulsoryForDesktop(const std::string &desktopString);
+    static UrlType stringToUrlType(std::string_view typeStr);
 
-    static UrlType stringToUrlType(const std::string &typeStr);
+    static LaunchableType stringToLaunchableType(std::string_view typeStr);
 
-    static LaunchableType stringToLaunchableType(const std::string &typeStr);
+    static ReleaseType stringToReleaseType(std::string_view typeStr);
 
-    static ReleaseType stringToReleaseType(const std::string &typeStr);
+    static ReleaseUrgency stringToReleaseUrgency(std::string_view typeStr);
 
-    static ReleaseUrgency stringToReleaseUrgency(const std::string &typeStr);
+    static IssueType stringToIssueType(std::string_view typeStr);
 
-    static IssueType stringToIssueType(const std::string &typeStr);
+    static std::string_view componentTypeToString(ComponentType type);
 
-    static std::string bundleTypeToString(BundleType type);
+    static std::string_view bundleTypeToString(BundleType type);
 
-    static std::string iconTypeToString(IconType type);
+    static std::string_view iconTypeToString(IconType type);
 
-    static std::string compulsoryForDesktopToString(CompulsoryForDesktop desktopEnum);
+    static std::string_view compulsoryForDesktopToString(CompulsoryForDesktop desktopEnum);
 
-    static std::string releaseTypeToString(ReleaseType type);
+    static std::string_view releaseTypeToString(ReleaseType type);
 
-    static std::string releaseUrgencyToString(ReleaseUrgency type);
+    static std::string_view releaseUrgencyToString(ReleaseUrgency type);
 
-    static std::string issueTypeToString(IssueType type);
+    static std::string_view issueTypeToString(IssueType type);
 };
 
 #endif // COMPONENT_H
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ComponentCodec.h"
+#include "ReleaseStore.h"
+#include "TextStore.h"
+
+#include <stdexcept>
+
+namespace {
+class Writer {
+public:
+    explicit Writer(std::string &out) : out_(out) {
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<char>(value));
+    }
+
+    void byte(const uint8_t value) {
+        out_.push_back(static_cast<char>(value));
+    }
+
+    template<typename E>
+    void enumeration(const E value) {
+        byte(static_cast<uint8_t>(value));
+    }
+
+    void string(const std::string_view value) {
+        varint(value.size());
+        out_.append(value);
+    }
+
+    void optionalInt(const std::optional<int> &value) {
+        byte(value.has_value());
+        if (value) {
+            // zigzag
+            varint((static_cast<uint64_t>(*value) << 1) ^ static_cast<uint64_t>(*value >> 31));
+        }
+    }
+
+    void strings(const std::vector<std::string> &values) {
+        varint(values.size());
+        for (const auto &value: values) {
+            string(value);
+        }
+    }
+
+private:
+    std::string &out_;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t *data, const size_t length) : cur_(data), end_(data + length) {
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+        throw std::runtime_error("ComponentCodec: malformed varint");
+    }
+
+    uint8_t byte() {
+        if (cur_ >= end_) {
+            throw std::runtime_error("ComponentCodec: truncated record");
+        }
+        return *cur_++;
+    }
+
+    template<typename E>
+    E enumeration() {
+        return static_cast<E>(byte());
+    }
+
+    std::string string() {
+        return std::string(view());
+    }
+
+    std::string_view view() {
+        const auto length = varint();
+        if (length > static_cast<size_t>(end_ - cur_)) {
+            throw std::runtime_error("ComponentCodec: truncated string");
+        }
+        const std::string_view value(reinterpret_cast<const char *>(cur_), length);
+        cur_ += length;
+        return value;
+    }
+
+    std::optional<int> optionalInt() {
+        if (!byte()) {
+            return std::nullopt;
+        }
+        const auto zigzag = varint();
+        return static_cast<int>((zigzag >> 1) ^ -(zigzag & 1));
+    }
+
+    std::vector<std::string> strings() {
+        std::vector<std::string> values(count());
+        for (auto &value: values) {
+            value = string();
+        }
+        return values;
+    }
+
+    /// Element count, bounded by the remaining input so corrupt data cannot force huge allocations.
+    size_t count() {
+        const auto n = varint();
+        if (n > static_cast<size_t>(end_ - cur_)) {
+            throw std::runtime_error("ComponentCodec: bad element count");
+        }
+        return n;
+    }
+
+private:
+    const uint8_t *cur_;
+    const uint8_t *end_;
+};
+}
+
+void ComponentCodec::encode(const Component &component, std::string &out,
+                            const std::optional<std::string_view> description) {
+    Writer w(out);
+    w.enumeration(component.type);
+    w.string(component.id);
+    w.string(component.pkgname);
+    w.string(component.source_pkgname);
+    w.string(component.name);
+    w.string(component.summary);
+    w.string(component.projectLicense);
+    w.string(description ? *description : component.description);
+    w.varint(description ? Component::kNoTextHandle : component.descriptionHandle);
+
+    w.string(component.url.homepage);
+    w.string(component.url.bugtracker);
+    w.string(component.url.faq);
+    w.string(component.url.help);
+    w.string(component.url.donation);
+    w.string(component.url.translate);
+    w.string(component.url.contact);
+    w.string(component.url.vcs_browser);
+    w.string(component.url.contribute);
+    w.string(component.url.unknown);
+
+    w.string(component.project_group);
+    w.varint(component.icons.size());
+    for (const auto &icon: component.icons) {
+        w.enumeration(icon.type);
+        w.string(icon.value);
+        w.optionalInt(icon.width);
+        w.optionalInt(icon.height);
+        w.optionalInt(icon.scale);
+    }
+    w.varint(component.compulsory_for_desktop.size());
+    for (const auto desktop: component.compulsory_for_desktop) {
+        w.enumeration(desktop);
+    }
+
+    w.string(component.developer.id);
+    w.string(component.developer.name);
+
+    w.enumeration(component.launchable.type);
+    w.string(component.launchable.desktop_id);
+    w.string(component.launchable.service);
+    w.string(component.launchable.cockpit_manifest);
+    w.string(component.launchable.url);
+
+    w.string(component.media_baseurl);
+    w.string(component.architecture);
+    w.string(component.bundle.id);
+    w.enumeration(component.bundle.type);
+    w.string(component.content_rating);
+    w.varint(component.contentRating.bits());
+    w.string(component.agreement);
+    w.strings(component.keywords);
+    w.strings(component.categories);
+    w.strings(component.suggests);
+
+    w.varint(component.releases.first);
+    w.varint(component.releases.count);
+
+    w.strings(component.supportedLanguages);
+}
+
+std::shared_ptr<Component> ComponentCodec::decode(const uint8_t *data, const size_t length,
+                                                  const ReleaseStore *releases) {
+    Reader r(data, length);
+    auto component = std::make_shared<Component>();
+    component->type = r.enumeration<Component::ComponentType>();
+    component->id = r.string();
+    component->pkgname = r.string();
+    component->source_pkgname = r.string();
+    component->name = r.string();
+    component->summary = r.string();
+    component->projectLicense = r.string();
+    component->description = r.string();
+    component->descriptionHandle = static_cast<uint32_t>(r.varint());
+
+    component->url.homepage = r.string();
+    component->url.bugtracker = r.string();
+    component->url.faq = r.string();
+    component->url.help = r.string();
+    component->url.donation = r.string();
+    component->url.translate = r.string();
+    component->url.contact = r.string();
+    component->url.vcs_browser = r.string();
+    component->url.contribute = r.string();
+    component->url.unknown = r.string();
+
+    component->project_group = r.string();
+    component->icons.resize(r.count());
+    for (auto &icon: component->icons) {
+        icon.type = r.enumeration<Component::IconType>();
+        icon.value = r.string();
+        icon.width = r.optionalInt();
+        icon.height = r.optionalInt();
+        icon.scale = r.optionalInt();
+    }
+    component->compulsory_for_desktop.resize(r.count());
+    for (auto &desktop: component->compulsory_for_desktop) {
+        desktop = r.enumeration<Component::CompulsoryForDesktop>();
+    }
+
+    component->developer.id = r.string();
+    component->developer.name = r.string();
+
+    component->launchable.type = r.enumeration<Component::LaunchableType>();
+    component->launchable.desktop_id = r.string();
+    component->launchable.service = r.string();
+    component->launchable.cockpit_manifest = r.string();
+    component->launchable.url = r.string();
+
+    component->media_baseurl = r.string();
+    component->architecture = r.string();
+    component->bundle.id = r.string();
+    component->bundle.type = r.enumeration<Component::BundleType>();
+    component->content_rating = r.string();
+    component->contentRating = ContentRating::fromBits(r.varint());
+    component->agreement = r.string();
+    component->keywords = r.strings();
+    component->categories = r.strings();
+    component->suggests = r.strings();
+
+    component->releases.store = releases;
+    component->releases.first = static_cast<uint32_t>(r.varint());
+    component->releases.count = static_cast<uint32_t>(r.varint());
+
+    component->supportedLanguages = r.strings();
+    return component;
+}
+
+void ComponentCodec::encodeReleases(const Component &component, std::string &out, const TextStore *text,
+                                    std::string *scratch) {
+    Writer w(out);
+    std::string local;
+    auto &description = scratch ? *scratch : local;
+    const auto releases = ReleaseStore::releases(component);
+    w.varint(releases.size());
+    for (const auto release: releases) {
+        w.enumeration(release.type());
+        w.string(release.version());
+        w.string(release.date());
+        w.string(release.timestamp());
+        w.string(release.dateEol());
+        w.enumeration(release.urgency());
+        if (text && release.descriptionHandle() != Component::kNoTextHandle) {
+            text->get(release.descriptionHandle(), description);
+            w.string(description);
+        } else {
+            w.string(release.description());
+        }
+        w.string(release.url());
+        w.varint(release.issueCount());
+        for (size_t i = 0; i < release.issueCount(); ++i) {
+            const auto issue = release.issue(i);
+            w.enumeration(issue.type());
+            w.string(issue.url());
+            w.string(issue.value());
+        }
+        w.varint(release.artifactCount());
+        for (size_t i = 0; i < release.artifactCount(); ++i) {
+            const auto artifact = release.artifact(i);
+            w.string(artifact.location());
+            w.varint(artifact.checksumCount());
+            for (size_t j = 0; j < artifact.checksumCount(); ++j) {
+                const auto checksum = artifact.checksum(j);
+                w.enumeration(checksum.type);
+                w.string({reinterpret_cast<const char *>(checksum.digest), checksum.length});
+            }
+            // kNoSize wraps to 0, so absent sizes cost one byte
+            w.varint(artifact.size(ReleaseStore::SizeKind::DOWNLOAD) + 1);
+            w.varint(artifact.size(ReleaseStore::SizeKind::INSTALLED) + 1);
+        }
+    }
+}
+
+void ComponentCodec::decodeReleases(const uint8_t *data, const size_t length, ReleaseStore &store,
+                                    Component &component) {
+    Reader r(data, length);
+    const auto first = store.size();
+    const auto count = r.count();
+    for (size_t i = 0; i < count; ++i) {
+        const auto type = r.enumeration<Component::ReleaseType>();
+        const auto version = r.view();
+        const auto date = r.view();
+        const auto timestamp = r.view();
+        const auto dateEol = r.view();
+        store.addRelease(type, r.enumeration<Component::ReleaseUrgency>());
+        store.setField(ReleaseStore::Field::VERSION, version);
+        store.setField(ReleaseStore::Field::DATE, date);
+        store.setField(ReleaseStore::Field::TIMESTAMP, timestamp);
+        store.setField(ReleaseStore::Field::DATE_EOL, dateEol);
+        store.setField(ReleaseStore::Field::DESCRIPTION, r.view());
+        store.setField(ReleaseStore::Field::URL, r.view());
+        for (size_t issues = r.count(); issues > 0; --issues) {
+            const auto issueType = r.enumeration<Component::IssueType>();
+            const auto url = r.view();
+            store.addIssue(issueType, url, r.view());
+        }
+        for (size_t artifacts = r.count(); artifacts > 0; --artifacts) {
+            store.addArtifact();
+            store.setLocation(r.view());
+            for (size_t checksums = r.count(); checksums > 0; --checksums) {
+                const auto checksumType = r.enumeration<ReleaseStore::ChecksumType>();
+                const auto digest = r.view();
+                if (digest.size() != ReleaseStore::digestLength(checksumType)) {
+                    throw std::runtime_error("ComponentCodec: bad digest length");
+                }
+                store.addChecksum(checksumType, reinterpret_cast<const uint8_t *>(digest.data()));
+            }
+            store.setSize(ReleaseStore::SizeKind::DOWNLOAD, r.varint() - 1);
+            store.setSize(ReleaseStore::SizeKind::INSTALLED, r.varint() - 1);
+        }
+    }
+    component.releases = {&store, first, store.size() - first};
+}
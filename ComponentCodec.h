@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPONENTCODEC_H
+#define COMPONENTCODEC_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+
+class TextStore;
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+
+/**
+ * @brief Compact binary encoding of a Component.
+ *
+ * Strings and containers are length-prefixed with LEB128 varints and enums are
+ * single bytes. The encoding carries no schema version; it is meant for data
+ * written and read by the same build (spill files, caches).
+ *
+ * Releases are encoded as the component's range in its ReleaseStore, which
+ * only means something within the same catalog; encodeReleases() writes
+ * their contents for output that must stand alone.
+ */
+class AS_EXPORT ComponentCodec {
+public:
+    /// Appends the encoding of component to out. A description, when given, is written in place of the
+    /// component's own, as if it had never been moved to a TextStore.
+    static void encode(const Component &component, std::string &out,
+                       std::optional<std::string_view> description = std::nullopt);
+
+    /// Decodes a record produced by encode(); throws std::runtime_error on truncated input.
+    /// The release range is bound to releases.
+    static std::shared_ptr<Component> decode(const uint8_t *data, size_t length,
+                                             const ReleaseStore *releases = nullptr);
+
+    /// Appends the releases of component with their issues and artifacts; checksums
+    /// are written as an algorithm byte and the binary digest. Descriptions held
+    /// in text are inflated, into scratch when given so that its buffer is reused.
+    static void encodeReleases(const Component &component, std::string &out, const TextStore *text = nullptr,
+                               std::string *scratch = nullptr);
+
+    /// Appends releases written by encodeReleases() to store and points the component's range at them;
+    /// throws std::runtime_error on truncated input.
+    static void decodeReleases(const uint8_t *data, size_t length, ReleaseStore &store, Component &component);
+};
+
+#endif // COMPONENTCODEC_H
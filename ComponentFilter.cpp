@@ -0,0 +1,94 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ComponentFilter.h"
+
+#include <algorithm>
+
+bool ComponentFilter::empty() const {
+    return types.empty() && bundleTypes.empty() && architectures.empty() && idPrefixes.empty() && !predicate;
+}
+
+std::string_view ComponentFilter::architectureOf(const Component &component) {
+    if (!component.architecture.empty()) {
+        return component.architecture;
+    }
+    if (component.bundle.type != Component::BundleType::FLATPAK) {
+        return {};
+    }
+    // Flatpak refs are kind/name/arch/branch
+    const std::string_view ref = component.bundle.id;
+    const auto first = ref.find('/');
+    const auto second = first == std::string_view::npos ? first : ref.find('/', first + 1);
+    if (second == std::string_view::npos) {
+        return {};
+    }
+    const auto third = ref.find('/', second + 1);
+    return ref.substr(second + 1, third == std::string_view::npos ? third : third - second - 1);
+}
+
+bool ComponentFilter::accept(const Component &component, const Stage stage) const {
+    const auto idAllowed = [&] {
+        return std::any_of(idPrefixes.begin(), idPrefixes.end(), [&](const std::string &p) {
+            return component.id.compare(0, p.size(), p) == 0;
+        });
+    };
+    const auto architectureAllowed = [&] {
+        const auto arch = architectureOf(component);
+        return std::find(architectures.begin(), architectures.end(), arch) != architectures.end();
+    };
+
+    switch (stage) {
+        case Stage::TYPE:
+            if (!types.empty() && std::find(types.begin(), types.end(), component.type) == types.end()) {
+                return false;
+            }
+            break;
+        case Stage::ID:
+            if (!idPrefixes.empty() && !idAllowed()) {
+                return false;
+            }
+            break;
+        case Stage::BUNDLE:
+            if (!bundleTypes.empty() &&
+                std::find(bundleTypes.begin(), bundleTypes.end(), component.bundle.type) == bundleTypes.end()) {
+                return false;
+            }
+            if (!architectures.empty() && !architectureOf(component).empty() && !architectureAllowed()) {
+                return false;
+            }
+            break;
+        case Stage::ARCHITECTURE:
+            if (!architectures.empty() && !architectureAllowed()) {
+                return false;
+            }
+            break;
+        case Stage::END:
+            // Fields that were required but never showed up
+            if (!idPrefixes.empty() && !idAllowed()) {
+                return false;
+            }
+            if (!bundleTypes.empty() &&
+                std::find(bundleTypes.begin(), bundleTypes.end(), component.bundle.type) == bundleTypes.end()) {
+                return false;
+            }
+            if (!architectures.empty() && !architectureAllowed()) {
+                return false;
+            }
+            break;
+    }
+    return !predicate || predicate(component, stage);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPONENTFILTER_H
+#define COMPONENTFILTER_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Parse-time component filter.
+ *
+ * Each criterion is checked as soon as the field it depends on has been
+ * parsed; a rejected component is skipped up to its closing tag without
+ * materializing the remaining fields. Empty criteria accept everything.
+ */
+struct AS_EXPORT ComponentFilter {
+    /// Point in a component at which the filter is evaluated.
+    enum class Stage {
+        TYPE, // <component type=...> opened
+        ID, // </id>
+        BUNDLE, // </bundle>
+        ARCHITECTURE, // </architecture>
+        END // </component>, before the component is stored
+    };
+
+    std::vector<Component::ComponentType> types;
+    /// Components without a bundle are rejected when set.
+    std::vector<Component::BundleType> bundleTypes;
+    /// Matched against <architecture> or the arch of a flatpak bundle ref;
+    /// components with neither are rejected when set.
+    std::vector<std::string> architectures;
+    /// Components without an <id> are rejected when set.
+    std::vector<std::string> idPrefixes;
+    /// Custom check on the partially parsed component, run at every stage; return false to reject.
+    std::function<bool(const Component &, Stage)> predicate;
+
+    [[nodiscard]] bool empty() const;
+
+    [[nodiscard]] bool accept(const Component &component, Stage stage) const;
+
+    /// Architecture of a component: <architecture>, else the arch of its flatpak ref.
+    static std::string_view architectureOf(const Component &component);
+};
+
+#endif // COMPONENTFILTER_H
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ContentRating.h"
+
+#include <iterator>
+
+namespace {
+// OARS 1.1 attribute IDs; the index is the lane in the packed word
+constexpr std::string_view kAttributes[ContentRating::kAttributeCount] = {
+    "violence-cartoon", "violence-fantasy", "violence-realistic", "violence-bloodshed", "violence-sexual",
+    "violence-desecration", "violence-slavery", "violence-worship", "drugs-alcohol", "drugs-narcotics",
+    "drugs-tobacco", "sex-nudity", "sex-themes", "sex-homosexuality", "sex-prostitution", "sex-adultery",
+    "sex-appearance", "language-profanity", "language-humor", "language-discrimination", "social-chat",
+    "social-info", "social-audio", "social-location", "social-contacts", "money-purchasing", "money-gambling",
+    "money-advertising"
+};
+
+constexpr std::string_view kIntensities[] = {"none", "mild", "moderate", "intense"};
+}
+
+ContentRating ContentRating::uniform(const Intensity intensity) {
+    return fromBits(kLowBits * static_cast<uint64_t>(intensity));
+}
+
+void ContentRating::set(const size_t attribute, const Intensity intensity) {
+    const auto shift = 2 * attribute;
+    bits_ = (bits_ & ~(uint64_t{3} << shift)) | static_cast<uint64_t>(intensity) << shift;
+}
+
+bool ContentRating::set(const std::string_view id, const std::string_view intensity) {
+    const auto attribute = attributeIndex(id);
+    const auto value = stringToIntensity(intensity);
+    if (!attribute || !value) {
+        return false;
+    }
+    set(*attribute, *value);
+    return true;
+}
+
+void ContentRating::filter(const uint64_t *ratings, const size_t count, const ContentRating &limit,
+                           const bool includeUnrated, std::vector<uint32_t> &out) {
+    const auto start = out.size();
+    out.resize(start + count);
+    auto *cursor = out.data() + start;
+    const uint64_t required = includeUnrated ? 0 : kRatedBit;
+    for (size_t i = 0; i < count; ++i) {
+        const auto rating = ratings[i];
+        // Write unconditionally, advance only on a pass
+        *cursor = static_cast<uint32_t>(i);
+        cursor += (exceededLanes(rating, limit.bits_) == 0) & ((rating & required) == required);
+    }
+    out.resize(static_cast<size_t>(cursor - out.data()));
+}
+
+std::optional<size_t> ContentRating::attributeIndex(const std::string_view id) {
+    for (size_t i = 0; i < kAttributeCount; ++i) {
+        if (kAttributes[i] == id) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view ContentRating::attributeId(const size_t attribute) {
+    return attribute < kAttributeCount ? kAttributes[attribute] : std::string_view{};
+}
+
+std::optional<ContentRating::Intensity> ContentRating::stringToIntensity(const std::string_view intensity) {
+    for (size_t i = 0; i < std::size(kIntensities); ++i) {
+        if (kIntensities[i] == intensity) {
+            return static_cast<Intensity>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view ContentRating::intensityToString(const Intensity intensity) {
+    return kIntensities[static_cast<size_t>(intensity) & 3];
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CONTENTRATING_H
+#define CONTENTRATING_H
+
+#include "AppStreamExport.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief OARS content rating packed into one 64-bit word.
+ *
+ * Each of the 28 OARS 1.1 attributes takes 2 bits holding its intensity;
+ * attributes a rating does not list are NONE, as the OARS spec defines. The
+ * top bit marks components that carry a <content_rating> at all.
+ *
+ * filter() compares all attributes of a rating against a limit at once with
+ * bitwise arithmetic on the packed words, so a whole catalog is filtered in
+ * one branch-free pass.
+ */
+class AS_EXPORT ContentRating {
+public:
+    enum class Intensity : uint8_t { NONE = 0, MILD, MODERATE, INTENSE };
+
+    static constexpr size_t kAttributeCount = 28;
+
+    /// Rating with every attribute at intensity, e.g. a limit that only restricts what is set afterwards.
+    static ContentRating uniform(Intensity intensity);
+
+    [[nodiscard]] bool rated() const { return bits_ & kRatedBit; }
+
+    void setRated() { bits_ |= kRatedBit; }
+
+    [[nodiscard]] Intensity get(const size_t attribute) const {
+        return static_cast<Intensity>(bits_ >> (2 * attribute) & 3);
+    }
+
+    void set(size_t attribute, Intensity intensity);
+
+    /// Sets an attribute from its OARS ID and intensity name; returns false if either is unknown.
+    bool set(std::string_view id, std::string_view intensity);
+
+    [[nodiscard]] uint64_t bits() const { return bits_; }
+
+    static ContentRating fromBits(const uint64_t bits) {
+        ContentRating rating;
+        rating.bits_ = bits;
+        return rating;
+    }
+
+    /// Whether any attribute is more intense than in limit.
+    [[nodiscard]] bool exceeds(const ContentRating &limit) const { return exceededLanes(bits_, limit.bits_) != 0; }
+
+    /**
+     * @brief Appends the indices of the ratings that stay within limit.
+     *
+     * @param ratings Packed ratings, e.g. one per ordinal.
+     * @param count Number of ratings.
+     * @param limit Highest allowed intensity per attribute.
+     * @param includeUnrated Whether ratings without a <content_rating> pass.
+     * @param out Receives the passing indices in ascending order.
+     */
+    static void filter(const uint64_t *ratings, size_t count, const ContentRating &limit, bool includeUnrated,
+                       std::vector<uint32_t> &out);
+
+    static std::optional<size_t> attributeIndex(std::string_view id);
+
+    static std::string_view attributeId(size_t attribute);
+
+    static std::optional<Intensity> stringToIntensity(std::string_view intensity);
+
+    static std::string_view intensityToString(Intensity intensity);
+
+private:
+    static constexpr uint64_t kRatedBit = uint64_t{1} << 63;
+    // Low bit of every attribute lane
+    static constexpr uint64_t kLowBits = 0x0055555555555555;
+
+    uint64_t bits_ = 0;
+
+    /// Low bit set in each lane where a > b.
+    static uint64_t exceededLanes(const uint64_t a, const uint64_t b) {
+        const uint64_t aHigh = a >> 1 & kLowBits;
+        const uint64_t bHigh = b >> 1 & kLowBits;
+        const uint64_t aLow = a & kLowBits;
+        const uint64_t bLow = b & kLowBits;
+        // Higher high bit, or equal high bits and a higher low bit
+        return (aHigh & ~bHigh) | (~(aHigh ^ bHigh) & aLow & ~bLow);
+    }
+};
+
+#endif // CONTENTRATING_H
@@ -0,0 +1,569 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "DiskCatalog.h"
+#include "ComponentCodec.h"
+#include "ReleaseStore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <queue>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char kMagic[] = "ASD1";
+constexpr size_t kMagicLength = 4;
+constexpr char kDataFile[] = "components.dat";
+constexpr char kIdIndex[] = "ids";
+constexpr char kCategoryIndex[] = "categories";
+constexpr char kKeywordIndex[] = "keywords";
+constexpr size_t kFileBuffer = 64 * 1024;
+
+using File = std::unique_ptr<std::FILE, int (*)(std::FILE *)>;
+
+File openFile(const std::string &path, const char *mode) {
+    File file(std::fopen(path.c_str(), mode), &std::fclose);
+    if (!file) {
+        throw std::runtime_error("DiskCatalog: cannot open " + path);
+    }
+    std::setvbuf(file.get(), nullptr, _IOFBF, kFileBuffer);
+    return file;
+}
+
+void writeAll(std::FILE *file, const void *data, const size_t length) {
+    if (std::fwrite(data, 1, length, file) != length) {
+        throw std::runtime_error("DiskCatalog: write failed");
+    }
+}
+
+void closeFile(File &file) {
+    if (std::fclose(file.release()) != 0) {
+        throw std::runtime_error("DiskCatalog: write failed");
+    }
+}
+
+void putVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const uint8_t *&cur, const uint8_t *end, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cur < end; shift += 7) {
+        const uint8_t b = *cur++;
+        value |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool getVarint(std::FILE *file, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int c = std::getc(file);
+        if (c == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Index entry: a key, a secondary key ordering entries of equal key, and a data file offset.
+struct EntryView {
+    std::string_view key;
+    std::string_view secondary;
+    uint64_t offset = 0;
+};
+
+bool operator<(const EntryView &a, const EntryView &b) {
+    return a.key != b.key ? a.key < b.key : a.secondary < b.secondary;
+}
+
+void putEntry(std::string &out, const std::string_view key, const std::string_view secondary, const uint64_t offset) {
+    putVarint(out, key.size());
+    out.append(key);
+    putVarint(out, secondary.size());
+    out.append(secondary);
+    putVarint(out, offset);
+}
+
+bool getString(const uint8_t *&cur, const uint8_t *end, std::string_view &value) {
+    uint64_t length;
+    if (!getVarint(cur, end, length) || length > static_cast<uint64_t>(end - cur)) {
+        return false;
+    }
+    value = {reinterpret_cast<const char *>(cur), static_cast<size_t>(length)};
+    cur += length;
+    return true;
+}
+
+bool getEntry(const uint8_t *cur, const uint8_t *end, EntryView &entry) {
+    return getString(cur, end, entry.key) && getString(cur, end, entry.secondary) &&
+           getVarint(cur, end, entry.offset);
+}
+
+/// Sequential reader of a spilled run.
+class RunReader {
+public:
+    explicit RunReader(const std::string &path) : file_(openFile(path, "rb")) {
+    }
+
+    /// Reads the next entry into key, secondary and offset; false at the end.
+    bool next() {
+        return readString(key) && readString(secondary) && getVarint(file_.get(), offset);
+    }
+
+    std::string key;
+    std::string secondary;
+    uint64_t offset = 0;
+
+private:
+    File file_;
+
+    bool readString(std::string &value) {
+        uint64_t length;
+        if (!getVarint(file_.get(), length)) {
+            return false;
+        }
+        value.resize(length);
+        return std::fread(value.data(), 1, length, file_.get()) == length;
+    }
+};
+
+/**
+ * Index entries collected in memory and spilled as sorted runs once the
+ * caller's budget is reached; finish() merges the runs into the index files.
+ */
+class IndexBuilder {
+public:
+    explicit IndexBuilder(std::string path) : path_(std::move(path)) {
+    }
+
+    void add(const std::string_view key, const std::string_view secondary, const uint64_t offset) {
+        entries_.push_back(static_cast<uint32_t>(buffer_.size()));
+        putEntry(buffer_, key, secondary, offset);
+    }
+
+    [[nodiscard]] size_t bytes() const { return buffer_.capacity() + entries_.capacity() * sizeof(uint32_t); }
+
+    /// Runs spilled so far, not counting those written while merging.
+    [[nodiscard]] size_t runs() const { return spilled_; }
+
+    /// Sorts the collected entries and writes them as a run; entries of equal keys keep their order.
+    void spill() {
+        if (entries_.empty()) {
+            return;
+        }
+        const auto *base = reinterpret_cast<const uint8_t *>(buffer_.data());
+        const auto *end = base + buffer_.size();
+        const auto entryAt = [&](const uint32_t at) {
+            EntryView entry;
+            getEntry(base + at, end, entry);
+            return entry;
+        };
+        std::stable_sort(entries_.begin(), entries_.end(), [&](const uint32_t a, const uint32_t b) {
+            return entryAt(a) < entryAt(b);
+        });
+        auto path = path_ + ".run" + std::to_string(nextRun_++);
+        auto file = openFile(path, "wb");
+        std::string entry;
+        for (const auto at: entries_) {
+            const auto view = entryAt(at);
+            entry.clear();
+            putEntry(entry, view.key, view.secondary, view.offset);
+            writeAll(file.get(), entry.data(), entry.size());
+        }
+        closeFile(file);
+        runs_.push_back(std::move(path));
+        ++spilled_;
+        // Release the memory rather than keep the peak capacity around
+        std::string().swap(buffer_);
+        std::vector<uint32_t>().swap(entries_);
+    }
+
+    /**
+     * Merges the runs into <path>.idx, the entries back to back, and <path>.off,
+     * one uint64_t entry offset each. With unique set only the first entry of
+     * each key is kept. Returns the number of entries dropped.
+     */
+    size_t finish(const bool unique, uint64_t &bytes) {
+        spill();
+        // Merge consecutive groups of runs in passes, so that at most kMaxFanIn runs (and their
+        // stdio buffers) are open at once. Merged runs keep their place, so ties still resolve in parse order.
+        std::string entry;
+        while (runs_.size() > kMaxFanIn) {
+            std::vector<std::string> merged;
+            for (size_t first = 0; first < runs_.size(); first += kMaxFanIn) {
+                const auto last = std::min(first + kMaxFanIn, runs_.size());
+                if (last - first == 1) {
+                    merged.push_back(std::move(runs_[first]));
+                    continue;
+                }
+                auto path = path_ + ".run" + std::to_string(nextRun_++);
+                auto file = openFile(path, "wb");
+                merge(first, last, [&](const RunReader &reader) {
+                    entry.clear();
+                    putEntry(entry, reader.key, reader.secondary, reader.offset);
+                    writeAll(file.get(), entry.data(), entry.size());
+                });
+                closeFile(file);
+                for (auto run = first; run < last; ++run) {
+                    std::filesystem::remove(runs_[run]);
+                }
+                merged.push_back(std::move(path));
+            }
+            runs_ = std::move(merged);
+        }
+
+        auto index = openFile(path_ + ".idx", "wb");
+        auto offsets = openFile(path_ + ".off", "wb");
+        uint64_t position = 0;
+        size_t dropped = 0;
+        bool first = true;
+        std::string last;
+        merge(0, runs_.size(), [&](const RunReader &reader) {
+            if (unique && !first && reader.key == last) {
+                ++dropped;
+                return;
+            }
+            entry.clear();
+            putEntry(entry, reader.key, reader.secondary, reader.offset);
+            writeAll(index.get(), entry.data(), entry.size());
+            writeAll(offsets.get(), &position, sizeof(position));
+            position += entry.size();
+            last = reader.key;
+            first = false;
+        });
+        bytes += position + static_cast<uint64_t>(std::ftell(offsets.get()));
+        closeFile(index);
+        closeFile(offsets);
+        for (const auto &run: runs_) {
+            std::filesystem::remove(run);
+        }
+        return dropped;
+    }
+
+private:
+    static constexpr size_t kMaxFanIn = 16;
+
+    std::string path_;
+    std::string buffer_;
+    // Entry start offsets within buffer_
+    std::vector<uint32_t> entries_;
+    std::vector<std::string> runs_;
+    size_t nextRun_ = 0;
+    size_t spilled_ = 0;
+
+    /// Calls emit with every entry of runs [first, last) in order; ties go to the earlier run.
+    template<typename Emit>
+    void merge(const size_t first, const size_t last, Emit &&emit) {
+        std::vector<std::unique_ptr<RunReader> > readers;
+        for (auto run = first; run < last; ++run) {
+            readers.push_back(std::make_unique<RunReader>(runs_[run]));
+        }
+        const auto later = [&](const size_t a, const size_t b) {
+            const EntryView x{readers[a]->key, readers[a]->secondary};
+            const EntryView y{readers[b]->key, readers[b]->secondary};
+            return y < x || (!(x < y) && a > b);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+        for (size_t i = 0; i < readers.size(); ++i) {
+            if (readers[i]->next()) {
+                heap.push(i);
+            }
+        }
+        while (!heap.empty()) {
+            const auto i = heap.top();
+            heap.pop();
+            emit(*readers[i]);
+            if (readers[i]->next()) {
+                heap.push(i);
+            }
+        }
+    }
+};
+
+// A decoded component together with the store holding its releases
+struct DecodedComponent {
+    Component component;
+    ReleaseStore releases;
+};
+}
+
+class DiskCatalog::MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("DiskCatalog: cannot open " + path);
+        }
+        struct stat sb{};
+        if (fstat(fd, &sb) == -1) {
+            close(fd);
+            throw std::runtime_error("DiskCatalog: cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(sb.st_size);
+        if (size_) {
+            void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("DiskCatalog: cannot map " + path);
+            }
+            data_ = static_cast<const uint8_t *>(data);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            munmap(const_cast<uint8_t *>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] const uint8_t *data() const { return data_; }
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// Sorted index files written by IndexBuilder::finish().
+class DiskCatalog::Index {
+public:
+    explicit Index(const std::string &path) : entries_(path + ".idx"), offsets_(path + ".off") {
+        if (offsets_.size() % sizeof(uint64_t)) {
+            throw std::runtime_error("DiskCatalog: malformed index " + path);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return offsets_.size() / sizeof(uint64_t); }
+
+    [[nodiscard]] EntryView entry(const size_t i) const {
+        uint64_t at;
+        std::memcpy(&at, offsets_.data() + i * sizeof(uint64_t), sizeof(at));
+        EntryView entry;
+        if (at >= entries_.size() || !getEntry(entries_.data() + at, entries_.data() + entries_.size(), entry)) {
+            throw std::runtime_error("DiskCatalog: malformed index entry");
+        }
+        return entry;
+    }
+
+    /// Position of the first entry whose key is not less than key.
+    [[nodiscard]] size_t lowerBound(const std::string_view key) const {
+        size_t low = 0;
+        size_t high = size();
+        while (low < high) {
+            const auto mid = low + (high - low) / 2;
+            if (entry(mid).key < key) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    [[nodiscard]] uint64_t bytes() const { return entries_.size() + offsets_.size(); }
+
+private:
+    MappedFile entries_;
+    MappedFile offsets_;
+};
+
+DiskCatalog::BuildStats DiskCatalog::build(const std::string &filename, const std::string &language,
+                                           const std::string &directory, AppStreamParser::Options options,
+                                           const size_t runBytes) {
+    std::filesystem::create_directories(directory);
+    const auto base = std::filesystem::path(directory);
+    auto data = openFile((base / kDataFile).string(), "wb");
+    writeAll(data.get(), kMagic, kMagicLength);
+
+    BuildStats stats;
+    IndexBuilder ids((base / kIdIndex).string());
+    IndexBuilder categories((base / kCategoryIndex).string());
+    IndexBuilder keywords((base / kKeywordIndex).string());
+    uint64_t offset = kMagicLength;
+    std::string codec;
+    std::string releases;
+    std::string record;
+    options.sink = [&](const Component &component) {
+        codec.clear();
+        releases.clear();
+        record.clear();
+        ComponentCodec::encode(component, codec);
+        ComponentCodec::encodeReleases(component, releases);
+        putVarint(record, codec.size());
+        record.append(codec);
+        putVarint(record, releases.size());
+        record.append(releases);
+        writeAll(data.get(), record.data(), record.size());
+
+        ids.add(component.id, {}, offset);
+        for (const auto &category: component.categories) {
+            categories.add(category, component.id, offset);
+        }
+        for (const auto &keyword: component.keywords) {
+            keywords.add(keyword, component.id, offset);
+        }
+        offset += record.size();
+        if (ids.bytes() + categories.bytes() + keywords.bytes() > runBytes) {
+            ids.spill();
+            categories.spill();
+            keywords.spill();
+        }
+    };
+    {
+        const AppStreamParser parser(filename, language, options);
+    }
+    closeFile(data);
+
+    stats.dataBytes = offset;
+    stats.duplicates = ids.finish(true, stats.indexBytes);
+    categories.finish(false, stats.indexBytes);
+    keywords.finish(false, stats.indexBytes);
+    stats.runs = ids.runs() + categories.runs() + keywords.runs();
+    stats.components = DiskCatalog(directory).size();
+    return stats;
+}
+
+DiskCatalog::DiskCatalog(const std::string &directory) {
+    const auto base = std::filesystem::path(directory);
+    data_ = std::make_unique<MappedFile>((base / kDataFile).string());
+    if (data_->size() < kMagicLength || std::memcmp(data_->data(), kMagic, kMagicLength) != 0) {
+        throw std::runtime_error("DiskCatalog: not a catalog data file in " + directory);
+    }
+    ids_ = std::make_unique<Index>((base / kIdIndex).string());
+    categories_ = std::make_unique<Index>((base / kCategoryIndex).string());
+    keywords_ = std::make_unique<Index>((base / kKeywordIndex).string());
+}
+
+DiskCatalog::~DiskCatalog() = default;
+
+size_t DiskCatalog::size() const {
+    return ids_->size();
+}
+
+std::shared_ptr<Component> DiskCatalog::decodeAt(const uint64_t offset) const {
+    const auto *end = data_->data() + data_->size();
+    const auto *cur = data_->data() + std::min<uint64_t>(offset, data_->size());
+    uint64_t codecLength = 0;
+    uint64_t releasesLength = 0;
+    if (!getVarint(cur, end, codecLength) || codecLength > static_cast<uint64_t>(end - cur)) {
+        throw std::runtime_error("DiskCatalog: truncated record");
+    }
+    const auto *codec = cur;
+    cur += codecLength;
+    if (!getVarint(cur, end, releasesLength) || releasesLength > static_cast<uint64_t>(end - cur)) {
+        throw std::runtime_error("DiskCatalog: truncated record");
+    }
+    auto decoded = std::make_shared<DecodedComponent>();
+    decoded->component = std::move(*ComponentCodec::decode(codec, codecLength));
+    ComponentCodec::decodeReleases(cur, releasesLength, decoded->releases, decoded->component);
+    // The component shares ownership of its release store
+    return {decoded, &decoded->component};
+}
+
+std::shared_ptr<Component> DiskCatalog::getComponentAt(const size_t ordinal) const {
+    if (ordinal >= size()) {
+        throw std::out_of_range("DiskCatalog: ordinal out of range");
+    }
+    return decodeAt(ids_->entry(ordinal).offset);
+}
+
+std::optional<size_t> DiskCatalog::findOrdinal(const std::string_view id) const {
+    const auto ordinal = ids_->lowerBound(id);
+    if (ordinal == ids_->size() || ids_->entry(ordinal).key != id) {
+        return std::nullopt;
+    }
+    return ordinal;
+}
+
+std::shared_ptr<Component> DiskCatalog::findComponent(const std::string_view id) const {
+    const auto ordinal = findOrdinal(id);
+    return ordinal ? getComponentAt(*ordinal) : nullptr;
+}
+
+std::string_view DiskCatalog::idAt(const size_t ordinal) const {
+    return ids_->entry(ordinal).key;
+}
+
+std::vector<uint32_t> DiskCatalog::findTerm(const Index &index, const std::string_view term) const {
+    std::vector<uint32_t> ordinals;
+    for (auto i = index.lowerBound(term); i < index.size(); ++i) {
+        const auto entry = index.entry(i);
+        if (entry.key != term) {
+            break;
+        }
+        // Postings of dropped duplicates point at another record than the ID index
+        const auto ordinal = findOrdinal(entry.secondary);
+        if (ordinal && ids_->entry(*ordinal).offset == entry.offset &&
+            (ordinals.empty() || ordinals.back() != *ordinal)) {
+            ordinals.push_back(static_cast<uint32_t>(*ordinal));
+        }
+    }
+    return ordinals;
+}
+
+std::vector<uint32_t> DiskCatalog::findCategory(const std::string_view category) const {
+    return findTerm(*categories_, category);
+}
+
+std::vector<uint32_t> DiskCatalog::findKeyword(const std::string_view keyword) const {
+    return findTerm(*keywords_, keyword);
+}
+
+std::vector<std::shared_ptr<Component> > DiskCatalog::searchByCategory(const std::string_view category) const {
+    std::vector<std::shared_ptr<Component> > components;
+    for (const auto ordinal: findCategory(category)) {
+        components.push_back(getComponentAt(ordinal));
+    }
+    return components;
+}
+
+std::vector<std::shared_ptr<Component> > DiskCatalog::searchByKeyword(const std::string_view keyword) const {
+    std::vector<std::shared_ptr<Component> > components;
+    for (const auto ordinal: findKeyword(keyword)) {
+        components.push_back(getComponentAt(ordinal));
+    }
+    return components;
+}
+
+uint64_t DiskCatalog::diskBytes() const {
+    return data_->size() + ids_->bytes() + categories_->bytes() + keywords_->bytes();
+}
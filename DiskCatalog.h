@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef DISKCATALOG_H
+#define DISKCATALOG_H
+
+#include "AppStreamExport.h"
+#include "AppStreamParser.h"
+#include "Component.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Catalog kept on disk and queried through memory maps.
+ *
+ * build() parses a catalog with AppStreamParser::Options::sink: every component
+ * is encoded into an append-only data file as soon as it is complete and then
+ * released. The ID, category and keyword indexes are built externally: entries
+ * are collected into sorted runs of bounded size, spilled next to the data and
+ * merged, so peak memory during the build does not depend on the catalog size.
+ *
+ * A DiskCatalog opens the finished directory read-only. Ordinals follow ID
+ * order as in AppStreamParser, and components are decoded on every access;
+ * the first of several components with the same ID wins. All const methods may
+ * be called concurrently.
+ */
+class AS_EXPORT DiskCatalog {
+public:
+    struct BuildStats {
+        size_t components = 0;
+        size_t duplicates = 0;
+        size_t runs = 0;
+        uint64_t dataBytes = 0;
+        uint64_t indexBytes = 0;
+    };
+
+    /**
+     * @brief Parses filename into an on-disk catalog in directory, which is created if needed.
+     *
+     * @param options Parser options; the filter applies, the sink is replaced.
+     * @param runBytes Memory for index entries before a sorted run is spilled.
+     * @throws std::runtime_error on parse or I/O errors.
+     */
+    static BuildStats build(const std::string &filename, const std::string &language, const std::string &directory,
+                            AppStreamParser::Options options = {}, size_t runBytes = 8 * 1024 * 1024);
+
+    /// Opens a catalog written by build(); throws std::runtime_error if files are missing or malformed.
+    explicit DiskCatalog(const std::string &directory);
+
+    ~DiskCatalog();
+
+    DiskCatalog(const DiskCatalog &) = delete;
+
+    DiskCatalog &operator=(const DiskCatalog &) = delete;
+
+    [[nodiscard]] size_t size() const;
+
+    /// Decodes the component at ordinal, with its releases.
+    [[nodiscard]] std::shared_ptr<Component> getComponentAt(size_t ordinal) const;
+
+    [[nodiscard]] std::shared_ptr<Component> findComponent(std::string_view id) const;
+
+    [[nodiscard]] std::optional<size_t> findOrdinal(std::string_view id) const;
+
+    /// ID of the component at ordinal, read from the index without decoding the component.
+    [[nodiscard]] std::string_view idAt(size_t ordinal) const;
+
+    /// Ordinals of the components carrying a category, ascending.
+    [[nodiscard]] std::vector<uint32_t> findCategory(std::string_view category) const;
+
+    /// Ordinals of the components carrying a keyword, ascending.
+    [[nodiscard]] std::vector<uint32_t> findKeyword(std::string_view keyword) const;
+
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > searchByCategory(std::string_view category) const;
+
+    [[nodiscard]] std::vector<std::shared_ptr<Component> > searchByKeyword(std::string_view keyword) const;
+
+    /// Bytes of the data file and the three indexes.
+    [[nodiscard]] uint64_t diskBytes() const;
+
+private:
+    class MappedFile;
+    class Index;
+
+    std::unique_ptr<MappedFile> data_;
+    std::unique_ptr<Index> ids_;
+    std::unique_ptr<Index> categories_;
+    std::unique_ptr<Index> keywords_;
+
+    [[nodiscard]] std::vector<uint32_t> findTerm(const Index &index, std::string_view term) const;
+
+    [[nodiscard]] std::shared_ptr<Component> decodeAt(uint64_t offset) const;
+};
+
+#endif // DISKCATALOG_H
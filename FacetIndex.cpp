@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FacetIndex.h"
+
+#include <algorithm>
+
+void FacetIndex::add(const std::vector<std::string> &values, TermDictionary &dictionary) {
+    const auto begin = terms_.size();
+    for (const auto &value: values) {
+        terms_.push_back(dictionary.intern(value));
+    }
+    // A component counts once per term, even if the value is repeated
+    std::sort(terms_.begin() + static_cast<long>(begin), terms_.end());
+    terms_.erase(std::unique(terms_.begin() + static_cast<long>(begin), terms_.end()), terms_.end());
+    termOffsets_.push_back(static_cast<uint32_t>(terms_.size()));
+}
+
+void FacetIndex::finish(const size_t termCount) {
+    terms_.shrink_to_fit();
+    termOffsets_.shrink_to_fit();
+
+    // Counting sort of (term, ordinal) pairs into term-major order
+    postingOffsets_.assign(termCount + 1, 0);
+    for (const auto term: terms_) {
+        ++postingOffsets_[term + 1];
+    }
+    for (size_t term = 0; term < termCount; ++term) {
+        postingOffsets_[term + 1] += postingOffsets_[term];
+    }
+    postings_.resize(terms_.size());
+    std::vector<uint32_t> fill(postingOffsets_.begin(), postingOffsets_.end() - 1);
+    for (uint32_t ordinal = 0; ordinal + 1 < termOffsets_.size(); ++ordinal) {
+        for (auto i = termOffsets_[ordinal]; i < termOffsets_[ordinal + 1]; ++i) {
+            postings_[fill[terms_[i]]++] = ordinal;
+        }
+    }
+
+    histogram_.clear();
+    for (uint32_t term = 0; term < termCount; ++term) {
+        if (const auto count = postingOffsets_[term + 1] - postingOffsets_[term]) {
+            histogram_.push_back({term, count});
+        }
+    }
+    sortByCount(histogram_);
+}
+
+std::vector<FacetCount> FacetIndex::counts(const std::vector<uint32_t> &ordinals) const {
+    // Per-thread scratch sized to the term count; only touched slots are reset
+    thread_local std::vector<uint32_t> scratch;
+    if (scratch.size() < postingOffsets_.size()) {
+        scratch.resize(postingOffsets_.size(), 0);
+    }
+
+    std::vector<FacetCount> result;
+    for (const auto ordinal: ordinals) {
+        for (const auto term: terms(ordinal)) {
+            if (scratch[term]++ == 0) {
+                result.push_back({term, 0});
+            }
+        }
+    }
+    for (auto &entry: result) {
+        entry.count = scratch[entry.term];
+        scratch[entry.term] = 0;
+    }
+    sortByCount(result);
+    return result;
+}
+
+IdRange FacetIndex::postings(const TermDictionary::TermId term) const {
+    if (term + 1 >= postingOffsets_.size()) {
+        return {};
+    }
+    return {postings_.data() + postingOffsets_[term], postings_.data() + postingOffsets_[term + 1]};
+}
+
+IdRange FacetIndex::terms(const uint32_t ordinal) const {
+    return {terms_.data() + termOffsets_.at(ordinal), terms_.data() + termOffsets_.at(ordinal + 1)};
+}
+
+size_t FacetIndex::memoryFootprint() const {
+    return (termOffsets_.capacity() + terms_.capacity() + postingOffsets_.capacity() + postings_.capacity()) *
+           sizeof(uint32_t) + histogram_.capacity() * sizeof(FacetCount);
+}
+
+void FacetIndex::sortByCount(std::vector<FacetCount> &counts) {
+    std::sort(counts.begin(), counts.end(), [](const FacetCount &a, const FacetCount &b) {
+        return a.count != b.count ? a.count > b.count : a.term < b.term;
+    });
+}
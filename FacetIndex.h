@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FACETINDEX_H
+#define FACETINDEX_H
+
+#include "AppStreamExport.h"
+#include "TermDictionary.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/// Number of components carrying a facet term.
+struct FacetCount {
+    TermDictionary::TermId term;
+    uint32_t count;
+};
+
+/// View over a contiguous run of ordinals or term ids.
+struct IdRange {
+    const uint32_t *first = nullptr;
+    const uint32_t *last = nullptr;
+
+    [[nodiscard]] const uint32_t *begin() const { return first; }
+    [[nodiscard]] const uint32_t *end() const { return last; }
+    [[nodiscard]] size_t size() const { return static_cast<size_t>(last - first); }
+    [[nodiscard]] bool empty() const { return first == last; }
+};
+
+/**
+ * @brief Term lists of one multi-valued field (categories or keywords) in CSR form.
+ *
+ * Holds the terms of each component, the components of each term and the
+ * catalog-wide histogram. Components are added in ordinal order, then
+ * finish() builds the reverse direction.
+ */
+class AS_EXPORT FacetIndex {
+public:
+    /// Appends the next component's values, interning them into dictionary.
+    void add(const std::vector<std::string> &values, TermDictionary &dictionary);
+
+    /// Builds postings and the histogram; termCount is the final dictionary size.
+    void finish(size_t termCount);
+
+    /// Heap bytes of the term lists, postings and histogram.
+    [[nodiscard]] size_t memoryFootprint() const;
+
+    /// Catalog-wide counts, most frequent first.
+    [[nodiscard]] const std::vector<FacetCount> &counts() const { return histogram_; }
+
+    /// Counts restricted to the given ordinals, most frequent first. Runs in time
+    /// linear in the number of terms carried by those components.
+    [[nodiscard]] std::vector<FacetCount> counts(const std::vector<uint32_t> &ordinals) const;
+
+    /// Ordinals of the components carrying term, ascending.
+    [[nodiscard]] IdRange postings(TermDictionary::TermId term) const;
+
+    /// Distinct terms of the component at ordinal.
+    [[nodiscard]] IdRange terms(uint32_t ordinal) const;
+
+private:
+    std::vector<uint32_t> termOffsets_{0};
+    std::vector<uint32_t> terms_;
+    std::vector<uint32_t> postingOffsets_;
+    std::vector<uint32_t> postings_;
+    std::vector<FacetCount> histogram_;
+
+    static void sortByCount(std::vector<FacetCount> &counts);
+};
+
+#endif // FACETINDEX_H
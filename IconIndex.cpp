@@ -0,0 +1,99 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IconIndex.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+// Fit tiers, best first: exact pixel size, downscale from a larger icon,
+// theme-resolved (stock or unsized) icon, upscale from a smaller icon.
+constexpr int kTierExact = 4 << 20;
+constexpr int kTierLarger = 3 << 20;
+constexpr int kTierUnsized = 2 << 20;
+constexpr int kTierSmaller = 1 << 20;
+constexpr int kMaxDelta = 0xffff;
+
+int typeRank(const Component::IconType type) {
+    switch (type) {
+        case Component::IconType::CACHED: return 4;
+        case Component::IconType::LOCAL: return 3;
+        case Component::IconType::REMOTE: return 2;
+        case Component::IconType::URL: return 1;
+        default: return 0;
+    }
+}
+}
+
+int IconIndex::score(const Component::Icon &icon, const IconPolicy &policy) {
+    if (!(policy.allowedTypes & IconPolicy::typeMask(icon.type))) {
+        return -1;
+    }
+
+    const int rank = typeRank(icon.type);
+    if (!icon.width && !icon.height) {
+        return kTierUnsized + rank;
+    }
+
+    const int target = policy.size * std::max(policy.scale, 1);
+    const int pixels = (icon.width ? *icon.width : *icon.height) * icon.scale.value_or(1);
+    if (pixels == target) {
+        return kTierExact + rank;
+    }
+
+    const int delta = std::min(std::abs(pixels - target), kMaxDelta);
+    return (pixels > target ? kTierLarger : kTierSmaller) - delta * 8 + rank;
+}
+
+std::string IconIndex::resolvePath(const Component::Icon &icon, const std::string &iconsDirectory) {
+    if (icon.type != Component::IconType::CACHED) {
+        return icon.value;
+    }
+
+    // Cached icons live in <icons>/<width>x<height>[@<scale>]/<name>
+    std::string path = iconsDirectory;
+    path.push_back('/');
+    if (icon.width || icon.height) {
+        path += std::to_string(icon.width ? *icon.width : *icon.height);
+        path.push_back('x');
+        path += std::to_string(icon.height ? *icon.height : *icon.width);
+        if (icon.scale && *icon.scale > 1) {
+            path.push_back('@');
+            path += std::to_string(*icon.scale);
+        }
+        path.push_back('/');
+    }
+    path += icon.value;
+    return path;
+}
+
+IconIndex::IconIndex(const IconPolicy &policy, const size_t componentCount)
+    : policy_(policy), best_(componentCount, kNoIcon), paths_(componentCount) {
+}
+
+void IconIndex::select(const size_t ordinal, const Component &component, const std::string &iconsDirectory) {
+    const auto &icons = component.icons;
+    int bestScore = -1;
+    best_[ordinal] = kNoIcon;
+    for (size_t i = 0; i < icons.size() && i < kNoIcon; ++i) {
+        if (const int s = score(icons[i], policy_); s > bestScore) {
+            bestScore = s;
+            best_[ordinal] = static_cast<uint8_t>(i);
+        }
+    }
+    paths_[ordinal] = best_[ordinal] != kNoIcon ? resolvePath(icons[best_[ordinal]], iconsDirectory) : std::string();
+}
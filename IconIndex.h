@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ICONINDEX_H
+#define ICONINDEX_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Icon selection policy used as the cache key of an IconIndex.
+ *
+ * size and scale describe the tile being rendered (e.g. 64 @ 2 for a 128px
+ * HiDPI tile). allowedTypes is a bitmask built with typeMask().
+ */
+struct IconPolicy {
+    int size = 64;
+    int scale = 1;
+    uint32_t allowedTypes = kAllTypes;
+
+    static constexpr uint32_t kAllTypes = 0xffffffffu;
+
+    static constexpr uint32_t typeMask(Component::IconType type) {
+        return 1u << static_cast<uint32_t>(type);
+    }
+
+    bool operator==(const IconPolicy &other) const {
+        return size == other.size && scale == other.scale && allowedTypes == other.allowedTypes;
+    }
+};
+
+/**
+ * @brief Precomputed best icon per component for a single IconPolicy.
+ *
+ * Entries are indexed by component ordinal (position in ID order). Resolving
+ * a tile is two array lookups; no scoring happens after construction.
+ */
+class AS_EXPORT IconIndex {
+public:
+    static constexpr uint8_t kNoIcon = 0xff;
+
+    IconIndex(const IconPolicy &policy, size_t componentCount);
+
+    /// Scores the icons of the component at ordinal and records the winner.
+    void select(size_t ordinal, const Component &component, const std::string &iconsDirectory);
+
+    [[nodiscard]] const IconPolicy &policy() const { return policy_; }
+
+    [[nodiscard]] size_t size() const { return best_.size(); }
+
+    /// Index into Component::icons of the selected icon, or kNoIcon.
+    [[nodiscard]] uint8_t iconIndex(const size_t ordinal) const { return best_[ordinal]; }
+
+    /// Resolved location of the selected icon: an on-disk path for cached and local
+    /// icons, the URL for remote icons and the icon name for stock icons.
+    [[nodiscard]] const std::string &path(const size_t ordinal) const { return paths_[ordinal]; }
+
+    /// Higher is better; negative when the icon type is not allowed by the policy.
+    static int score(const Component::Icon &icon, const IconPolicy &policy);
+
+    static std::string resolvePath(const Component::Icon &icon, const std::string &iconsDirectory);
+
+private:
+    IconPolicy policy_;
+    std::vector<uint8_t> best_;
+    std::vector<std::string> paths_;
+};
+
+#endif // ICONINDEX_H
@@ -0,0 +1,347 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "LicenseIndex.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+struct KindRule {
+    std::string_view license;
+    uint8_t kinds;
+};
+
+// Checked in order; a rule ending in '-' matches by prefix, others match the ID or the ID followed by '+' or '-'
+constexpr KindRule kRules[] = {
+    {"LicenseRef-proprietary", LicenseIndex::PROPRIETARY},
+    {"LicenseRef-free", LicenseIndex::FREE},
+    {"CC-BY-NC-", LicenseIndex::PROPRIETARY},
+    {"CC-BY-ND-", LicenseIndex::PROPRIETARY},
+    {"CC-BY-SA-", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"CC-BY-", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"AGPL-", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"GPL-", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"GFDL-", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"EUPL-", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"OSL-", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"CECILL-2", LicenseIndex::FREE | LicenseIndex::COPYLEFT},
+    {"LGPL-", LicenseIndex::FREE | LicenseIndex::WEAK_COPYLEFT},
+    {"MPL-", LicenseIndex::FREE | LicenseIndex::WEAK_COPYLEFT},
+    {"EPL-", LicenseIndex::FREE | LicenseIndex::WEAK_COPYLEFT},
+    {"CDDL-", LicenseIndex::FREE | LicenseIndex::WEAK_COPYLEFT},
+    {"MIT", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"0BSD", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"BSD-", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"Apache-", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"Artistic-2.0", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"BSL-1.0", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"CC0-1.0", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"FTL", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"ISC", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"OFL-", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"PSF-2.0", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"Python-2.0", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"Unlicense", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"WTFPL", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"X11", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+    {"Zlib", LicenseIndex::FREE | LicenseIndex::PERMISSIVE},
+};
+
+// Operators are upper case in SPDX; older metadata also writes them in lower case
+bool isOperator(const std::string_view token, const std::string_view op) {
+    return token.size() == op.size() && std::equal(token.begin(), token.end(), op.begin(), [](const char a,
+        const char b) {
+            return std::toupper(static_cast<unsigned char>(a)) == b;
+        });
+}
+
+LicenseIndex::Freedom either(const LicenseIndex::Freedom a, const LicenseIndex::Freedom b) {
+    using Freedom = LicenseIndex::Freedom;
+    if (a == Freedom::FREE || b == Freedom::FREE) {
+        return Freedom::FREE;
+    }
+    return a == Freedom::NON_FREE && b == Freedom::NON_FREE ? Freedom::NON_FREE : Freedom::UNKNOWN;
+}
+
+LicenseIndex::Freedom both(const LicenseIndex::Freedom a, const LicenseIndex::Freedom b) {
+    using Freedom = LicenseIndex::Freedom;
+    if (a == Freedom::NON_FREE || b == Freedom::NON_FREE) {
+        return Freedom::NON_FREE;
+    }
+    return a == Freedom::FREE && b == Freedom::FREE ? Freedom::FREE : Freedom::UNKNOWN;
+}
+}
+
+/// Recursive descent over one expression: or := and ("OR" and)*, and := term ("AND" term)*,
+/// term := "(" or ")" | license ["WITH" exception].
+class LicenseIndex::Compiler {
+public:
+    Compiler(LicenseIndex &index, const std::string_view expression) : index_(index), rest_(expression) {
+        token_ = nextToken();
+    }
+
+    Freedom compile() {
+        auto freedom = parseOr(0);
+        if (!token_.empty()) {
+            failed_ = true;
+        }
+        return failed_ ? Freedom::UNKNOWN : freedom;
+    }
+
+private:
+    static constexpr int kMaxDepth = 32;
+
+    LicenseIndex &index_;
+    std::string_view rest_;
+    std::string_view token_;
+    bool failed_ = false;
+
+    std::string_view nextToken() {
+        const auto start = rest_.find_first_not_of(" \t\r\n");
+        if (start == std::string_view::npos) {
+            rest_ = {};
+            return {};
+        }
+        rest_.remove_prefix(start);
+        const auto length = rest_[0] == '(' || rest_[0] == ')'
+                                ? 1
+                                : std::min(rest_.find_first_of(" \t\r\n()"), rest_.size());
+        const auto token = rest_.substr(0, length);
+        rest_.remove_prefix(length);
+        return token;
+    }
+
+    Freedom parseOr(const int depth) {
+        auto freedom = parseAnd(depth);
+        while (isOperator(token_, "OR")) {
+            token_ = nextToken();
+            freedom = either(freedom, parseAnd(depth));
+        }
+        return freedom;
+    }
+
+    Freedom parseAnd(const int depth) {
+        auto freedom = parseTerm(depth);
+        while (isOperator(token_, "AND")) {
+            token_ = nextToken();
+            freedom = both(freedom, parseTerm(depth));
+        }
+        return freedom;
+    }
+
+    Freedom parseTerm(const int depth) {
+        if (token_ == "(") {
+            if (depth == kMaxDepth) {
+                failed_ = true;
+                token_ = {};
+                return Freedom::UNKNOWN;
+            }
+            token_ = nextToken();
+            const auto freedom = parseOr(depth + 1);
+            if (token_ != ")") {
+                failed_ = true;
+                return Freedom::UNKNOWN;
+            }
+            token_ = nextToken();
+            return freedom;
+        }
+        if (token_.empty() || token_ == ")" || isOperator(token_, "AND") || isOperator(token_, "OR") ||
+            isOperator(token_, "WITH")) {
+            failed_ = true;
+            return Freedom::UNKNOWN;
+        }
+
+        auto license = token_;
+        // LicenseRef-proprietary=https://... carries the license URL
+        if (license.rfind("LicenseRef-", 0) == 0) {
+            license = license.substr(0, license.find('='));
+        }
+        const auto id = index_.licenses_.intern(license);
+        if (id == index_.kinds_.size()) {
+            index_.kinds_.push_back(classify(license));
+        }
+        index_.pending_.push_back(id);
+        token_ = nextToken();
+        // An exception only adds permissions, so it does not change the freedom of the license
+        if (isOperator(token_, "WITH")) {
+            token_ = nextToken();
+            if (token_.empty() || token_ == "(" || token_ == ")") {
+                failed_ = true;
+                return Freedom::UNKNOWN;
+            }
+            token_ = nextToken();
+        }
+
+        const auto kinds = index_.kinds_[id];
+        if (kinds & FREE) {
+            return Freedom::FREE;
+        }
+        return kinds & PROPRIETARY ? Freedom::NON_FREE : Freedom::UNKNOWN;
+    }
+};
+
+void LicenseIndex::add(const std::string_view expression) {
+    const auto first = pending_.size();
+    freedom_.push_back(expression.empty() ? Freedom::UNKNOWN : Compiler(*this, expression).compile());
+    std::sort(pending_.begin() + static_cast<std::ptrdiff_t>(first), pending_.end());
+    pending_.erase(std::unique(pending_.begin() + static_cast<std::ptrdiff_t>(first), pending_.end()),
+                   pending_.end());
+    pendingOffsets_.push_back(static_cast<uint32_t>(pending_.size()));
+}
+
+void LicenseIndex::finish() {
+    words_ = (licenses_.size() + 63) / 64;
+    bits_.assign(size() * words_, 0);
+    for (size_t ordinal = 0; ordinal < size(); ++ordinal) {
+        auto *row = bits_.data() + ordinal * words_;
+        for (auto i = pendingOffsets_[ordinal]; i < pendingOffsets_[ordinal + 1]; ++i) {
+            row[pending_[i] / 64] |= uint64_t{1} << (pending_[i] % 64);
+        }
+    }
+    std::vector<LicenseId>().swap(pending_);
+    std::vector<uint32_t>{0}.swap(pendingOffsets_);
+}
+
+size_t LicenseIndex::memoryFootprint() const {
+    return licenses_.memoryFootprint() + kinds_.capacity() + freedom_.capacity() * sizeof(Freedom) +
+           pending_.capacity() * sizeof(LicenseId) + pendingOffsets_.capacity() * sizeof(uint32_t) +
+           bits_.capacity() * sizeof(uint64_t);
+}
+
+std::vector<LicenseIndex::LicenseId> LicenseIndex::licenses(const uint32_t ordinal) const {
+    std::vector<LicenseId> ids;
+    const auto *row = bits_.data() + ordinal * words_;
+    for (size_t word = 0; word < words_; ++word) {
+        for (auto bits = row[word]; bits != 0; bits &= bits - 1) {
+            ids.push_back(static_cast<LicenseId>(word * 64 + static_cast<size_t>(__builtin_ctzll(bits))));
+        }
+    }
+    return ids;
+}
+
+std::vector<uint64_t> LicenseIndex::mask(const uint8_t kinds) const {
+    std::vector<uint64_t> mask(words_, 0);
+    for (LicenseId id = 0; id < kinds_.size(); ++id) {
+        if (kinds_[id] & kinds) {
+            mask[id / 64] |= uint64_t{1} << (id % 64);
+        }
+    }
+    return mask;
+}
+
+std::vector<uint64_t> LicenseIndex::mask(const std::string_view license) const {
+    std::vector<uint64_t> mask(words_, 0);
+    if (const auto id = licenses_.find(license)) {
+        mask[*id / 64] |= uint64_t{1} << (*id % 64);
+    }
+    return mask;
+}
+
+std::vector<uint32_t> LicenseIndex::referencing(const std::vector<uint64_t> &mask) const {
+    return scan(mask, true);
+}
+
+std::vector<uint32_t> LicenseIndex::excluding(const std::vector<uint64_t> &mask) const {
+    return scan(mask, false);
+}
+
+std::vector<uint32_t> LicenseIndex::scan(const std::vector<uint64_t> &mask, const bool match) const {
+    std::vector<uint32_t> ordinals(size());
+    auto *cursor = ordinals.data();
+    if (words_ == 1) {
+        // Fewer than 65 distinct licenses, the common case: one word per component
+        const auto bits = mask.empty() ? 0 : mask[0];
+        for (size_t ordinal = 0; ordinal < size(); ++ordinal) {
+            // Write unconditionally, advance only on a match
+            *cursor = static_cast<uint32_t>(ordinal);
+            cursor += ((bits_[ordinal] & bits) != 0) == match;
+        }
+    } else {
+        for (size_t ordinal = 0; ordinal < size(); ++ordinal) {
+            const auto *row = bits_.data() + ordinal * words_;
+            uint64_t hits = 0;
+            for (size_t word = 0; word < words_ && word < mask.size(); ++word) {
+                hits |= row[word] & mask[word];
+            }
+            *cursor = static_cast<uint32_t>(ordinal);
+            cursor += (hits != 0) == match;
+        }
+    }
+    ordinals.resize(static_cast<size_t>(cursor - ordinals.data()));
+    return ordinals;
+}
+
+std::vector<uint32_t> LicenseIndex::withFreedom(const Freedom freedom) const {
+    std::vector<uint32_t> ordinals(size());
+    auto *cursor = ordinals.data();
+    for (size_t ordinal = 0; ordinal < size(); ++ordinal) {
+        *cursor = static_cast<uint32_t>(ordinal);
+        cursor += freedom_[ordinal] == freedom;
+    }
+    ordinals.resize(static_cast<size_t>(cursor - ordinals.data()));
+    return ordinals;
+}
+
+std::vector<uint32_t> LicenseIndex::filter(std::string_view filter) const {
+    const bool invert = !filter.empty() && filter[0] == '!';
+    if (invert) {
+        filter.remove_prefix(1);
+    }
+    if (filter == "free" || filter == "non-free") {
+        if (!invert) {
+            return withFreedom(filter == "free" ? Freedom::FREE : Freedom::NON_FREE);
+        }
+        std::vector<uint32_t> ordinals;
+        const auto excluded = filter == "free" ? Freedom::FREE : Freedom::NON_FREE;
+        for (uint32_t ordinal = 0; ordinal < size(); ++ordinal) {
+            if (freedom_[ordinal] != excluded) {
+                ordinals.push_back(ordinal);
+            }
+        }
+        return ordinals;
+    }
+    const auto kind = stringToKind(filter);
+    const auto licenses = kind != 0 ? mask(kind) : mask(filter);
+    return invert ? excluding(licenses) : referencing(licenses);
+}
+
+uint8_t LicenseIndex::stringToKind(const std::string_view kind) {
+    if (kind == "permissive") {
+        return PERMISSIVE;
+    }
+    if (kind == "weak-copyleft") {
+        return WEAK_COPYLEFT;
+    }
+    if (kind == "copyleft") {
+        return COPYLEFT;
+    }
+    return kind == "proprietary" ? PROPRIETARY : 0;
+}
+
+uint8_t LicenseIndex::classify(const std::string_view license) {
+    for (const auto &[rule, kinds]: kRules) {
+        if (license.compare(0, rule.size(), rule) != 0) {
+            continue;
+        }
+        if (rule.back() == '-' || license.size() == rule.size() || license[rule.size()] == '+' ||
+            license[rule.size()] == '-') {
+            return kinds;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LICENSEINDEX_H
+#define LICENSEINDEX_H
+
+#include "AppStreamExport.h"
+#include "TermDictionary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief SPDX license expressions of a catalog, compiled to one bitset per component.
+ *
+ * Each <project_license> is parsed once: license IDs are interned and a
+ * component keeps a bitset of the licenses its expression references, plus
+ * whether the expression as a whole is free (an OR needs one free
+ * alternative, an AND needs every operand free). Queries such as "under a
+ * copyleft license" or "no proprietary license" are a mask of license IDs
+ * ANDed against every row, one branch-free pass over the catalog.
+ */
+class AS_EXPORT LicenseIndex {
+public:
+    using LicenseId = TermDictionary::TermId;
+
+    /// License kinds, usable as a bitmask.
+    enum Kind : uint8_t {
+        FREE = 1 << 0, // FSF free or OSI approved
+        PERMISSIVE = 1 << 1,
+        WEAK_COPYLEFT = 1 << 2,
+        COPYLEFT = 1 << 3,
+        PROPRIETARY = 1 << 4 // Not free, e.g. LicenseRef-proprietary or CC-BY-NC-4.0
+    };
+
+    /// Whether an expression can be used under free licenses only.
+    enum class Freedom : uint8_t { UNKNOWN = 0, FREE, NON_FREE };
+
+    /// Compiles the expression of the next component; an empty or malformed one references what it could parse.
+    void add(std::string_view expression);
+
+    /// Builds the per-component bitsets; call once after the last add().
+    void finish();
+
+    /// Number of components.
+    [[nodiscard]] size_t size() const { return freedom_.size(); }
+
+    /// Heap bytes of the license names, per-component bitsets and pending references.
+    [[nodiscard]] size_t memoryFootprint() const;
+
+    [[nodiscard]] size_t licenseCount() const { return licenses_.size(); }
+
+    [[nodiscard]] std::string_view license(const LicenseId id) const { return licenses_.term(id); }
+
+    [[nodiscard]] uint8_t kinds(const LicenseId id) const { return kinds_[id]; }
+
+    [[nodiscard]] std::optional<LicenseId> find(std::string_view license) const { return licenses_.find(license); }
+
+    [[nodiscard]] Freedom freedom(const uint32_t ordinal) const { return freedom_[ordinal]; }
+
+    /// Licenses referenced by a component, ascending.
+    [[nodiscard]] std::vector<LicenseId> licenses(uint32_t ordinal) const;
+
+    /// Mask of the licenses having any of kinds, for referencing() and excluding().
+    [[nodiscard]] std::vector<uint64_t> mask(uint8_t kinds) const;
+
+    /// Mask of a single license; all zero when the catalog does not use it.
+    [[nodiscard]] std::vector<uint64_t> mask(std::string_view license) const;
+
+    /// Ordinals of the components referencing any license in mask, ascending.
+    [[nodiscard]] std::vector<uint32_t> referencing(const std::vector<uint64_t> &mask) const;
+
+    /// Ordinals of the components referencing no license in mask, ascending.
+    [[nodiscard]] std::vector<uint32_t> excluding(const std::vector<uint64_t> &mask) const;
+
+    /// Ordinals of the components whose expression evaluates to freedom, ascending.
+    [[nodiscard]] std::vector<uint32_t> withFreedom(Freedom freedom) const;
+
+    /**
+     * @brief Ordinals matching a filter, ascending.
+     *
+     * filter is "free" or "non-free" for the freedom of the expression, a kind
+     * ("permissive", "weak-copyleft", "copyleft", "proprietary") for components
+     * referencing a license of that kind, or an SPDX license ID. A leading '!'
+     * inverts it, e.g. "!proprietary".
+     */
+    [[nodiscard]] std::vector<uint32_t> filter(std::string_view filter) const;
+
+    /// Kind from its name in filter(); 0 when unknown.
+    static uint8_t stringToKind(std::string_view kind);
+
+    /// Kinds of a license ID from a built-in table of common SPDX licenses; 0 when unknown.
+    static uint8_t classify(std::string_view license);
+
+private:
+    class Compiler;
+
+    TermDictionary licenses_;
+    std::vector<uint8_t> kinds_;
+    std::vector<Freedom> freedom_;
+    // Referenced licenses per component until finish()
+    std::vector<LicenseId> pending_;
+    std::vector<uint32_t> pendingOffsets_{0};
+    // size() rows of words_ bits each
+    size_t words_ = 0;
+    std::vector<uint64_t> bits_;
+
+    std::vector<uint32_t> scan(const std::vector<uint64_t> &mask, bool match) const;
+};
+
+#endif // LICENSEINDEX_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "QueryCache.h"
+
+QueryCache::QueryCache(const size_t budgetBytes) : budgetBytes_(budgetBytes) {
+}
+
+QueryCache::Result QueryCache::find(const std::string_view key) {
+    std::lock_guard lock(mutex_);
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+    ++hits_;
+    savedSeconds_ += it->second->seconds;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->result;
+}
+
+void QueryCache::insert(const std::string_view key, const Result &result, const double seconds) {
+    // Entry, list node and index slot, plus the shared vector
+    const size_t bytes = sizeof(Entry) + 4 * sizeof(void *) + key.size() + sizeof(*result) +
+                         result->capacity() * sizeof(std::shared_ptr<Component>);
+    if (bytes > budgetBytes_) {
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    if (index_.count(key)) {
+        // Computed concurrently by another caller
+        return;
+    }
+    while (bytes_ + bytes > budgetBytes_) {
+        const auto &last = entries_.back();
+        bytes_ -= last.bytes;
+        index_.erase(last.key);
+        entries_.pop_back();
+        ++evictions_;
+    }
+    entries_.push_front({std::string(key), result, bytes, seconds});
+    index_.emplace(entries_.front().key, entries_.begin());
+    bytes_ += bytes;
+}
+
+QueryCache::Stats QueryCache::stats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    stats.entries = entries_.size();
+    stats.bytes = bytes_;
+    stats.budgetBytes = budgetBytes_;
+    stats.savedSeconds = savedSeconds_;
+    return stats;
+}
+
+void QueryCache::clear() {
+    std::lock_guard lock(mutex_);
+    index_.clear();
+    entries_.clear();
+    bytes_ = 0;
+}
+
+std::string QueryCache::makeKey(const std::string_view kind, const std::string_view argument) {
+    std::string key;
+    key.reserve(kind.size() + 1 + argument.size());
+    key.append(kind).push_back('\0');
+    key.append(argument);
+    return key;
+}
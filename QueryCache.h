@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief LRU cache of component query results, bounded by a byte budget.
+ *
+ * Results are immutable and shared: a hit hands out another reference to the
+ * cached vector instead of rebuilding it. Each parser owns its cache and a
+ * parser's catalog never changes, so entries never need invalidating; a
+ * reloaded catalog is a new parser with an empty cache.
+ */
+class AS_EXPORT QueryCache {
+public:
+    using Result = std::shared_ptr<const std::vector<std::shared_ptr<Component> > >;
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t budgetBytes = 0;
+        /// Time the misses took to compute, summed over every later hit on their entries.
+        double savedSeconds = 0;
+
+        [[nodiscard]] double hitRate() const {
+            return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+        }
+    };
+
+    /// A budget of 0 disables caching; every lookup is then computed.
+    explicit QueryCache(size_t budgetBytes);
+
+    /**
+     * @brief Returns the cached result of key, or computes, caches and returns it.
+     *
+     * @param key Normalized query, e.g. from makeKey().
+     * @param compute Called on a miss, without the cache lock held.
+     */
+    template<typename Compute>
+    Result get(const std::string_view key, Compute &&compute) {
+        if (auto result = find(key)) {
+            return result;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        Result result = compute();
+        insert(key, result, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return result;
+    }
+
+    [[nodiscard]] Stats stats() const;
+
+    /// Drops every entry; the counters are kept.
+    void clear();
+
+    /// Normalized key of a query: its kind and argument, e.g. ("category", "Utility").
+    static std::string makeKey(std::string_view kind, std::string_view argument);
+
+private:
+    struct Entry {
+        std::string key;
+        Result result;
+        size_t bytes;
+        double seconds;
+    };
+
+    size_t budgetBytes_;
+    // Most recently used first; the index keys view the entries' keys
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t evictions_ = 0;
+    double savedSeconds_ = 0;
+    mutable std::mutex mutex_;
+
+    Result find(std::string_view key);
+
+    void insert(std::string_view key, const Result &result, double seconds);
+};
+
+#endif // QUERYCACHE_H
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "QueryRunner.h"
+#include "AppStreamParser.h"
+#include "CatalogExporter.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <istream>
+#include <ostream>
+
+namespace {
+constexpr size_t kDefaultLimit = 20;
+
+bool isSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/// Splits off the first word of text.
+std::string_view nextWord(std::string_view &text) {
+    text = trim(text);
+    size_t end = 0;
+    while (end < text.size() && !isSpace(text[end])) {
+        ++end;
+    }
+    const auto word = text.substr(0, end);
+    text = trim(text.substr(end));
+    return word;
+}
+
+/// Strips trailing offset=<n> and limit=<n> options from argument.
+bool takePaging(std::string_view &argument, size_t &offset, size_t &limit) {
+    for (;;) {
+        const auto space = argument.find_last_of(" \t");
+        const auto word = space == std::string_view::npos ? argument : argument.substr(space + 1);
+        size_t *target = nullptr;
+        std::string_view value;
+        if (word.rfind("offset=", 0) == 0) {
+            target = &offset;
+            value = word.substr(7);
+        } else if (word.rfind("limit=", 0) == 0) {
+            target = &limit;
+            value = word.substr(6);
+        } else {
+            return true;
+        }
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), *target);
+        if (ec != std::errc() || ptr != value.data() + value.size()) {
+            return false;
+        }
+        argument = trim(space == std::string_view::npos ? std::string_view{} : argument.substr(0, space));
+    }
+}
+
+class JsonLine {
+public:
+    explicit JsonLine(const std::string_view query) {
+        out_.push_back('{');
+        string("query", query);
+    }
+
+    void string(const std::string_view key, const std::string_view value) {
+        name(key);
+        out_.push_back('"');
+        CatalogExporter::escapeJson(value, out_);
+        out_.push_back('"');
+    }
+
+    void number(const std::string_view key, const size_t value) {
+        name(key);
+        out_.append(std::to_string(value));
+    }
+
+    void boolean(const std::string_view key, const bool value) {
+        name(key);
+        out_.append(value ? "true" : "false");
+    }
+
+    void ids(const AppStreamParser &parser, const uint32_t *first, const uint32_t *last) {
+        name("ids");
+        out_.push_back('[');
+        for (auto it = first; it != last; ++it) {
+            if (it != first) {
+                out_.push_back(',');
+            }
+            out_.push_back('"');
+            CatalogExporter::escapeJson(parser.getComponentAt(*it)->id, out_);
+            out_.push_back('"');
+        }
+        out_.push_back(']');
+    }
+
+    std::string finish() {
+        out_.push_back('}');
+        return std::move(out_);
+    }
+
+private:
+    std::string out_;
+
+    void name(const std::string_view key) {
+        if (out_.size() > 1) {
+            out_.push_back(',');
+        }
+        out_.push_back('"');
+        out_.append(key);
+        out_.append("\":");
+    }
+};
+
+double percentile(const std::vector<double> &sorted, const double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+}
+}
+
+QueryRunner::QueryRunner(const AppStreamParser &parser, const size_t threads) : parser_(parser), threads_(threads) {
+    std::vector<std::string> names(parser.getTotalComponentCount());
+    byName_.resize(names.size());
+    for (uint32_t ordinal = 0; ordinal < names.size(); ++ordinal) {
+        names[ordinal] = parser.getComponentAt(ordinal)->name;
+        byName_[ordinal] = ordinal;
+    }
+    std::stable_sort(byName_.begin(), byName_.end(), [&](const uint32_t a, const uint32_t b) {
+        return names[a] < names[b];
+    });
+}
+
+std::string QueryRunner::execute(const std::string_view query) const {
+    JsonLine line(query);
+    std::string_view argument = query;
+    const auto command = nextWord(argument);
+    size_t offset = 0;
+    size_t limit = kDefaultLimit;
+    if (command != "id" && !takePaging(argument, offset, limit)) {
+        line.string("error", "malformed offset or limit");
+        return line.finish();
+    }
+    // No result is longer than the catalog; clamping keeps offset + limit from wrapping around
+    offset = std::min(offset, parser_.getTotalComponentCount());
+    limit = std::min(limit, parser_.getTotalComponentCount());
+
+    const auto page = [&](const uint32_t *first, const uint32_t *last) {
+        const auto total = static_cast<size_t>(last - first);
+        line.number("total", total);
+        line.number("offset", offset);
+        const auto begin = first + std::min(offset, total);
+        line.ids(parser_, begin, begin + std::min(limit, static_cast<size_t>(last - begin)));
+    };
+    // Ordinals are in ID order, so ID ranges page without materializing their ordinals
+    const auto pageRange = [&](const size_t first, const size_t last) {
+        line.number("total", last - first);
+        line.number("offset", offset);
+        std::vector<uint32_t> ordinals;
+        const auto begin = std::min(first + offset, last);
+        for (auto ordinal = begin; ordinal < std::min(begin + limit, last); ++ordinal) {
+            ordinals.push_back(static_cast<uint32_t>(ordinal));
+        }
+        line.ids(parser_, ordinals.data(), ordinals.data() + ordinals.size());
+    };
+
+    if (command == "id") {
+        const auto ordinal = parser_.findOrdinal(argument);
+        line.boolean("found", ordinal.has_value());
+        if (ordinal) {
+            const auto component = parser_.getComponentAt(*ordinal);
+            line.string("id", component->id);
+            line.string("name", component->name);
+            line.string("summary", component->summary);
+        }
+    } else if (command == "category" || command == "keyword") {
+        const auto ordinals = parser_.findOrdinals(
+            command == "category" ? AppStreamParser::Facet::CATEGORY : AppStreamParser::Facet::KEYWORD, argument);
+        page(ordinals.begin(), ordinals.end());
+    } else if (command == "publisher") {
+        const auto ordinals = parser_.findPublisher(argument);
+        page(ordinals.begin(), ordinals.end());
+    } else if (command == "substring") {
+        const auto ordinals = parser_.searchSubstring(argument);
+        page(ordinals.data(), ordinals.data() + ordinals.size());
+    } else if (command == "similar") {
+        std::vector<uint32_t> ordinals;
+        if (const auto ordinal = parser_.findOrdinal(argument)) {
+            for (const auto &similar: parser_.findSimilar(static_cast<uint32_t>(*ordinal), offset + limit)) {
+                ordinals.push_back(similar.ordinal);
+            }
+        }
+        page(ordinals.data(), ordinals.data() + ordinals.size());
+    } else if (command == "alias") {
+        const auto kind = AliasIndex::stringToKind(nextWord(argument));
+        if (!kind) {
+            line.string("error", "alias takes desktop-id, pkgname, source-pkgname or bundle");
+            return line.finish();
+        }
+        const auto ordinals = parser_.getAliases().find(*kind, argument);
+        page(ordinals.begin(), ordinals.end());
+    } else if (command == "license") {
+        const auto ordinals = parser_.getLicenses().filter(argument);
+        page(ordinals.data(), ordinals.data() + ordinals.size());
+    } else if (command == "prefix") {
+        const auto range = parser_.findIdPrefix(argument);
+        pageRange(range.first, range.last);
+    } else if (command == "search") {
+        const auto hits = parser_.search(argument, offset + limit);
+        std::vector<uint32_t> ordinals;
+        ordinals.reserve(hits.size());
+        for (const auto &hit: hits) {
+            ordinals.push_back(hit.ordinal);
+        }
+        page(ordinals.data(), ordinals.data() + ordinals.size());
+    } else if (command == "sorted" && (argument == "id" || argument == "name")) {
+        if (argument == "name") {
+            page(byName_.data(), byName_.data() + byName_.size());
+        } else {
+            pageRange(0, parser_.getTotalComponentCount());
+        }
+    } else if (command == "count") {
+        if (argument.empty()) {
+            line.number("count", parser_.getTotalComponentCount());
+        } else {
+            const auto facet = nextWord(argument);
+            if (facet == "category" || facet == "keyword") {
+                line.number("count", parser_.findOrdinals(facet == "category"
+                                                              ? AppStreamParser::Facet::CATEGORY
+                                                              : AppStreamParser::Facet::KEYWORD, argument).size());
+            } else if (facet == "publisher") {
+                line.number("count", parser_.findPublisher(argument).size());
+            } else if (facet == "prefix") {
+                line.number("count", parser_.findIdPrefix(argument).size());
+            } else {
+                line.string("error", "count takes category, keyword, publisher or prefix");
+                return line.finish();
+            }
+        }
+    } else {
+        line.string("error", "unknown query");
+    }
+    return line.finish();
+}
+
+QueryRunner::Stats QueryRunner::run(std::istream &in, std::ostream &out, const size_t batchSize) const {
+    const auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(threads_);
+    std::vector<double> latencies;
+    std::vector<std::string> queries;
+    std::vector<std::string> results;
+    std::vector<double> micros;
+    Stats stats;
+    std::string line;
+    bool more = true;
+    while (more) {
+        queries.clear();
+        while (queries.size() < std::max<size_t>(batchSize, 1) && (more = static_cast<bool>(std::getline(in, line)))) {
+            if (const auto query = trim(line); !query.empty() && query.front() != '#') {
+                queries.emplace_back(query);
+            }
+        }
+        results.assign(queries.size(), {});
+        micros.assign(queries.size(), 0);
+        // Several queries per task keep the pool overhead small next to microsecond queries,
+        // while leaving enough tasks per worker to balance through stealing
+        const size_t chunk = std::max<size_t>(1, queries.size() / (pool.size() * 16));
+        for (size_t first = 0; first < queries.size(); first += chunk) {
+            pool.submit([&, first, last = std::min(first + chunk, queries.size())] {
+                for (auto i = first; i < last; ++i) {
+                    const auto begin = std::chrono::steady_clock::now();
+                    results[i] = execute(queries[i]);
+                    micros[i] = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - begin).count();
+                }
+            });
+        }
+        pool.wait();
+        for (const auto &result: results) {
+            // Errors are the only results with this key
+            stats.errors += result.find("\"error\":") != std::string::npos;
+            out << result << '\n';
+        }
+        out.flush();
+        latencies.insert(latencies.end(), micros.begin(), micros.end());
+        stats.queries += queries.size();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.p50 = percentile(latencies, 0.50);
+    stats.p90 = percentile(latencies, 0.90);
+    stats.p99 = percentile(latencies, 0.99);
+    stats.max = latencies.empty() ? 0 : latencies.back();
+    return stats;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef QUERYRUNNER_H
+#define QUERYRUNNER_H
+
+#include "AppStreamExport.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class AppStreamParser;
+
+
+/**
+ * @brief Answers newline-delimited queries against one loaded catalog.
+ *
+ * One query per line; blank lines and lines starting with '#' are skipped:
+ *
+ *     id <component id>
+ *     category <term>
+ *     keyword <term>
+ *     publisher <developer id, developer name or project group>
+ *     prefix <id prefix>
+ *     alias desktop-id|pkgname|source-pkgname|bundle <name>
+ *     license [!]free|non-free|permissive|weak-copyleft|copyleft|proprietary|<SPDX id>
+ *     search <text>
+ *     substring <text>
+ *     similar <component id>
+ *     sorted id|name
+ *     count [category|keyword|publisher|prefix <argument>]
+ *
+ * List queries take optional trailing offset=<n> and limit=<n> (default 0
+ * and 20) and return the total plus one page of IDs. Every query produces
+ * exactly one line of JSON. Queries of a batch run in parallel on a
+ * ThreadPool; results are written in input order.
+ */
+class AS_EXPORT QueryRunner {
+public:
+    struct Stats {
+        size_t queries = 0;
+        size_t errors = 0;
+        double seconds = 0;
+        /// Per-query latency percentiles in microseconds.
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    /// threads == 0 uses the number of hardware threads.
+    explicit QueryRunner(const AppStreamParser &parser, size_t threads = 0);
+
+    /// Answers one query as a single line of JSON, without the newline.
+    [[nodiscard]] std::string execute(std::string_view query) const;
+
+    /// Reads queries from in until EOF and writes one result line per query to out.
+    Stats run(std::istream &in, std::ostream &out, size_t batchSize = 4096) const;
+
+private:
+    const AppStreamParser &parser_;
+    size_t threads_;
+    // Ordinals in name order, for sorted pages
+    std::vector<uint32_t> byName_;
+};
+
+#endif // QUERYRUNNER_H
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RelationGraph.h"
+
+#include <algorithm>
+#include <iterator>
+
+IdRange RelationGraph::range(const std::vector<uint32_t> &offsets, const std::vector<uint32_t> &values,
+                             const uint32_t index) {
+    if (index + 1 >= offsets.size()) {
+        return {};
+    }
+    return {values.data() + offsets[index], values.data() + offsets[index + 1]};
+}
+
+void RelationGraph::Groups::add(const std::string_view key) {
+    of.push_back(key.empty() ? kNoGroup : keys.intern(key));
+}
+
+void RelationGraph::Groups::finish() {
+    // Counting sort of ordinals by group
+    offsets.assign(keys.size() + 1, 0);
+    for (const auto id: of) {
+        if (id != kNoGroup) {
+            ++offsets[id + 1];
+        }
+    }
+    for (size_t id = 0; id < keys.size(); ++id) {
+        offsets[id + 1] += offsets[id];
+    }
+    members.resize(offsets.back());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t ordinal = 0; ordinal < of.size(); ++ordinal) {
+        if (of[ordinal] != kNoGroup) {
+            members[fill[of[ordinal]]++] = ordinal;
+        }
+    }
+}
+
+IdRange RelationGraph::Groups::group(const uint32_t id) const {
+    return id == kNoGroup ? IdRange{} : range(offsets, members, id);
+}
+
+void RelationGraph::add(const std::vector<uint32_t> &suggests, const std::string_view developer,
+                        const std::string_view projectGroup) {
+    suggests_.insert(suggests_.end(), suggests.begin(), suggests.end());
+    suggestOffsets_.push_back(static_cast<uint32_t>(suggests_.size()));
+    developers_.add(developer);
+    projectGroups_.add(projectGroup);
+}
+
+void RelationGraph::finish() {
+    const auto count = suggestOffsets_.size() - 1;
+    suggestedByOffsets_.assign(count + 1, 0);
+    for (const auto target: suggests_) {
+        ++suggestedByOffsets_[target + 1];
+    }
+    for (size_t ordinal = 0; ordinal < count; ++ordinal) {
+        suggestedByOffsets_[ordinal + 1] += suggestedByOffsets_[ordinal];
+    }
+    suggestedBy_.resize(suggests_.size());
+    std::vector<uint32_t> fill(suggestedByOffsets_.begin(), suggestedByOffsets_.end() - 1);
+    for (uint32_t ordinal = 0; ordinal < count; ++ordinal) {
+        for (auto i = suggestOffsets_[ordinal]; i < suggestOffsets_[ordinal + 1]; ++i) {
+            suggestedBy_[fill[suggests_[i]]++] = ordinal;
+        }
+    }
+    developers_.finish();
+    projectGroups_.finish();
+}
+
+IdRange RelationGraph::suggests(const uint32_t ordinal) const {
+    return range(suggestOffsets_, suggests_, ordinal);
+}
+
+IdRange RelationGraph::suggestedBy(const uint32_t ordinal) const {
+    return range(suggestedByOffsets_, suggestedBy_, ordinal);
+}
+
+IdRange RelationGraph::sameDeveloper(const uint32_t ordinal) const {
+    return ordinal < developers_.of.size() ? developers_.group(developers_.of[ordinal]) : IdRange{};
+}
+
+IdRange RelationGraph::sameProjectGroup(const uint32_t ordinal) const {
+    return ordinal < projectGroups_.of.size() ? projectGroups_.group(projectGroups_.of[ordinal]) : IdRange{};
+}
+
+IdRange RelationGraph::findDeveloper(const std::string_view developer) const {
+    const auto id = developers_.keys.find(developer);
+    return id ? developers_.group(*id) : IdRange{};
+}
+
+IdRange RelationGraph::findProjectGroup(const std::string_view projectGroup) const {
+    const auto id = projectGroups_.keys.find(projectGroup);
+    return id ? projectGroups_.group(*id) : IdRange{};
+}
+
+std::vector<RelationGraph::Neighbor> RelationGraph::neighbors(const uint32_t ordinal, const uint8_t relations,
+                                                              const size_t limit) const {
+    const auto sameGroup = [&](const Groups &groups, const uint32_t target) {
+        return groups.of[ordinal] != kNoGroup && groups.of[ordinal] == groups.of[target];
+    };
+    const auto related = [&](const uint32_t target, const Relation relation) {
+        switch (relation) {
+            case SUGGESTS: {
+                const auto targets = suggests(ordinal);
+                return std::find(targets.begin(), targets.end(), target) != targets.end();
+            }
+            case SUGGESTED_BY: {
+                const auto sources = suggestedBy(ordinal);
+                return std::binary_search(sources.begin(), sources.end(), target);
+            }
+            case SAME_DEVELOPER: return sameGroup(developers_, target);
+            case SAME_PROJECT_GROUP: return sameGroup(projectGroups_, target);
+            default: return false;
+        }
+    };
+
+    std::vector<Neighbor> result;
+    if (ordinal + 1 >= suggestOffsets_.size()) {
+        return result;
+    }
+    constexpr Relation kOrder[] = {SUGGESTS, SUGGESTED_BY, SAME_DEVELOPER, SAME_PROJECT_GROUP};
+    std::vector<uint32_t> suggested(suggests(ordinal).begin(), suggests(ordinal).end());
+    std::sort(suggested.begin(), suggested.end());
+    suggested.erase(std::unique(suggested.begin(), suggested.end()), suggested.end());
+
+    // Walk relations strongest first. A component already reached through a stronger
+    // relation is skipped; otherwise its weaker relations are looked up directly, so
+    // the work is bounded by limit rather than by the size of large groups.
+    for (size_t k = 0; k < std::size(kOrder); ++k) {
+        const auto relation = kOrder[k];
+        if (!(relations & relation)) {
+            continue;
+        }
+        IdRange targets;
+        switch (relation) {
+            case SUGGESTS: targets = {suggested.data(), suggested.data() + suggested.size()};
+                break;
+            case SUGGESTED_BY: targets = suggestedBy(ordinal);
+                break;
+            case SAME_DEVELOPER: targets = sameDeveloper(ordinal);
+                break;
+            default: targets = sameProjectGroup(ordinal);
+                break;
+        }
+        for (const auto target: targets) {
+            if (target == ordinal) {
+                continue;
+            }
+            bool seen = false;
+            for (size_t stronger = 0; stronger < k && !seen; ++stronger) {
+                seen = (relations & kOrder[stronger]) && related(target, kOrder[stronger]);
+            }
+            if (seen) {
+                continue;
+            }
+            uint8_t kinds = relation;
+            for (size_t weaker = k + 1; weaker < std::size(kOrder); ++weaker) {
+                if ((relations & kOrder[weaker]) && related(target, kOrder[weaker])) {
+                    kinds |= kOrder[weaker];
+                }
+            }
+            result.push_back({target, kinds});
+            if (result.size() >= limit) {
+                return result;
+            }
+        }
+    }
+    return result;
+}
+
+size_t RelationGraph::memoryUsage() const {
+    const auto groupBytes = [](const Groups &groups) {
+        return (groups.of.capacity() + groups.offsets.capacity() + groups.members.capacity()) * sizeof(uint32_t);
+    };
+    return (suggestOffsets_.capacity() + suggests_.capacity() + suggestedByOffsets_.capacity() +
+            suggestedBy_.capacity()) * sizeof(uint32_t) + groupBytes(developers_) + groupBytes(projectGroups_);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RELATIONGRAPH_H
+#define RELATIONGRAPH_H
+
+#include "AppStreamExport.h"
+#include "FacetIndex.h"
+#include "TermDictionary.h"
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Relations between components by ordinal, in compressed sparse row form.
+ *
+ * Explicit <suggests> edges are stored in both directions. Components sharing
+ * a developer or project group are not linked pairwise; each component points
+ * to its group and each group lists its members, so the structure stays
+ * linear in the catalog size even for developers with hundreds of apps.
+ */
+class AS_EXPORT RelationGraph {
+public:
+    /// Relation kinds, usable as a bitmask; lower bits are stronger relations.
+    enum Relation : uint8_t {
+        SUGGESTS = 1 << 0,
+        SUGGESTED_BY = 1 << 1,
+        SAME_DEVELOPER = 1 << 2,
+        SAME_PROJECT_GROUP = 1 << 3,
+        ALL = 0x0f
+    };
+
+    struct Neighbor {
+        uint32_t ordinal;
+        /// Every relation linking the two components.
+        uint8_t relations;
+    };
+
+    static constexpr uint32_t kNoGroup = std::numeric_limits<uint32_t>::max();
+
+    /// Appends the next component: its resolved suggests and its developer and project group keys.
+    void add(const std::vector<uint32_t> &suggests, std::string_view developer, std::string_view projectGroup);
+
+    /// Builds the reverse suggests edges and the group member lists.
+    void finish();
+
+    /// Related components ordered by their strongest relation, then by ordinal; self is excluded.
+    [[nodiscard]] std::vector<Neighbor> neighbors(uint32_t ordinal, uint8_t relations = ALL,
+                                                  size_t limit = std::numeric_limits<size_t>::max()) const;
+
+    /// Components the component suggests, in document order.
+    [[nodiscard]] IdRange suggests(uint32_t ordinal) const;
+
+    /// Components suggesting the component, ascending.
+    [[nodiscard]] IdRange suggestedBy(uint32_t ordinal) const;
+
+    /// Components by the same developer, including the component itself, ascending.
+    [[nodiscard]] IdRange sameDeveloper(uint32_t ordinal) const;
+
+    [[nodiscard]] IdRange sameProjectGroup(uint32_t ordinal) const;
+
+    /// Components of a developer by developer ID, or name when the ID is absent.
+    [[nodiscard]] IdRange findDeveloper(std::string_view developer) const;
+
+    [[nodiscard]] IdRange findProjectGroup(std::string_view projectGroup) const;
+
+    [[nodiscard]] size_t edgeCount() const { return suggests_.size() + suggestedBy_.size(); }
+
+    [[nodiscard]] size_t memoryUsage() const;
+
+private:
+    struct Groups {
+        TermDictionary keys;
+        // Group of each ordinal, or kNoGroup
+        std::vector<uint32_t> of;
+        // Members of group g are members[offsets[g], offsets[g + 1])
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> members;
+
+        void add(std::string_view key);
+
+        void finish();
+
+        [[nodiscard]] IdRange group(uint32_t id) const;
+    };
+
+    std::vector<uint32_t> suggestOffsets_{0};
+    std::vector<uint32_t> suggests_;
+    std::vector<uint32_t> suggestedByOffsets_;
+    std::vector<uint32_t> suggestedBy_;
+    Groups developers_;
+    Groups projectGroups_;
+
+    static IdRange range(const std::vector<uint32_t> &offsets, const std::vector<uint32_t> &values, uint32_t index);
+};
+
+#endif // RELATIONGRAPH_H
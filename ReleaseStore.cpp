@@ -0,0 +1,255 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ReleaseStore.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cctype>
+
+namespace {
+constexpr char kSha1[] = "sha1";
+constexpr char kSha256[] = "sha256";
+constexpr char kSha512[] = "sha512";
+constexpr char kBlake2b[] = "blake2b";
+constexpr char kBlake2s[] = "blake2s";
+constexpr char kDownload[] = "download";
+constexpr char kInstalled[] = "installed";
+
+int hexValue(const char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+}
+
+std::string ReleaseStore::Checksum::hex() const {
+    std::string out(2 * length, '\0');
+    hex(out.data());
+    return out;
+}
+
+char *ReleaseStore::Checksum::hex(char *out) const {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    for (size_t i = 0; i < length; ++i) {
+        *out++ = kDigits[digest[i] >> 4];
+        *out++ = kDigits[digest[i] & 0xf];
+    }
+    return out;
+}
+
+ReleaseStore::Checksum ReleaseStore::Artifact::checksum(const size_t i) const {
+    const auto &checksum = store_->checksums_[record().firstChecksum + i];
+    return {checksum.type, store_->digests_.data() + checksum.digestOffset, digestLength(checksum.type)};
+}
+
+std::optional<ReleaseStore::Checksum> ReleaseStore::Artifact::checksum(const ChecksumType type) const {
+    for (size_t i = 0; i < checksumCount(); ++i) {
+        if (const auto value = checksum(i); value.type == type) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+ReleaseStore::StringRef ReleaseStore::intern(const std::string_view value) {
+    if (value.empty()) {
+        return {};
+    }
+    const StringRef ref{static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(value.size())};
+    strings_.append(value);
+    return ref;
+}
+
+void ReleaseStore::addRelease(const Component::ReleaseType type, const Component::ReleaseUrgency urgency) {
+    auto &release = releases_.emplace_back();
+    release.type = type;
+    release.urgency = urgency;
+    release.firstIssue = static_cast<uint32_t>(issues_.size());
+    release.firstArtifact = static_cast<uint32_t>(artifacts_.size());
+}
+
+void ReleaseStore::setField(const Field field, const std::string_view value) {
+    auto &release = releases_.back();
+    switch (field) {
+        case Field::VERSION: release.version = intern(value);
+            break;
+        case Field::DATE: release.date = intern(value);
+            break;
+        case Field::TIMESTAMP: release.timestamp = intern(value);
+            break;
+        case Field::DATE_EOL: release.dateEol = intern(value);
+            break;
+        case Field::URL: release.url = intern(value);
+            break;
+        case Field::DESCRIPTION: release.description = intern(value);
+            break;
+    }
+}
+
+void ReleaseStore::setDescriptionHandle(const uint32_t handle) {
+    releases_.back().descriptionHandle = handle;
+}
+
+void ReleaseStore::addIssue(const Component::IssueType type, const std::string_view url, const std::string_view value) {
+    ++releases_.back().issueCount;
+    issues_.push_back({intern(url), intern(value), type});
+}
+
+void ReleaseStore::addArtifact() {
+    ++releases_.back().artifactCount;
+    artifacts_.emplace_back().firstChecksum = static_cast<uint32_t>(checksums_.size());
+}
+
+void ReleaseStore::setLocation(const std::string_view location) {
+    artifacts_.back().location = intern(location);
+}
+
+bool ReleaseStore::addChecksum(const std::string_view type, std::string_view hex) {
+    const auto checksumType = stringToChecksumType(type);
+    if (!checksumType) {
+        SPDLOG_DEBUG("Ignoring checksum of unknown type: {}", type);
+        return false;
+    }
+    while (!hex.empty() && std::isspace(static_cast<unsigned char>(hex.front()))) {
+        hex.remove_prefix(1);
+    }
+    while (!hex.empty() && std::isspace(static_cast<unsigned char>(hex.back()))) {
+        hex.remove_suffix(1);
+    }
+    const auto length = digestLength(*checksumType);
+    if (hex.size() != 2 * length) {
+        spdlog::warn("Ignoring {} checksum of {} hex digits", type, hex.size());
+        return false;
+    }
+    const auto offset = digests_.size();
+    digests_.resize(offset + length);
+    for (size_t i = 0; i < length; ++i) {
+        const int high = hexValue(hex[2 * i]);
+        const int low = hexValue(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            spdlog::warn("Ignoring malformed {} checksum: {}", type, hex);
+            digests_.resize(offset);
+            return false;
+        }
+        digests_[offset + i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    checksums_.push_back({static_cast<uint32_t>(offset), *checksumType});
+    ++artifacts_.back().checksumCount;
+    return true;
+}
+
+void ReleaseStore::addChecksum(const ChecksumType type, const uint8_t *digest) {
+    const auto offset = digests_.size();
+    digests_.insert(digests_.end(), digest, digest + digestLength(type));
+    checksums_.push_back({static_cast<uint32_t>(offset), type});
+    ++artifacts_.back().checksumCount;
+}
+
+bool ReleaseStore::setSize(const std::string_view kind, const uint64_t size) {
+    const auto sizeKind = stringToSizeKind(kind);
+    if (!sizeKind) {
+        SPDLOG_DEBUG("Ignoring size of unknown type: {}", kind);
+        return false;
+    }
+    setSize(*sizeKind, size);
+    return true;
+}
+
+void ReleaseStore::setSize(const SizeKind kind, const uint64_t size) {
+    artifacts_.back().size[static_cast<size_t>(kind)] = size;
+}
+
+ReleaseStore::Mark ReleaseStore::mark() const {
+    return {
+        static_cast<uint32_t>(releases_.size()), static_cast<uint32_t>(issues_.size()),
+        static_cast<uint32_t>(artifacts_.size()), static_cast<uint32_t>(checksums_.size()),
+        static_cast<uint32_t>(digests_.size()), static_cast<uint32_t>(strings_.size())
+    };
+}
+
+void ReleaseStore::rollback(const Mark &mark) {
+    releases_.resize(mark.releases);
+    issues_.resize(mark.issues);
+    artifacts_.resize(mark.artifacts);
+    checksums_.resize(mark.checksums);
+    digests_.resize(mark.digestBytes);
+    strings_.resize(mark.stringBytes);
+}
+
+void ReleaseStore::shrinkToFit() {
+    releases_.shrink_to_fit();
+    issues_.shrink_to_fit();
+    artifacts_.shrink_to_fit();
+    checksums_.shrink_to_fit();
+    digests_.shrink_to_fit();
+    strings_.shrink_to_fit();
+}
+
+ReleaseStore::Stats ReleaseStore::stats() const {
+    Stats stats;
+    stats.releases = releases_.size();
+    stats.issues = issues_.size();
+    stats.artifacts = artifacts_.size();
+    stats.checksums = checksums_.size();
+    stats.bytes = releases_.capacity() * sizeof(ReleaseRecord) + issues_.capacity() * sizeof(IssueRecord) +
+                  artifacts_.capacity() * sizeof(ArtifactRecord) + checksums_.capacity() * sizeof(ChecksumRecord) +
+                  digests_.capacity() + strings_.capacity();
+    return stats;
+}
+
+std::optional<ReleaseStore::ChecksumType> ReleaseStore::stringToChecksumType(const std::string_view type) {
+    if (type == kSha256) return ChecksumType::SHA256;
+    if (type == kSha1) return ChecksumType::SHA1;
+    if (type == kSha512) return ChecksumType::SHA512;
+    if (type == kBlake2b) return ChecksumType::BLAKE2B;
+    if (type == kBlake2s) return ChecksumType::BLAKE2S;
+    return std::nullopt;
+}
+
+std::string_view ReleaseStore::checksumTypeToString(const ChecksumType type) {
+    switch (type) {
+        case ChecksumType::SHA1: return kSha1;
+        case ChecksumType::SHA256: return kSha256;
+        case ChecksumType::SHA512: return kSha512;
+        case ChecksumType::BLAKE2B: return kBlake2b;
+        case ChecksumType::BLAKE2S: return kBlake2s;
+    }
+    return {};
+}
+
+size_t ReleaseStore::digestLength(const ChecksumType type) {
+    switch (type) {
+        case ChecksumType::SHA1: return 20;
+        case ChecksumType::SHA256: return 32;
+        case ChecksumType::SHA512: return 64;
+        case ChecksumType::BLAKE2B: return 64;
+        case ChecksumType::BLAKE2S: return 32;
+    }
+    return 0;
+}
+
+std::optional<ReleaseStore::SizeKind> ReleaseStore::stringToSizeKind(const std::string_view kind) {
+    if (kind == kDownload) return SizeKind::DOWNLOAD;
+    if (kind == kInstalled) return SizeKind::INSTALLED;
+    return std::nullopt;
+}
+
+std::string_view ReleaseStore::sizeKindToString(const SizeKind kind) {
+    return kind == SizeKind::DOWNLOAD ? kDownload : kInstalled;
+}
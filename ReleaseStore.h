@@ -0,0 +1,312 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef RELEASESTORE_H
+#define RELEASESTORE_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Releases, issues and artifacts of a whole catalog in flat arrays.
+ *
+ * Records are fixed-size structs in one vector per kind; their strings live in
+ * a shared character buffer and checksums are kept as binary digests tagged
+ * with their algorithm. A component refers to its releases by a
+ * Component::ReleaseRange, and each release to its issues and artifacts by
+ * offset and count, so nothing is allocated per record.
+ *
+ * Views returned by the accessors point into the store and stay valid as long
+ * as it is not modified.
+ */
+class AS_EXPORT ReleaseStore {
+public:
+    enum class ChecksumType : uint8_t { SHA1, SHA256, SHA512, BLAKE2B, BLAKE2S };
+
+    enum class SizeKind : uint8_t { DOWNLOAD, INSTALLED };
+
+    /// Size of an artifact that does not list the requested kind.
+    static constexpr uint64_t kNoSize = UINT64_MAX;
+
+    /// Fields of the release being added.
+    enum class Field { VERSION, DATE, TIMESTAMP, DATE_EOL, URL, DESCRIPTION };
+
+    struct Checksum {
+        ChecksumType type;
+        const uint8_t *digest;
+        size_t length;
+
+        /// Lower-case hex form, as written in the catalog.
+        [[nodiscard]] std::string hex() const;
+
+        /// Writes the 2 * length hex digits to out and returns the end of them.
+        char *hex(char *out) const;
+    };
+
+    class Issue;
+    class Artifact;
+    class Release;
+
+private:
+    struct ReleaseRecord;
+    struct IssueRecord;
+    struct ArtifactRecord;
+
+public:
+    /// Iterable releases of one component.
+    class Releases {
+    public:
+        class Iterator {
+        public:
+            Iterator(const ReleaseStore *store, const uint32_t index) : store_(store), index_(index) {
+            }
+
+            Release operator*() const { return {store_, index_}; }
+            Iterator &operator++() { ++index_; return *this; }
+            bool operator!=(const Iterator &other) const { return index_ != other.index_; }
+
+        private:
+            const ReleaseStore *store_;
+            uint32_t index_;
+        };
+
+        Releases(const ReleaseStore *store, const uint32_t first, const uint32_t count)
+            : store_(store), first_(first), count_(store ? count : 0) {
+        }
+
+        [[nodiscard]] size_t size() const { return count_; }
+        [[nodiscard]] bool empty() const { return count_ == 0; }
+        [[nodiscard]] Release operator[](const size_t i) const { return {store_, first_ + static_cast<uint32_t>(i)}; }
+        [[nodiscard]] Iterator begin() const { return {store_, first_}; }
+        [[nodiscard]] Iterator end() const { return {store_, first_ + count_}; }
+
+    private:
+        const ReleaseStore *store_;
+        uint32_t first_;
+        uint32_t count_;
+    };
+
+    class Issue {
+    public:
+        Issue(const ReleaseStore *store, const uint32_t index) : store_(store), index_(index) {
+        }
+
+        [[nodiscard]] Component::IssueType type() const { return record().type; }
+        [[nodiscard]] std::string_view url() const { return store_->string(record().url); }
+        [[nodiscard]] std::string_view value() const { return store_->string(record().value); }
+
+    private:
+        const ReleaseStore *store_;
+        uint32_t index_;
+
+        [[nodiscard]] const IssueRecord &record() const { return store_->issues_[index_]; }
+    };
+
+    class Artifact {
+    public:
+        Artifact(const ReleaseStore *store, const uint32_t index) : store_(store), index_(index) {
+        }
+
+        [[nodiscard]] std::string_view location() const { return store_->string(record().location); }
+
+        /// Size in bytes, or kNoSize.
+        [[nodiscard]] uint64_t size(const SizeKind kind) const { return record().size[static_cast<size_t>(kind)]; }
+
+        [[nodiscard]] size_t checksumCount() const { return record().checksumCount; }
+
+        [[nodiscard]] Checksum checksum(size_t i) const;
+
+        /// Checksum of the given algorithm, if listed.
+        [[nodiscard]] std::optional<Checksum> checksum(ChecksumType type) const;
+
+    private:
+        const ReleaseStore *store_;
+        uint32_t index_;
+
+        [[nodiscard]] const ArtifactRecord &record() const { return store_->artifacts_[index_]; }
+    };
+
+    class Release {
+    public:
+        Release(const ReleaseStore *store, const uint32_t index) : store_(store), index_(index) {
+        }
+
+        [[nodiscard]] Component::ReleaseType type() const { return record().type; }
+        [[nodiscard]] Component::ReleaseUrgency urgency() const { return record().urgency; }
+        [[nodiscard]] std::string_view version() const { return store_->string(record().version); }
+        [[nodiscard]] std::string_view date() const { return store_->string(record().date); }
+        /// ISO 8601 form of the timestamp attribute.
+        [[nodiscard]] std::string_view timestamp() const { return store_->string(record().timestamp); }
+        [[nodiscard]] std::string_view dateEol() const { return store_->string(record().dateEol); }
+        [[nodiscard]] std::string_view url() const { return store_->string(record().url); }
+        /// Description markup; empty when it was moved to a TextStore, see descriptionHandle().
+        [[nodiscard]] std::string_view description() const { return store_->string(record().description); }
+        [[nodiscard]] uint32_t descriptionHandle() const { return record().descriptionHandle; }
+
+        [[nodiscard]] size_t issueCount() const { return record().issueCount; }
+        [[nodiscard]] Issue issue(const size_t i) const {
+            return {store_, record().firstIssue + static_cast<uint32_t>(i)};
+        }
+
+        [[nodiscard]] size_t artifactCount() const { return record().artifactCount; }
+        [[nodiscard]] Artifact artifact(const size_t i) const {
+            return {store_, record().firstArtifact + static_cast<uint32_t>(i)};
+        }
+
+    private:
+        const ReleaseStore *store_;
+        uint32_t index_;
+
+        [[nodiscard]] const ReleaseRecord &record() const { return store_->releases_[index_]; }
+    };
+
+    /// Position of the store, for discarding everything added after it.
+    struct Mark {
+        uint32_t releases = 0;
+        uint32_t issues = 0;
+        uint32_t artifacts = 0;
+        uint32_t checksums = 0;
+        uint32_t digestBytes = 0;
+        uint32_t stringBytes = 0;
+    };
+
+    struct Stats {
+        size_t releases = 0;
+        size_t issues = 0;
+        size_t artifacts = 0;
+        size_t checksums = 0;
+        /// Heap bytes of all arrays and buffers.
+        size_t bytes = 0;
+    };
+
+    /// Releases of component; empty unless its range refers to this store.
+    [[nodiscard]] static Releases releases(const Component &component) {
+        const auto &range = component.releases;
+        return {range.store, range.first, range.count};
+    }
+
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(releases_.size()); }
+
+    /// Starts a release; following calls fill it in.
+    void addRelease(Component::ReleaseType type, Component::ReleaseUrgency urgency);
+
+    void setField(Field field, std::string_view value);
+
+    void setDescriptionHandle(uint32_t handle);
+
+    void addIssue(Component::IssueType type, std::string_view url, std::string_view value);
+
+    /// Starts an artifact of the current release.
+    void addArtifact();
+
+    void setLocation(std::string_view location);
+
+    /// Adds a checksum to the current artifact; unknown algorithms and malformed digests are dropped.
+    bool addChecksum(std::string_view type, std::string_view hex);
+
+    /// Adds a checksum from its binary digest of digestLength(type) bytes.
+    void addChecksum(ChecksumType type, const uint8_t *digest);
+
+    /// Sets a size of the current artifact; unknown kinds are dropped.
+    bool setSize(std::string_view kind, uint64_t size);
+
+    void setSize(SizeKind kind, uint64_t size);
+
+    [[nodiscard]] Mark mark() const;
+
+    /// Discards everything added since mark was taken.
+    void rollback(const Mark &mark);
+
+    /// Releases spare capacity once the catalog is complete.
+    void shrinkToFit();
+
+    [[nodiscard]] Stats stats() const;
+
+    static std::optional<ChecksumType> stringToChecksumType(std::string_view type);
+
+    static std::string_view checksumTypeToString(ChecksumType type);
+
+    /// Digest length in bytes.
+    static size_t digestLength(ChecksumType type);
+
+    static std::optional<SizeKind> stringToSizeKind(std::string_view kind);
+
+    static std::string_view sizeKindToString(SizeKind kind);
+
+private:
+    struct StringRef {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct ReleaseRecord {
+        StringRef version;
+        StringRef date;
+        StringRef timestamp;
+        StringRef dateEol;
+        StringRef url;
+        StringRef description;
+        uint32_t descriptionHandle = Component::kNoTextHandle;
+        uint32_t firstIssue = 0;
+        uint32_t firstArtifact = 0;
+        uint32_t issueCount = 0;
+        uint32_t artifactCount = 0;
+        Component::ReleaseType type = Component::ReleaseType::STABLE;
+        Component::ReleaseUrgency urgency = Component::ReleaseUrgency::MEDIUM;
+    };
+
+    struct IssueRecord {
+        StringRef url;
+        StringRef value;
+        Component::IssueType type = Component::IssueType::UNKNOWN;
+    };
+
+    struct ArtifactRecord {
+        StringRef location;
+        uint64_t size[2] = {kNoSize, kNoSize};
+        uint32_t firstChecksum = 0;
+        uint32_t checksumCount = 0;
+    };
+
+    struct ChecksumRecord {
+        uint32_t digestOffset = 0;
+        ChecksumType type = ChecksumType::SHA256;
+    };
+
+    std::vector<ReleaseRecord> releases_;
+    std::vector<IssueRecord> issues_;
+    std::vector<ArtifactRecord> artifacts_;
+    std::vector<ChecksumRecord> checksums_;
+    std::vector<uint8_t> digests_;
+    std::string strings_;
+
+    [[nodiscard]] std::string_view string(const StringRef ref) const {
+        return {strings_.data() + ref.offset, ref.length};
+    }
+
+    StringRef intern(std::string_view value);
+};
+
+#endif // RELEASESTORE_H
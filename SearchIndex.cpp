@@ -0,0 +1,210 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SearchIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+// Query scratch, reused across calls on the same thread
+struct Scratch {
+    std::vector<uint32_t> scores;
+    std::vector<uint32_t> touched;
+    std::vector<uint32_t> kth;
+    std::string token;
+};
+
+thread_local Scratch scratch;
+}
+
+SearchIndex::SearchIndex(const Params &params) : params_(params) {
+}
+
+void SearchIndex::add(const Component &component, const std::string_view description) {
+    const auto ordinal = documents_++;
+    const auto begin = pending_.size();
+    float length = 0;
+    std::string token;
+
+    const auto addField = [&](const std::string_view text, const Field field) {
+        const float weight = params_.weights[field];
+        tokenize(text, field == DESCRIPTION, token, [&](const std::string_view term) {
+            pending_.push_back({dictionary_.intern(term), ordinal, weight});
+            length += weight;
+        });
+    };
+    addField(component.name, NAME);
+    addField(component.summary, SUMMARY);
+    for (const auto &keyword: component.keywords) {
+        addField(keyword, KEYWORDS);
+    }
+    addField(description, DESCRIPTION);
+    lengths_.push_back(length);
+
+    // Fold repeated terms into one weighted frequency
+    const auto first = pending_.begin() + static_cast<long>(begin);
+    std::sort(first, pending_.end(), [](const Pending &a, const Pending &b) { return a.term < b.term; });
+    auto out = first;
+    for (auto it = first; it != pending_.end(); ++it) {
+        if (out != first && (out - 1)->term == it->term) {
+            (out - 1)->frequency += it->frequency;
+        } else {
+            *out++ = *it;
+        }
+    }
+    pending_.erase(out, pending_.end());
+}
+
+void SearchIndex::finish() {
+    const size_t termCount = dictionary_.size();
+    const float averageLength = documents_
+                                    ? std::accumulate(lengths_.begin(), lengths_.end(), 0.0f) /
+                                      static_cast<float>(documents_)
+                                    : 1.0f;
+
+    offsets_.assign(termCount + 1, 0);
+    for (const auto &posting: pending_) {
+        ++offsets_[posting.term + 1];
+    }
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+    // BM25F score of every posting, bucketed by term
+    std::vector<std::pair<float, uint32_t> > scored(pending_.size());
+    std::vector<uint32_t> fill(offsets_.begin(), offsets_.end() - 1);
+    float maxScore = 0;
+    for (const auto &[term, ordinal, frequency]: pending_) {
+        const auto df = static_cast<float>(offsets_[term + 1] - offsets_[term]);
+        const float idf = std::log(1.0f + (static_cast<float>(documents_) - df + 0.5f) / (df + 0.5f));
+        const float norm = params_.k1 * (1.0f - params_.b + params_.b * lengths_[ordinal] / averageLength);
+        const float score = idf * frequency * (params_.k1 + 1.0f) / (frequency + norm);
+        scored[fill[term]++] = {score, ordinal};
+        maxScore = std::max(maxScore, score);
+    }
+    pending_ = {};
+    lengths_ = {};
+
+    scale_ = maxScore > 0 ? 65535.0f / maxScore : 1.0f;
+    ordinals_.resize(scored.size());
+    impacts_.resize(scored.size());
+    for (size_t term = 0; term < termCount; ++term) {
+        const auto first = scored.begin() + offsets_[term];
+        const auto last = scored.begin() + offsets_[term + 1];
+        std::sort(first, last, [](const auto &a, const auto &b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        for (auto i = offsets_[term]; i < offsets_[term + 1]; ++i) {
+            ordinals_[i] = scored[i].second;
+            // Round up so a matching posting never quantizes to zero
+            impacts_[i] = static_cast<uint16_t>(std::min(65535.0f, std::ceil(scored[i].first * scale_)));
+        }
+    }
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::search(const std::string_view query, const size_t limit) const {
+    std::vector<uint32_t> terms;
+    tokenize(query, false, scratch.token, [&](const std::string_view token) {
+        if (const auto term = dictionary_.find(token); term && offsets_[*term] != offsets_[*term + 1]) {
+            terms.push_back(*term);
+        }
+    });
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (terms.empty() || limit == 0) {
+        return {};
+    }
+
+    // Strongest lists first, so the threshold rises early
+    std::sort(terms.begin(), terms.end(), [&](const uint32_t a, const uint32_t b) {
+        return maxImpact(a) > maxImpact(b);
+    });
+    std::vector<uint32_t> remaining(terms.size() + 1, 0);
+    for (size_t i = terms.size(); i-- > 0;) {
+        remaining[i] = remaining[i + 1] + maxImpact(terms[i]);
+    }
+
+    auto &scores = scratch.scores;
+    auto &touched = scratch.touched;
+    scores.resize(documents_, 0);
+    touched.clear();
+
+    uint32_t threshold = 0;
+    for (size_t t = 0; t < terms.size(); ++t) {
+        const auto term = terms[t];
+        size_t i = offsets_[term];
+        const size_t last = offsets_[term + 1];
+        // A component first seen here scores at most its impact plus the later lists'
+        // maxima; once that falls below the current k-th score it cannot make the top k.
+        for (; i < last; ++i) {
+            if (impacts_[i] + remaining[t + 1] < threshold) {
+                break;
+            }
+            if (scores[ordinals_[i]] == 0) {
+                touched.push_back(ordinals_[i]);
+            }
+            scores[ordinals_[i]] += impacts_[i];
+        }
+        for (; i < last; ++i) {
+            if (auto &score = scores[ordinals_[i]]) {
+                score += impacts_[i];
+            }
+        }
+        if (t + 1 < terms.size() && touched.size() >= limit) {
+            auto &kth = scratch.kth;
+            kth.clear();
+            for (const auto ordinal: touched) {
+                kth.push_back(scores[ordinal]);
+            }
+            std::nth_element(kth.begin(), kth.begin() + static_cast<long>(limit - 1), kth.end(),
+                             std::greater<>());
+            threshold = kth[limit - 1];
+        }
+    }
+
+    // Bounded min-heap of the best limit candidates
+    const auto better = [&](const uint32_t a, const uint32_t b) {
+        return scores[a] != scores[b] ? scores[a] > scores[b] : a < b;
+    };
+    std::vector<uint32_t> heap;
+    heap.reserve(std::min(limit, touched.size()));
+    for (const auto ordinal: touched) {
+        if (heap.size() < limit) {
+            heap.push_back(ordinal);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(ordinal, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = ordinal;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), better);
+
+    std::vector<Hit> hits;
+    hits.reserve(heap.size());
+    for (const auto ordinal: heap) {
+        hits.push_back({ordinal, static_cast<float>(scores[ordinal]) / scale_});
+    }
+    for (const auto ordinal: touched) {
+        scores[ordinal] = 0;
+    }
+    return hits;
+}
+
+size_t SearchIndex::memoryUsage() const {
+    return offsets_.capacity() * sizeof(uint32_t) + ordinals_.capacity() * sizeof(uint32_t) +
+           impacts_.capacity() * sizeof(uint16_t);
+}
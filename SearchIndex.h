@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+#include "TermDictionary.h"
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief BM25 full-text index over name, summary, keywords and description.
+ *
+ * Field term frequencies are combined with per-field weights before BM25
+ * saturation (BM25F). Scores are precomputed at build time and quantized to
+ * 16-bit impacts; each term's postings are stored highest impact first, so a
+ * query only adds integers and can stop admitting new candidates once the
+ * remaining lists cannot lift them into the top k.
+ */
+class AS_EXPORT SearchIndex {
+public:
+    enum Field { NAME, SUMMARY, KEYWORDS, DESCRIPTION, FIELD_COUNT };
+
+    struct Params {
+        std::array<float, FIELD_COUNT> weights{4.0f, 2.0f, 3.0f, 1.0f};
+        float k1 = 1.2f;
+        float b = 0.75f;
+    };
+
+    struct Hit {
+        uint32_t ordinal;
+        float score;
+    };
+
+    explicit SearchIndex(const Params &params);
+
+    /// Tokenizes the next component; description is its (possibly inflated) markup.
+    void add(const Component &component, std::string_view description);
+
+    /// Computes impacts and lays out the postings.
+    void finish();
+
+    /// Up to limit components matching any query term, best first.
+    [[nodiscard]] std::vector<Hit> search(std::string_view query, size_t limit) const;
+
+    [[nodiscard]] size_t termCount() const { return dictionary_.size(); }
+
+    [[nodiscard]] size_t postingCount() const { return ordinals_.size(); }
+
+    /// Bytes held by the postings and offsets, excluding the dictionary.
+    [[nodiscard]] size_t memoryUsage() const;
+
+    /// Calls sink with each lower-cased token of text; non-ASCII bytes are kept as word
+    /// characters. With markup, tags and entities are skipped.
+    template<typename Sink>
+    static void tokenize(std::string_view text, bool markup, std::string &scratch, Sink &&sink);
+
+private:
+    struct Pending {
+        uint32_t term;
+        uint32_t ordinal;
+        float frequency;
+    };
+
+    Params params_;
+    TermDictionary dictionary_;
+    uint32_t documents_ = 0;
+
+    // Build state, released by finish()
+    std::vector<Pending> pending_;
+    std::vector<float> lengths_;
+
+    // Per term: ordinals_/impacts_[offsets_[t], offsets_[t + 1]), impact descending
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> ordinals_;
+    std::vector<uint16_t> impacts_;
+    float scale_ = 1.0f;
+
+    [[nodiscard]] uint32_t maxImpact(uint32_t term) const { return impacts_[offsets_[term]]; }
+};
+
+template<typename Sink>
+void SearchIndex::tokenize(const std::string_view text, const bool markup, std::string &scratch, Sink &&sink) {
+    size_t i = 0;
+    while (i < text.size()) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (markup && (c == '<' || c == '&')) {
+            const auto close = text.find(c == '<' ? '>' : ';', i);
+            i = close == std::string_view::npos ? text.size() : close + 1;
+            continue;
+        }
+        if (!std::isalnum(c) && c < 0x80) {
+            ++i;
+            continue;
+        }
+        scratch.clear();
+        for (; i < text.size(); ++i) {
+            const auto w = static_cast<unsigned char>(text[i]);
+            if (w >= 0x80 || std::isalnum(w)) {
+                scratch.push_back(static_cast<char>(std::tolower(w)));
+            } else {
+                break;
+            }
+        }
+        sink(std::string_view(scratch));
+    }
+}
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SimilarityIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace {
+uint64_t splitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+/// Multiply-shift hash functions h(x) = (a * x + b) >> 32 with odd a, from a fixed seed.
+struct HashFamily {
+    std::array<uint64_t, SimilarityIndex::kHashes> a{};
+    std::array<uint64_t, SimilarityIndex::kHashes> b{};
+
+    HashFamily() {
+        for (size_t i = 0; i < SimilarityIndex::kHashes; ++i) {
+            a[i] = splitMix64(2 * i) | 1;
+            b[i] = splitMix64(2 * i + 1);
+        }
+    }
+};
+
+const HashFamily kFamily;
+}
+
+void SimilarityIndex::add(const IdRange categories, const IdRange keywords) {
+    const auto start = signatures_.size();
+    signatures_.resize(start + kHashes, std::numeric_limits<uint32_t>::max());
+    auto *signature = signatures_.data() + start;
+    const auto addTerm = [&](const uint64_t element) {
+        const auto x = splitMix64(element);
+        for (size_t i = 0; i < kHashes; ++i) {
+            signature[i] = std::min(signature[i], static_cast<uint32_t>((kFamily.a[i] * x + kFamily.b[i]) >> 32));
+        }
+    };
+    // The same word as a category and as a keyword are different elements
+    for (const auto term: categories) {
+        addTerm(uint64_t{term} << 1);
+    }
+    for (const auto term: keywords) {
+        addTerm(uint64_t{term} << 1 | 1);
+    }
+}
+
+void SimilarityIndex::finish() {
+    bandOffsets_.assign(1, 0);
+    for (size_t band = 0; band < kBands; ++band) {
+        const auto first = entries_.size();
+        for (uint32_t ordinal = 0; ordinal < size(); ++ordinal) {
+            if (signature(ordinal)[0] != std::numeric_limits<uint32_t>::max()) {
+                entries_.push_back({bucketKey(ordinal, band), ordinal});
+            }
+        }
+        std::sort(entries_.begin() + static_cast<std::ptrdiff_t>(first), entries_.end(),
+                  [](const Entry &x, const Entry &y) {
+                      return x.key < y.key || (x.key == y.key && x.ordinal < y.ordinal);
+                  });
+        bandOffsets_.push_back(static_cast<uint32_t>(entries_.size()));
+    }
+    entries_.shrink_to_fit();
+}
+
+uint64_t SimilarityIndex::bucketKey(const uint32_t ordinal, const size_t band) const {
+    const auto *values = signature(ordinal) + band * kRows;
+    uint64_t key = band;
+    for (size_t row = 0; row < kRows; ++row) {
+        key = splitMix64(key ^ values[row]);
+    }
+    return key;
+}
+
+std::vector<SimilarityIndex::Similar> SimilarityIndex::similar(const uint32_t ordinal, const size_t limit) const {
+    std::vector<Similar> results;
+    if (ordinal >= size() || signature(ordinal)[0] == std::numeric_limits<uint32_t>::max() || limit == 0) {
+        return results;
+    }
+    std::vector<uint32_t> candidates;
+    for (size_t band = 0; band < kBands; ++band) {
+        const auto key = bucketKey(ordinal, band);
+        const auto first = entries_.begin() + bandOffsets_[band];
+        const auto last = entries_.begin() + bandOffsets_[band + 1];
+        auto bucket = std::lower_bound(first, last, key, [](const Entry &entry, const uint64_t k) {
+            return entry.key < k;
+        });
+        for (size_t taken = 0; bucket != last && bucket->key == key && taken < kMaxBucket; ++bucket, ++taken) {
+            if (bucket->ordinal != ordinal) {
+                candidates.push_back(bucket->ordinal);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    results.reserve(candidates.size());
+    for (const auto candidate: candidates) {
+        results.push_back({candidate, similarity(ordinal, candidate)});
+    }
+    const auto better = [](const Similar &x, const Similar &y) {
+        return x.similarity > y.similarity || (x.similarity == y.similarity && x.ordinal < y.ordinal);
+    };
+    if (results.size() > limit) {
+        std::partial_sort(results.begin(), results.begin() + static_cast<std::ptrdiff_t>(limit), results.end(),
+                          better);
+        results.resize(limit);
+    } else {
+        std::sort(results.begin(), results.end(), better);
+    }
+    return results;
+}
+
+float SimilarityIndex::similarity(const uint32_t a, const uint32_t b) const {
+    const auto *x = signature(a);
+    const auto *y = signature(b);
+    size_t equal = 0;
+    for (size_t i = 0; i < kHashes; ++i) {
+        equal += x[i] == y[i];
+    }
+    return static_cast<float>(equal) / static_cast<float>(kHashes);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include "AppStreamExport.h"
+#include "FacetIndex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @brief Approximate Jaccard similarity of components over their categories and keywords.
+ *
+ * Each component gets a MinHash signature of kHashes minimum hash values over
+ * its terms; two signatures agree in a position with probability equal to the
+ * Jaccard similarity of the term sets. Signatures are cut into kBands bands of
+ * kRows values, and components sharing any band land in the same bucket, so
+ * similar() only scores the few components that collide with the query
+ * instead of the whole catalog. Pairs with a similarity around 0.5 or more are
+ * found with high probability.
+ */
+class AS_EXPORT SimilarityIndex {
+public:
+    static constexpr size_t kHashes = 64;
+    static constexpr size_t kBands = 16;
+    static constexpr size_t kRows = kHashes / kBands;
+
+    struct Similar {
+        uint32_t ordinal;
+        /// Estimated Jaccard similarity, in steps of 1 / kHashes.
+        float similarity;
+    };
+
+    /// Appends the next component's category and keyword terms.
+    void add(IdRange categories, IdRange keywords);
+
+    /// Builds the band buckets; call once after the last add().
+    void finish();
+
+    [[nodiscard]] size_t size() const { return signatures_.size() / kHashes; }
+
+    /// Most similar components to ordinal, best first, excluding itself; empty if it has no terms.
+    [[nodiscard]] std::vector<Similar> similar(uint32_t ordinal, size_t limit = 10) const;
+
+    /// Estimated Jaccard similarity of two components: the fraction of agreeing signature values.
+    [[nodiscard]] float similarity(uint32_t a, uint32_t b) const;
+
+private:
+    // Largest part of a bucket scanned per band, so huge buckets of identical term sets stay cheap
+    static constexpr size_t kMaxBucket = 256;
+
+    struct Entry {
+        uint64_t key;
+        uint32_t ordinal;
+    };
+
+    std::vector<uint32_t> signatures_;
+    // Entries of each band sorted by bucket key; components without terms are left out
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> bandOffsets_;
+
+    [[nodiscard]] const uint32_t *signature(const uint32_t ordinal) const {
+        return signatures_.data() + ordinal * kHashes;
+    }
+
+    [[nodiscard]] uint64_t bucketKey(uint32_t ordinal, size_t band) const;
+};
+
+#endif // SIMILARITYINDEX_H
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SpillStore.h"
+#include "ComponentCodec.h"
+
+#include <spdlog/spdlog.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+SpillStore::SpillStore(const std::string &directory, const size_t budgetBytes, const ReleaseStore *releases)
+    : budgetBytes_(budgetBytes), releases_(releases) {
+    std::string path = directory + "/appstream_parser-spill-XXXXXX";
+    fd_ = mkstemp(path.data());
+    if (fd_ == -1) {
+        spdlog::error("Failed to create spill file in {}: {}", directory, strerror(errno));
+        throw std::runtime_error("Failed to create spill file");
+    }
+    // The file only lives as long as the descriptor
+    unlink(path.c_str());
+}
+
+SpillStore::~SpillStore() {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+uint32_t SpillStore::add(std::shared_ptr<Component> component) {
+    std::lock_guard lock(mutex_);
+    const auto slot = static_cast<uint32_t>(slots_.size());
+    slots_.emplace_back();
+    makeResident(slot, std::move(component));
+    return slot;
+}
+
+std::shared_ptr<Component> SpillStore::get(const uint32_t slot) {
+    std::lock_guard lock(mutex_);
+    auto &entry = slots_.at(slot);
+    if (entry.resident) {
+        ++hits_;
+        lru_.splice(lru_.begin(), lru_, entry.lru);
+        return entry.resident;
+    }
+
+    ++misses_;
+    buffer_.resize(entry.length);
+    if (pread(fd_, buffer_.data(), entry.length, static_cast<off_t>(entry.offset)) !=
+        static_cast<ssize_t>(entry.length)) {
+        spdlog::error("Failed to read spilled component from slot {}: {}", slot, strerror(errno));
+        throw std::runtime_error("Failed to read spill file");
+    }
+    auto component =
+            ComponentCodec::decode(reinterpret_cast<const uint8_t *>(buffer_.data()), buffer_.size(), releases_);
+    makeResident(slot, component);
+    return component;
+}
+
+void SpillStore::setOverhead(const size_t bytes) {
+    std::lock_guard lock(mutex_);
+    overheadBytes_ = bytes;
+    if (const auto fixed = fixedBytes(); !overBudget_ && fixed >= budgetBytes_) {
+        overBudget_ = true;
+        spdlog::warn("Memory budget of {} KB is used up by {} KB of catalog indexes and stores; components will be "
+                     "read from the spill file on nearly every access", budgetBytes_ / 1024, fixed / 1024);
+    }
+    evictToBudget();
+}
+
+size_t SpillStore::fixedBytes() const {
+    // A list node holds the slot and two pointers
+    constexpr size_t kNodeBytes = 2 * sizeof(void *) + sizeof(uint32_t);
+    return overheadBytes_ + slots_.capacity() * sizeof(Slot) + lru_.size() * kNodeBytes + buffer_.capacity();
+}
+
+void SpillStore::makeResident(const uint32_t slot, std::shared_ptr<Component> component) {
+    auto &entry = slots_[slot];
+    entry.bytes = static_cast<uint32_t>(component->memoryFootprint());
+    entry.resident = std::move(component);
+    lru_.push_front(slot);
+    entry.lru = lru_.begin();
+    residentBytes_ += entry.bytes;
+    evictToBudget();
+}
+
+void SpillStore::evictToBudget() {
+    // Always keep the most recent component, even when it alone exceeds the budget
+    while (residentBytes_ + fixedBytes() > budgetBytes_ && lru_.size() > 1) {
+        evict();
+    }
+}
+
+void SpillStore::evict() {
+    const uint32_t slot = lru_.back();
+    lru_.pop_back();
+    auto &entry = slots_[slot];
+
+    if (!entry.written) {
+        buffer_.clear();
+        ComponentCodec::encode(*entry.resident, buffer_);
+        if (pwrite(fd_, buffer_.data(), buffer_.size(), static_cast<off_t>(fileSize_)) !=
+            static_cast<ssize_t>(buffer_.size())) {
+            spdlog::error("Failed to write spill file: {}", strerror(errno));
+            throw std::runtime_error("Failed to write spill file");
+        }
+        entry.offset = fileSize_;
+        entry.length = static_cast<uint32_t>(buffer_.size());
+        entry.written = true;
+        fileSize_ += buffer_.size();
+    }
+
+    residentBytes_ -= entry.bytes;
+    entry.resident.reset();
+    ++evictions_;
+}
+
+size_t SpillStore::size() const {
+    std::lock_guard lock(mutex_);
+    return slots_.size();
+}
+
+SpillStore::Stats SpillStore::stats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    stats.residentComponents = lru_.size();
+    stats.residentBytes = residentBytes_;
+    stats.spilledBytes = fileSize_;
+    stats.overheadBytes = fixedBytes();
+    stats.budgetBytes = budgetBytes_;
+    return stats;
+}
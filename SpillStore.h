@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPILLSTORE_H
+#define SPILLSTORE_H
+
+#include "AppStreamExport.h"
+#include "Component.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Keeps components within a byte budget, spilling cold ones to disk.
+ *
+ * Each component is held in a slot. Resident components are tracked in LRU
+ * order; once the resident footprint, the store's slot table and the
+ * overhead set by the owner exceed the budget, the least recently used ones
+ * are encoded with ComponentCodec into an unlinked temporary file and
+ * dropped. get() transparently decodes a spilled component again.
+ *
+ * Components are written at most once, so changes made to a component
+ * after it was added are lost when it is evicted.
+ */
+class AS_EXPORT SpillStore {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t residentComponents = 0;
+        size_t residentBytes = 0;
+        size_t spilledBytes = 0;
+        /// Bytes that cannot be spilled: the owner's catalog-wide indexes and stores and this store's slot table.
+        size_t overheadBytes = 0;
+        size_t budgetBytes = 0;
+    };
+
+    /// Reloaded components refer to their releases in releases.
+    SpillStore(const std::string &directory, size_t budgetBytes, const ReleaseStore *releases = nullptr);
+
+    ~SpillStore();
+
+    SpillStore(const SpillStore &) = delete;
+
+    SpillStore &operator=(const SpillStore &) = delete;
+
+    /// Takes ownership of component and returns its slot.
+    uint32_t add(std::shared_ptr<Component> component);
+
+    [[nodiscard]] std::shared_ptr<Component> get(uint32_t slot);
+
+    /**
+     * @brief Sets the bytes held elsewhere that count against the budget, leaving less room for resident components.
+     *
+     * Logs a warning the first time the overhead alone reaches the budget: only the most recent
+     * component then stays resident and nearly every get() reads the spill file.
+     */
+    void setOverhead(size_t bytes);
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Slot {
+        std::shared_ptr<Component> resident;
+        uint64_t offset = 0;
+        uint32_t length = 0;
+        uint32_t bytes = 0;
+        bool written = false;
+        std::list<uint32_t>::iterator lru;
+    };
+
+    int fd_ = -1;
+    uint64_t fileSize_ = 0;
+    size_t budgetBytes_;
+    const ReleaseStore *releases_;
+    size_t residentBytes_ = 0;
+    size_t overheadBytes_ = 0;
+    std::vector<Slot> slots_;
+    // Most recently used first
+    std::list<uint32_t> lru_;
+    std::string buffer_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t evictions_ = 0;
+    bool overBudget_ = false;
+    mutable std::mutex mutex_;
+
+    /// Overhead plus the slot table, LRU list and I/O buffer.
+    [[nodiscard]] size_t fixedBytes() const;
+
+    void makeResident(uint32_t slot, std::shared_ptr<Component> component);
+
+    void evictToBudget();
+
+    void evict();
+};
+
+#endif // SPILLSTORE_H
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SubstringSearch.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+#if defined(__AVX2__)
+constexpr size_t kLanes = 32;
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+constexpr size_t kLanes = 16;
+#else
+constexpr size_t kLanes = 1;
+#endif
+
+/// Bit i set when text[i] == first and text[i + lastOffset] == last, for kLanes positions.
+inline uint64_t candidates(const char *text, const size_t lastOffset, const char first, const char last) {
+#if defined(__AVX2__)
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + lastOffset));
+    const __m256i match = _mm256_and_si256(_mm256_cmpeq_epi8(a, _mm256_set1_epi8(first)),
+                                           _mm256_cmpeq_epi8(b, _mm256_set1_epi8(last)));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(match));
+#elif defined(__SSE2__)
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + lastOffset));
+    const __m128i match = _mm_and_si128(_mm_cmpeq_epi8(a, _mm_set1_epi8(first)),
+                                        _mm_cmpeq_epi8(b, _mm_set1_epi8(last)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(match));
+#elif defined(__ARM_NEON)
+    const uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(text));
+    const uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(text + lastOffset));
+    const uint8x16_t match = vandq_u8(vceqq_u8(a, vdupq_n_u8(static_cast<uint8_t>(first))),
+                                      vceqq_u8(b, vdupq_n_u8(static_cast<uint8_t>(last))));
+    // Narrow each byte of the mask to a nibble, then keep one bit per nibble
+    const uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+    uint64_t bits = 0;
+    for (auto n = nibbles & 0x1111111111111111; n != 0; n &= n - 1) {
+        bits |= uint64_t{1} << (__builtin_ctzll(n) >> 2);
+    }
+    return bits;
+#else
+    return text[0] == first && text[lastOffset] == last;
+#endif
+}
+}
+
+void SubstringSearch::add(const std::string_view name, const std::string_view summary) {
+    if (!blob_.empty()) {
+        blob_.resize(blob_.size() - kPadding);
+    }
+    blob_ += fold(name);
+    blob_.push_back('\n');
+    blob_ += fold(summary);
+    blob_.push_back('\0');
+    offsets_.push_back(static_cast<uint32_t>(blob_.size()));
+    blob_.append(kPadding, '\0');
+}
+
+std::vector<uint32_t> SubstringSearch::search(const std::string_view query, ThreadPool *pool) const {
+    std::vector<uint32_t> ordinals;
+    const auto needle = fold(query);
+    // Separators never match, so a hit never spans two fields or components
+    if (needle.empty() || needle.find_first_of(std::string_view("\n\0", 2)) != std::string::npos || size() == 0) {
+        return ordinals;
+    }
+    if (!pool || pool->size() < 2) {
+        scan(needle, 0, static_cast<uint32_t>(size()), ordinals);
+        return ordinals;
+    }
+
+    // Slices of about equal bytes, cut at component boundaries
+    const auto slices = pool->size();
+    std::vector<uint32_t> bounds{0};
+    for (size_t slice = 1; slice < slices; ++slice) {
+        const auto target = static_cast<uint32_t>(offsets_.back() * slice / slices);
+        const auto bound = static_cast<uint32_t>(std::upper_bound(offsets_.begin(), offsets_.end() - 1, target) -
+                                                 offsets_.begin());
+        bounds.push_back(std::max(bounds.back(), std::min(bound, static_cast<uint32_t>(size()))));
+    }
+    bounds.push_back(static_cast<uint32_t>(size()));
+    std::vector<std::vector<uint32_t> > results(slices);
+    for (size_t slice = 0; slice < slices; ++slice) {
+        pool->submit([this, &needle, &bounds, &results, slice] {
+            scan(needle, bounds[slice], bounds[slice + 1], results[slice]);
+        });
+    }
+    pool->wait();
+    for (const auto &result: results) {
+        ordinals.insert(ordinals.end(), result.begin(), result.end());
+    }
+    return ordinals;
+}
+
+void SubstringSearch::scan(const std::string_view needle, const uint32_t first, const uint32_t last,
+                           std::vector<uint32_t> &out) const {
+    const auto length = needle.size();
+    const auto *text = blob_.data();
+    const size_t end = offsets_[last];
+    // Bytes between the first and the last byte of the needle
+    const auto middle = length < 2 ? 0 : length - 2;
+    auto ordinal = first;
+    for (size_t i = offsets_[first]; i + length <= end;) {
+        // The kPadding zero bytes keep both loads inside the buffer
+        auto bits = candidates(text + i, length - 1, needle.front(), needle.back());
+        size_t next = i + kLanes;
+        for (; bits != 0; bits &= bits - 1) {
+            const auto position = i + static_cast<size_t>(__builtin_ctzll(bits));
+            if (position + length > end || std::memcmp(text + position + 1, needle.data() + 1, middle) != 0) {
+                continue;
+            }
+            // One hit per component; resume at the next one
+            while (offsets_[ordinal + 1] <= position) {
+                ++ordinal;
+            }
+            out.push_back(ordinal);
+            next = offsets_[ordinal + 1];
+            break;
+        }
+        i = next;
+    }
+}
+
+std::string SubstringSearch::fold(const std::string_view text) {
+    std::string folded(text);
+    for (auto &c: folded) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c + ('a' - 'A'));
+        }
+    }
+    return folded;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SUBSTRINGSEARCH_H
+#define SUBSTRINGSEARCH_H
+
+#include "AppStreamExport.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ThreadPool;
+
+
+/**
+ * @brief Brute-force substring search over the names and summaries of a catalog.
+ *
+ * The text of all components is case-folded into one contiguous buffer with an
+ * offset per component. search() compares the first and the last byte of the
+ * query against 32 (AVX2) or 16 (SSE2, NEON) candidate positions at once and
+ * only verifies positions where both match, so partial words such as "pdf" in
+ * "PDFMerge" are found at memory bandwidth without any index.
+ */
+class AS_EXPORT SubstringSearch {
+public:
+    /// Appends the text of the next component.
+    void add(std::string_view name, std::string_view summary);
+
+    /// Number of components.
+    [[nodiscard]] size_t size() const { return offsets_.size() - 1; }
+
+    /// Case-folded name and summary of a component, separated by a newline.
+    [[nodiscard]] std::string_view text(const uint32_t ordinal) const {
+        return {blob_.data() + offsets_[ordinal], offsets_[ordinal + 1] - offsets_[ordinal] - 1};
+    }
+
+    /// Bytes of the text buffer.
+    [[nodiscard]] size_t bytes() const { return blob_.size(); }
+
+    /**
+     * @brief Ordinals of the components whose name or summary contains query, ascending.
+     *
+     * Matching ignores ASCII case. With a pool the buffer is split into one
+     * slice per worker; the pool must not be running other tasks.
+     */
+    [[nodiscard]] std::vector<uint32_t> search(std::string_view query, ThreadPool *pool = nullptr) const;
+
+    /// ASCII lowercase copy of text; other bytes, including UTF-8 sequences, are kept.
+    static std::string fold(std::string_view text);
+
+private:
+    // Zero bytes after the text, so vector loads near the end stay in bounds
+    static constexpr size_t kPadding = 64;
+
+    // Text of every component, each ending in a zero byte, then kPadding zero bytes
+    std::string blob_;
+    std::vector<uint32_t> offsets_{0};
+
+    void scan(std::string_view needle, uint32_t first, uint32_t last, std::vector<uint32_t> &out) const;
+};
+
+#endif // SUBSTRINGSEARCH_H
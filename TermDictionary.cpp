@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TermDictionary.h"
+
+TermDictionary::TermId TermDictionary::intern(const std::string_view text) {
+    if (const auto it = ids_.find(text); it != ids_.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<TermId>(terms_.size());
+    const auto &stored = terms_.emplace_back(text);
+    ids_.emplace(stored, id);
+    // Strings within the small string buffer do not allocate
+    textBytes_ += stored.capacity() > sizeof(std::string) - 1 ? stored.capacity() + 1 : 0;
+    return id;
+}
+
+std::optional<TermDictionary::TermId> TermDictionary::find(const std::string_view text) const {
+    if (const auto it = ids_.find(text); it != ids_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+size_t TermDictionary::memoryFootprint() const {
+    // A hash node holds the entry and a next pointer
+    constexpr size_t kNodeBytes = sizeof(void *) + sizeof(decltype(ids_)::value_type);
+    return terms_.size() * (sizeof(std::string) + kNodeBytes) + ids_.bucket_count() * sizeof(void *) + textBytes_;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TERMDICTIONARY_H
+#define TERMDICTIONARY_H
+
+#include "AppStreamExport.h"
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+/**
+ * @brief Interns strings into dense 32-bit term handles.
+ *
+ * Term text is stored once; string_views returned by term() stay valid for
+ * the lifetime of the dictionary.
+ */
+class AS_EXPORT TermDictionary {
+public:
+    using TermId = uint32_t;
+
+    TermId intern(std::string_view text);
+
+    [[nodiscard]] std::optional<TermId> find(std::string_view text) const;
+
+    [[nodiscard]] std::string_view term(const TermId id) const { return terms_[id]; }
+
+    [[nodiscard]] size_t size() const { return terms_.size(); }
+
+    /// Heap bytes of the terms and the hash table, estimated from their sizes.
+    [[nodiscard]] size_t memoryFootprint() const;
+
+private:
+    // deque keeps element addresses stable, so the map keys can view into it
+    std::deque<std::string> terms_;
+    std::unordered_map<std::string_view, TermId> ids_;
+    // Heap bytes of the term texts
+    size_t textBytes_ = 0;
+};
+
+#endif // TERMDICTIONARY_H
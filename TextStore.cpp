@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextStore.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <zlib.h>
+
+TextStore::TextStore(const size_t blockSize, const size_t cachedBlocks)
+    : blockSize_(blockSize), cachedBlocks_(std::max<size_t>(cachedBlocks, 1)) {
+}
+
+TextStore::Handle TextStore::append(const std::string_view text) {
+    std::lock_guard lock(mutex_);
+    const auto handle = static_cast<Handle>(locations_.size());
+    locations_.push_back({
+        static_cast<uint32_t>(blocks_.size()), static_cast<uint32_t>(pending_.size()),
+        static_cast<uint32_t>(text.size())
+    });
+    pending_.append(text);
+    rawBytes_ += text.size();
+    if (pending_.size() >= blockSize_) {
+        compressPending();
+    }
+    return handle;
+}
+
+void TextStore::flush() {
+    std::lock_guard lock(mutex_);
+    if (!pending_.empty()) {
+        compressPending();
+    }
+}
+
+TextStore::Mark TextStore::mark() const {
+    std::lock_guard lock(mutex_);
+    return {
+        static_cast<uint32_t>(locations_.size()), static_cast<uint32_t>(blocks_.size()),
+        static_cast<uint32_t>(pending_.size()), rawBytes_
+    };
+}
+
+void TextStore::rollback(const Mark &mark) {
+    std::lock_guard lock(mutex_);
+    if (blocks_.size() > mark.blocks) {
+        // The first block compressed since the mark starts with what was pending at the mark
+        inflate(blocks_[mark.blocks], mark.blocks, pending_);
+        for (auto block = mark.blocks; block < blocks_.size(); ++block) {
+            compressedBytes_ -= blocks_[block].data.size();
+        }
+        blocks_.resize(mark.blocks);
+        cache_.remove_if([&](const auto &entry) { return entry.first >= mark.blocks; });
+    }
+    pending_.resize(mark.pendingBytes);
+    locations_.resize(mark.texts);
+    rawBytes_ = mark.rawBytes;
+}
+
+void TextStore::compressPending() {
+    uLongf compressedSize = compressBound(pending_.size());
+    Block block{std::vector<uint8_t>(compressedSize), static_cast<uint32_t>(pending_.size())};
+    if (const int ret = compress2(block.data.data(), &compressedSize, reinterpret_cast<const Bytef *>(pending_.data()),
+                                  pending_.size(), Z_BEST_COMPRESSION);
+        ret != Z_OK) {
+        spdlog::error("Failed to compress text block, error code: {}", ret);
+        throw std::runtime_error("zlib compress2 failed");
+    }
+    block.data.resize(compressedSize);
+    block.data.shrink_to_fit();
+    compressedBytes_ += compressedSize;
+    blocks_.push_back(std::move(block));
+
+    // Release the pending buffer rather than keeping its high-water capacity
+    std::string().swap(pending_);
+    pending_.reserve(blockSize_);
+}
+
+const std::string &TextStore::inflateBlock(const uint32_t block) const {
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+        if (it->first == block) {
+            ++cacheHits_;
+            cache_.splice(cache_.begin(), cache_, it);
+            return cache_.front().second;
+        }
+    }
+
+    ++cacheMisses_;
+    if (cache_.size() >= cachedBlocks_) {
+        // Reuse the least recently used entry and its buffer
+        cache_.splice(cache_.begin(), cache_, std::prev(cache_.end()));
+    } else {
+        cache_.emplace_front();
+    }
+    cache_.front().first = block;
+    inflate(blocks_[block], block, cache_.front().second);
+    return cache_.front().second;
+}
+
+void TextStore::inflate(const Block &block, const uint32_t index, std::string &text) {
+    text.resize(block.rawSize);
+    uLongf textSize = block.rawSize;
+    if (const int ret = uncompress(reinterpret_cast<Bytef *>(text.data()), &textSize, block.data.data(),
+                                   block.data.size());
+        ret != Z_OK || textSize != block.rawSize) {
+        spdlog::error("Failed to inflate text block {}, error code: {}", index, ret);
+        throw std::runtime_error("zlib uncompress failed");
+    }
+}
+
+std::string TextStore::get(const Handle handle) const {
+    std::string text;
+    get(handle, text);
+    return text;
+}
+
+void TextStore::get(const Handle handle, std::string &text) const {
+    std::lock_guard lock(mutex_);
+    const auto &[block, offset, length] = locations_.at(handle);
+    // A block still pending is not compressed yet
+    text.assign(block == blocks_.size() ? pending_ : inflateBlock(block), offset, length);
+}
+
+TextStore::Stats TextStore::stats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats;
+    stats.texts = locations_.size();
+    stats.blocks = blocks_.size();
+    stats.rawBytes = rawBytes_;
+    stats.compressedBytes = compressedBytes_ + pending_.size();
+    stats.cacheHits = cacheHits_;
+    stats.cacheMisses = cacheMisses_;
+    stats.bytes = compressedBytes_ + blocks_.capacity() * sizeof(Block) + locations_.capacity() * sizeof(Location) +
+                  pending_.capacity();
+    for (const auto &[block, text]: cache_) {
+        stats.bytes += text.capacity();
+    }
+    return stats;
+}
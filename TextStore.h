@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEXTSTORE_H
+#define TEXTSTORE_H
+
+#include "AppStreamExport.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Append-only store of long text fields, compressed with zlib in blocks.
+ *
+ * Texts are concatenated into a block until it reaches the configured size, then
+ * the block is deflated. Reading a text inflates its block into a small LRU cache,
+ * so neighbouring texts (usually the same or adjacent components) are served
+ * without further inflation.
+ */
+class AS_EXPORT TextStore {
+public:
+    using Handle = uint32_t;
+
+    struct Stats {
+        size_t texts = 0;
+        size_t blocks = 0;
+        size_t rawBytes = 0;
+        size_t compressedBytes = 0;
+        size_t cacheHits = 0;
+        size_t cacheMisses = 0;
+        /// Heap bytes of all blocks, buffers and the block cache.
+        size_t bytes = 0;
+    };
+
+    /// Position to roll back to, see mark().
+    struct Mark {
+        uint32_t texts = 0;
+        uint32_t blocks = 0;
+        uint32_t pendingBytes = 0;
+        size_t rawBytes = 0;
+    };
+
+    explicit TextStore(size_t blockSize = 16 * 1024, size_t cachedBlocks = 8);
+
+    /// Appends a text and returns its handle.
+    Handle append(std::string_view text);
+
+    /// Compresses the pending block; called once all texts have been appended.
+    void flush();
+
+    [[nodiscard]] Mark mark() const;
+
+    /// Discards every text appended since mark was taken, inflating a block compressed since then if needed.
+    void rollback(const Mark &mark);
+
+    [[nodiscard]] std::string get(Handle handle) const;
+
+    /// Replaces text with the text of handle, reusing its buffer.
+    void get(Handle handle, std::string &text) const;
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Location {
+        uint32_t block;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct Block {
+        std::vector<uint8_t> data;
+        uint32_t rawSize;
+    };
+
+    size_t blockSize_;
+    size_t cachedBlocks_;
+    std::vector<Location> locations_;
+    std::vector<Block> blocks_;
+    std::string pending_;
+    size_t rawBytes_ = 0;
+    size_t compressedBytes_ = 0;
+
+    // Most recently used first
+    mutable std::list<std::pair<uint32_t, std::string> > cache_;
+    mutable size_t cacheHits_ = 0;
+    mutable size_t cacheMisses_ = 0;
+    mutable std::mutex mutex_;
+
+    void compressPending();
+
+    /// Replaces text with the contents of block, reusing its buffer.
+    static void inflate(const Block &block, uint32_t index, std::string &text);
+
+    const std::string &inflateBlock(uint32_t block) const;
+};
+
+#endif // TEXTSTORE_H
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+// Index of the pool worker running on this thread, if any
+thread_local const ThreadPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i] { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        // Like wait(), but an error nobody waited for is dropped
+        std::unique_lock lock(mutex_);
+        idle_.wait(lock, [this] { return pending_ == 0; });
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    const auto index = currentPool == this
+                           ? currentWorker
+                           : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(mutex_);
+        ++queued_;
+        ++pending_;
+    }
+    workAvailable_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return pending_ == 0; });
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+bool ThreadPool::take(const size_t index, Task &task) {
+    {
+        auto &own = *queues_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        auto &victim = *queues_[(index + i) % queues_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(const size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    for (;;) {
+        {
+            std::unique_lock lock(mutex_);
+            workAvailable_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (queued_ == 0) {
+                return;
+            }
+            // Claim one queued task; it is in some deque and take() will find it
+            --queued_;
+        }
+        Task task;
+        while (!take(index, task)) {
+            // Claims never exceed queued tasks, but a concurrent take can empty a deque
+            // just before the scan reaches it; one task is still left to find
+            std::this_thread::yield();
+        }
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        task = nullptr;
+        {
+            std::lock_guard lock(mutex_);
+            if (error && !error_) {
+                error_ = std::move(error);
+            }
+            if (--pending_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "AppStreamExport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Fixed-size work-stealing thread pool.
+ *
+ * Each worker owns a task deque. Tasks submitted from a worker go to its own
+ * deque, others are spread round-robin. Workers take their newest task first
+ * and, when idle, steal the oldest task of another worker, so uneven task
+ * costs (files of very different sizes) balance out without a shared queue.
+ *
+ * An exception thrown by a task is caught on its worker and rethrown by the
+ * next wait(); the remaining tasks still run.
+ */
+class AS_EXPORT ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /// threads == 0 uses the number of hardware threads.
+    explicit ThreadPool(size_t threads = 0);
+
+    /// Waits for queued tasks, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until every submitted task has finished. Must not be called from a task.
+     *
+     * Rethrows the first exception thrown by a task since the previous wait(); any
+     * later ones are dropped.
+     */
+    void wait();
+
+    [[nodiscard]] size_t size() const { return workers_.size(); }
+
+    /// Tasks taken from another worker's deque since construction.
+    [[nodiscard]] size_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> steals_{0};
+
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable idle_;
+    size_t queued_ = 0;
+    size_t pending_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+
+    void run(size_t index);
+
+    bool take(size_t index, Task &task);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "UpdateChecker.h"
+#include "AppStreamParser.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+// Key tokens, in the order rpmvercmp sorts them
+constexpr char kTilde = 0x00;
+constexpr char kEnd = 0x01;
+constexpr char kCaret = 0x02;
+constexpr char kAlpha = 0x03;
+constexpr char kNumber = 0x04;
+
+bool isDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isAlpha(const char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+}
+
+UpdateChecker::UpdateChecker(const AppStreamParser &parser, const size_t threads) : threads_(threads) {
+    const auto count = parser.getTotalComponentCount();
+    stable_.resize(count);
+    any_.resize(count);
+    std::vector<uint32_t> idOffsets{0};
+    std::string newest;
+    for (size_t ordinal = 0; ordinal < count; ++ordinal) {
+        const auto component = parser.getComponentAt(ordinal);
+        idText_ += component->id;
+        idOffsets.push_back(static_cast<uint32_t>(idText_.size()));
+
+        const auto &range = component->releases;
+        if (range.store) {
+            store_ = range.store;
+        }
+        const auto releases = AppStreamParser::getReleases(*component);
+        for (size_t i = 0; i < releases.size(); ++i) {
+            const auto release = releases[i];
+            const auto key = versionKey(release.version());
+            const auto stable = release.type() != Component::ReleaseType::DEVELOPMENT &&
+                                release.type() != Component::ReleaseType::SNAPSHOT;
+            for (auto *candidate: {stable ? &stable_[ordinal] : nullptr, &any_[ordinal]}) {
+                if (!candidate || (candidate->release != kNone && key <= this->key(*candidate))) {
+                    continue;
+                }
+                candidate->release = range.first + static_cast<uint32_t>(i);
+                candidate->keyOffset = static_cast<uint32_t>(keys_.size());
+                candidate->keyLength = static_cast<uint32_t>(key.size());
+                keys_ += key;
+            }
+        }
+    }
+
+    // The ID text is complete, so views into it stay valid
+    ordinals_.reserve(count);
+    for (uint32_t ordinal = 0; ordinal < count; ++ordinal) {
+        ordinals_.emplace(std::string_view(idText_).substr(idOffsets[ordinal], idOffsets[ordinal + 1] -
+                                                           idOffsets[ordinal]), ordinal);
+    }
+}
+
+std::vector<UpdateChecker::Update> UpdateChecker::check(const std::vector<Installed> &installed,
+                                                        const bool includeDevelopment) const {
+    std::vector<Update> updates;
+    if (installed.size() <= kChunk) {
+        checkRange(installed, 0, installed.size(), includeDevelopment, updates);
+        return updates;
+    }
+    const auto chunks = (installed.size() + kChunk - 1) / kChunk;
+    std::vector<std::vector<Update> > results(chunks);
+    {
+        ThreadPool pool(threads_);
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            pool.submit([&, chunk] {
+                checkRange(installed, chunk * kChunk, std::min(installed.size(), (chunk + 1) * kChunk),
+                           includeDevelopment, results[chunk]);
+            });
+        }
+        pool.wait();
+    }
+    for (const auto &result: results) {
+        updates.insert(updates.end(), result.begin(), result.end());
+    }
+    return updates;
+}
+
+void UpdateChecker::checkRange(const std::vector<Installed> &installed, const size_t first, const size_t last,
+                               const bool includeDevelopment, std::vector<Update> &out) const {
+    const auto &candidates = includeDevelopment ? any_ : stable_;
+    std::string installedKey;
+    for (auto i = first; i < last; ++i) {
+        const auto found = ordinals_.find(installed[i].id);
+        if (found == ordinals_.end()) {
+            continue;
+        }
+        const auto &candidate = candidates[found->second];
+        if (candidate.release == kNone) {
+            continue;
+        }
+        assignVersionKey(installed[i].version, installedKey);
+        if (key(candidate) > installedKey) {
+            out.push_back({static_cast<uint32_t>(i), found->second, {store_, candidate.release}});
+        }
+    }
+}
+
+std::string UpdateChecker::versionKey(const std::string_view version) {
+    std::string key;
+    assignVersionKey(version, key);
+    return key;
+}
+
+void UpdateChecker::assignVersionKey(const std::string_view version, std::string &key) {
+    key.clear();
+    size_t i = 0;
+    while (i < version.size()) {
+        const auto c = version[i];
+        if (c == '~') {
+            key.push_back(kTilde);
+            ++i;
+        } else if (c == '^') {
+            key.push_back(kCaret);
+            ++i;
+        } else if (isDigit(c)) {
+            // Leading zeros do not count; a longer number is a larger one
+            while (i < version.size() && version[i] == '0') {
+                ++i;
+            }
+            const auto start = i;
+            while (i < version.size() && isDigit(version[i])) {
+                ++i;
+            }
+            key.push_back(kNumber);
+            key.push_back(static_cast<char>(std::min<size_t>(i - start, 0xff)));
+            key.append(version.substr(start, i - start));
+        } else if (isAlpha(c)) {
+            key.push_back(kAlpha);
+            while (i < version.size() && isAlpha(version[i])) {
+                key.push_back(version[i++]);
+            }
+            key.push_back('\0');
+        } else {
+            // Separator
+            ++i;
+        }
+    }
+    key.push_back(kEnd);
+}
+
+int UpdateChecker::compareVersions(const std::string_view a, const std::string_view b) {
+    return versionKey(a).compare(versionKey(b));
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef UPDATECHECKER_H
+#define UPDATECHECKER_H
+
+#include "AppStreamExport.h"
+#include "ReleaseStore.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class AppStreamParser;
+
+
+/**
+ * @brief Matches lists of installed components against the releases of a catalog.
+ *
+ * The newest stable and the newest release of any type are picked per
+ * component up front, with their versions turned into sort keys that compare
+ * like rpmvercmp with memcmp. A check is then one hash lookup and one key
+ * comparison per installed component; large lists are split into chunks
+ * checked in parallel.
+ */
+class AS_EXPORT UpdateChecker {
+public:
+    struct Installed {
+        std::string_view id;
+        std::string_view version;
+    };
+
+    struct Update {
+        /// Position in the installed list.
+        uint32_t index;
+        uint32_t ordinal;
+        /// Newest eligible release; its urgency() tells how pressing the update is.
+        ReleaseStore::Release release;
+    };
+
+    /// threads == 0 uses the number of hardware threads.
+    explicit UpdateChecker(const AppStreamParser &parser, size_t threads = 0);
+
+    // The ID map views idText_, so neither copies nor moves are safe
+    UpdateChecker(const UpdateChecker &) = delete;
+
+    UpdateChecker &operator=(const UpdateChecker &) = delete;
+
+    /**
+     * @brief Installed components with a newer release, in installed list order.
+     *
+     * Only stable releases are offered unless includeDevelopment is set, in
+     * which case development and snapshot releases count as well. IDs the
+     * catalog does not know are skipped.
+     */
+    [[nodiscard]] std::vector<Update> check(const std::vector<Installed> &installed,
+                                            bool includeDevelopment = false) const;
+
+    /**
+     * @brief Sort key of a version: keys compare with memcmp as rpmvercmp compares the versions.
+     *
+     * Versions are split into numeric and alphabetic segments at separators
+     * (any other character). Numbers compare by value, letters by byte, a
+     * number is newer than letters, '~' sorts before everything including the
+     * end of the version ("1.0~rc1" < "1.0") and '^' after the end but before
+     * anything else ("1.0" < "1.0^git1" < "1.0.1").
+     */
+    static std::string versionKey(std::string_view version);
+
+    /// Negative, zero or positive as version a is older, equal or newer than b.
+    static int compareVersions(std::string_view a, std::string_view b);
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr size_t kChunk = 1024;
+
+    struct Candidate {
+        uint32_t release = kNone;
+        uint32_t keyOffset = 0;
+        uint32_t keyLength = 0;
+    };
+
+    // Per ordinal: newest stable release, newest release of any type
+    std::vector<Candidate> stable_;
+    std::vector<Candidate> any_;
+    std::string keys_;
+    const ReleaseStore *store_ = nullptr;
+    std::string idText_;
+    std::unordered_map<std::string_view, uint32_t> ordinals_;
+    size_t threads_;
+
+    /// Replaces key with the sort key of version, reusing its buffer.
+    static void assignVersionKey(std::string_view version, std::string &key);
+
+    [[nodiscard]] std::string_view key(const Candidate &candidate) const {
+        return {keys_.data() + candidate.keyOffset, candidate.keyLength};
+    }
+
+    void checkRange(const std::vector<Installed> &installed, size_t first, size_t last, bool includeDevelopment,
+                    std::vector<Update> &out) const;
+};
+
+#endif // UPDATECHECKER_H
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "appstream_catalog.h"
+#include "AppStreamParser.h"
+
+#include <string>
+
+// Component handles are the parser's Component objects. The C API always opens
+// catalogs without a memory budget, so they stay materialized and addressable
+// for the lifetime of the catalog.
+struct as_catalog {
+    std::unique_ptr<AppStreamParser> parser;
+};
+
+namespace {
+thread_local std::string lastError;
+
+const Component *unwrap(const as_component *component) {
+    return reinterpret_cast<const Component *>(component);
+}
+
+const as_component *wrap(const Component *component) {
+    return reinterpret_cast<const as_component *>(component);
+}
+
+as_string view(const std::string_view value) {
+    return {value.data(), value.size()};
+}
+
+const std::vector<std::string> *list(const Component &component, const as_list list) {
+    switch (list) {
+        case AS_LIST_CATEGORIES: return &component.categories;
+        case AS_LIST_KEYWORDS: return &component.keywords;
+        case AS_LIST_SUGGESTS: return &component.suggests;
+        case AS_LIST_LANGUAGES: return &component.supportedLanguages;
+        default: return nullptr;
+    }
+}
+
+AppStreamParser::Facet facet(const as_facet facet) {
+    return facet == AS_FACET_KEYWORD ? AppStreamParser::Facet::KEYWORD : AppStreamParser::Facet::CATEGORY;
+}
+}
+
+extern "C" {
+int as_abi_version(void) {
+    return AS_ABI_VERSION;
+}
+
+const char *as_last_error(void) {
+    return lastError.c_str();
+}
+
+as_catalog *as_catalog_open(const char *filename, const char *language) {
+    if (!filename) {
+        lastError = "filename is NULL";
+        return nullptr;
+    }
+    try {
+        auto *catalog = new as_catalog;
+        try {
+            catalog->parser = std::make_unique<AppStreamParser>(filename, language ? language : "");
+        } catch (...) {
+            delete catalog;
+            throw;
+        }
+        lastError.clear();
+        return catalog;
+    } catch (const std::exception &e) {
+        lastError = e.what();
+        return nullptr;
+    }
+}
+
+void as_catalog_close(as_catalog *catalog) {
+    delete catalog;
+}
+
+size_t as_catalog_count(const as_catalog *catalog) {
+    return catalog ? catalog->parser->getTotalComponentCount() : 0;
+}
+
+const as_component *as_catalog_component(const as_catalog *catalog, const size_t ordinal) {
+    if (!catalog || ordinal >= catalog->parser->getTotalComponentCount()) {
+        lastError = "ordinal out of range";
+        return nullptr;
+    }
+    return wrap(catalog->parser->getComponentAt(ordinal).get());
+}
+
+const as_component *as_catalog_find(const as_catalog *catalog, const char *id, const size_t length) {
+    if (!catalog || !id) {
+        lastError = "catalog or id is NULL";
+        return nullptr;
+    }
+    const auto ordinal = catalog->parser->findOrdinal({id, length});
+    if (!ordinal) {
+        lastError = "no component with id " + std::string(id, length);
+        return nullptr;
+    }
+    return wrap(catalog->parser->getComponentAt(*ordinal).get());
+}
+
+size_t as_catalog_ordinal(const as_catalog *catalog, const as_component *component) {
+    if (!catalog || !component) {
+        return SIZE_MAX;
+    }
+    return catalog->parser->findOrdinal(unwrap(component)->id).value_or(SIZE_MAX);
+}
+
+size_t as_catalog_search(const as_catalog *catalog, const as_facet facet, const char *term, const size_t length,
+                         const uint32_t **ordinals) {
+    if (!catalog || !term) {
+        return 0;
+    }
+    const auto range = catalog->parser->findOrdinals(::facet(facet), {term, length});
+    if (ordinals) {
+        *ordinals = range.begin();
+    }
+    return range.size();
+}
+
+size_t as_catalog_facet_count(const as_catalog *catalog, const as_facet facet) {
+    return catalog ? catalog->parser->getFacetCounts(::facet(facet)).size() : 0;
+}
+
+as_string as_catalog_facet_term(const as_catalog *catalog, const as_facet facet, const size_t index,
+                                uint32_t *count) {
+    if (!catalog) {
+        return {};
+    }
+    const auto &counts = catalog->parser->getFacetCounts(::facet(facet));
+    if (index >= counts.size()) {
+        return {};
+    }
+    if (count) {
+        *count = counts[index].count;
+    }
+    const auto term = catalog->parser->getTerm(counts[index].term);
+    return {term.data(), term.size()};
+}
+
+as_string as_component_field(const as_component *component, const as_field field) {
+    if (!component) {
+        return {};
+    }
+    const auto &c = *unwrap(component);
+    switch (field) {
+        case AS_FIELD_ID: return view(c.id);
+        case AS_FIELD_NAME: return view(c.name);
+        case AS_FIELD_SUMMARY: return view(c.summary);
+        case AS_FIELD_DESCRIPTION: return view(c.description);
+        case AS_FIELD_PROJECT_LICENSE: return view(c.projectLicense);
+        case AS_FIELD_PKGNAME: return view(c.pkgname);
+        case AS_FIELD_SOURCE_PKGNAME: return view(c.source_pkgname);
+        case AS_FIELD_PROJECT_GROUP: return view(c.project_group);
+        case AS_FIELD_DEVELOPER_ID: return view(c.developer.id);
+        case AS_FIELD_DEVELOPER_NAME: return view(c.developer.name);
+        case AS_FIELD_URL_HOMEPAGE: return view(c.url.homepage);
+        case AS_FIELD_URL_BUGTRACKER: return view(c.url.bugtracker);
+        case AS_FIELD_URL_DONATION: return view(c.url.donation);
+        case AS_FIELD_URL_HELP: return view(c.url.help);
+        case AS_FIELD_LAUNCHABLE_DESKTOP_ID: return view(c.launchable.desktop_id);
+        case AS_FIELD_BUNDLE_ID: return view(c.bundle.id);
+        case AS_FIELD_ARCHITECTURE: return view(c.architecture);
+        case AS_FIELD_MEDIA_BASEURL: return view(c.media_baseurl);
+        case AS_FIELD_CONTENT_RATING: return view(c.content_rating);
+        case AS_FIELD_AGREEMENT: return view(c.agreement);
+        default: return {};
+    }
+}
+
+size_t as_component_list_count(const as_component *component, const as_list list) {
+    const auto *values = component ? ::list(*unwrap(component), list) : nullptr;
+    return values ? values->size() : 0;
+}
+
+as_string as_component_list_item(const as_component *component, const as_list list, const size_t index) {
+    const auto *values = component ? ::list(*unwrap(component), list) : nullptr;
+    if (!values || index >= values->size()) {
+        return {};
+    }
+    return view((*values)[index]);
+}
+
+size_t as_component_release_count(const as_component *component) {
+    return component ? unwrap(component)->releases.size() : 0;
+}
+
+as_string as_component_release_field(const as_component *component, const size_t index,
+                                     const as_release_field field) {
+    if (!component || index >= unwrap(component)->releases.size()) {
+        return {};
+    }
+    const auto release = ReleaseStore::releases(*unwrap(component))[index];
+    switch (field) {
+        case AS_RELEASE_VERSION: return view(release.version());
+        case AS_RELEASE_DATE: return view(release.date());
+        case AS_RELEASE_TIMESTAMP: return view(release.timestamp());
+        case AS_RELEASE_DATE_EOL: return view(release.dateEol());
+        case AS_RELEASE_DESCRIPTION: return view(release.description());
+        case AS_RELEASE_URL: return view(release.url());
+        default: return {};
+    }
+}
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APPSTREAM_CATALOG_H
+#define APPSTREAM_CATALOG_H
+
+/*
+ * Stable C interface to the AppStream catalog, intended for FFI bindings.
+ *
+ * Strings are returned as pointer + length pairs into memory owned by the
+ * catalog. They are not NUL-terminated and stay valid until the catalog is
+ * closed; no call allocates per field. Component handles are likewise owned
+ * by the catalog.
+ *
+ * Functions returning a pointer return NULL on failure; as_last_error()
+ * then describes the error for the calling thread.
+ */
+
+#include "AppStreamExport.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AS_ABI_VERSION 1
+
+typedef struct as_catalog as_catalog;
+typedef struct as_component as_component;
+
+typedef struct {
+    const char *data;
+    size_t length;
+} as_string;
+
+typedef enum {
+    AS_FIELD_ID = 0,
+    AS_FIELD_NAME,
+    AS_FIELD_SUMMARY,
+    AS_FIELD_DESCRIPTION,
+    AS_FIELD_PROJECT_LICENSE,
+    AS_FIELD_PKGNAME,
+    AS_FIELD_SOURCE_PKGNAME,
+    AS_FIELD_PROJECT_GROUP,
+    AS_FIELD_DEVELOPER_ID,
+    AS_FIELD_DEVELOPER_NAME,
+    AS_FIELD_URL_HOMEPAGE,
+    AS_FIELD_URL_BUGTRACKER,
+    AS_FIELD_URL_DONATION,
+    AS_FIELD_URL_HELP,
+    AS_FIELD_LAUNCHABLE_DESKTOP_ID,
+    AS_FIELD_BUNDLE_ID,
+    AS_FIELD_ARCHITECTURE,
+    AS_FIELD_MEDIA_BASEURL,
+    AS_FIELD_CONTENT_RATING,
+    AS_FIELD_AGREEMENT
+} as_field;
+
+typedef enum {
+    AS_LIST_CATEGORIES = 0,
+    AS_LIST_KEYWORDS,
+    AS_LIST_SUGGESTS,
+    AS_LIST_LANGUAGES
+} as_list;
+
+typedef enum {
+    AS_RELEASE_VERSION = 0,
+    AS_RELEASE_DATE,
+    AS_RELEASE_TIMESTAMP,
+    AS_RELEASE_DATE_EOL,
+    AS_RELEASE_DESCRIPTION,
+    AS_RELEASE_URL
+} as_release_field;
+
+typedef enum {
+    AS_FACET_CATEGORY = 0,
+    AS_FACET_KEYWORD
+} as_facet;
+
+/* Value of AS_ABI_VERSION the library was built with. */
+AS_EXPORT int as_abi_version(void);
+
+/* Error message of the last failed call on this thread, or an empty string. */
+AS_EXPORT const char *as_last_error(void);
+
+/* Parses filename; language may be NULL or "" to accept all languages. */
+AS_EXPORT as_catalog *as_catalog_open(const char *filename, const char *language);
+
+AS_EXPORT void as_catalog_close(as_catalog *catalog);
+
+AS_EXPORT size_t as_catalog_count(const as_catalog *catalog);
+
+/* Component at ordinal, in ID order; NULL when out of range. */
+AS_EXPORT const as_component *as_catalog_component(const as_catalog *catalog, size_t ordinal);
+
+AS_EXPORT const as_component *as_catalog_find(const as_catalog *catalog, const char *id, size_t length);
+
+/* Ordinal of component within catalog. */
+AS_EXPORT size_t as_catalog_ordinal(const as_catalog *catalog, const as_component *component);
+
+/* Ordinals carrying a category or keyword, ascending; *ordinals points into the catalog. */
+AS_EXPORT size_t as_catalog_search(const as_catalog *catalog, as_facet facet, const char *term, size_t length,
+                                   const uint32_t **ordinals);
+
+/* Number of distinct terms of a facet; entries are ordered by count, highest first. */
+AS_EXPORT size_t as_catalog_facet_count(const as_catalog *catalog, as_facet facet);
+
+AS_EXPORT as_string as_catalog_facet_term(const as_catalog *catalog, as_facet facet, size_t index, uint32_t *count);
+
+AS_EXPORT as_string as_component_field(const as_component *component, as_field field);
+
+AS_EXPORT size_t as_component_list_count(const as_component *component, as_list list);
+
+AS_EXPORT as_string as_component_list_item(const as_component *component, as_list list, size_t index);
+
+AS_EXPORT size_t as_component_release_count(const as_component *component);
+
+AS_EXPORT as_string as_component_release_field(const as_component *component, size_t index,
+                                               as_release_field field);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APPSTREAM_CATALOG_H */
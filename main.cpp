@@ -15,13 +15,30 @@
  */
 
 #include "AppStreamParser.h"
+#include "ArtifactVerifier.h"
+#include "CatalogHandle.h"
+#include "DiskCatalog.h"
+#include "QueryRunner.h"
+#include "ThreadPool.h"
+#include "UpdateChecker.h"
 #include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <numeric>
+#include <optional>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <vector>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -57,6 +74,24 @@ void getMemoryUsage(double &vm_usage, double &resident_set) {
     }
 }
 
+/**
+ * @brief Retrieves the peak resident set size of the process.
+ *
+ * Reads the `VmHWM` entry from `/proc/self/status`.
+ *
+ * @return The peak resident set size in kilobytes, or 0 if unavailable.
+ */
+long getPeakResidentSet() {
+    std::ifstream file("/proc/self/status");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    return 0;
+}
+
 /**
  * @brief Gets the size of a file.
  *
@@ -70,14 +105,977 @@ long getFileSize(const std::string &filename) {
     return stat(filename.c_str(), &stat_buf) == 0 ? stat_buf.st_size : -1;
 }
 
+/**
+ * @brief Builds an on-disk catalog, then reports peak memory and query latency against it.
+ *
+ * Run without other options so that the peak resident set reflects the build alone.
+ *
+ * @param filename The catalog to convert.
+ * @param language The language passed to the parser.
+ * @param options The parser options; the filter applies.
+ * @param directory Where the data file and indexes are written.
+ */
+void runDiskCatalog(const std::string &filename, const std::string &language, const AppStreamParser::Options &options,
+                    const std::string &directory) {
+    const auto buildStart = std::chrono::steady_clock::now();
+    const auto stats = DiskCatalog::build(filename, language, directory, options);
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    spdlog::info("Disk catalog built in {:.1f} ms: {} components ({} duplicates dropped), {} KB data, {} KB indexes, "
+                 "{} sorted runs, peak RSS {} KB", buildElapsed.count(), stats.components, stats.duplicates,
+                 stats.dataBytes / 1024, stats.indexBytes / 1024, stats.runs, getPeakResidentSet());
+
+    const DiskCatalog catalog(directory);
+    for (const auto *category: {"utility", "Utility", "Game"}) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto components = catalog.searchByCategory(category);
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        spdlog::info("Category '{}': {} components in {:.1f} us", category, components.size(), elapsed.count());
+    }
+    if (catalog.size()) {
+        constexpr size_t kLookups = 1000;
+        size_t found = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kLookups; ++i) {
+            found += catalog.findComponent(catalog.idAt(i * 7919 % catalog.size())) != nullptr;
+        }
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        spdlog::info("ID lookups: {} of {} found, {:.2f} us per lookup and decode", found, kLookups,
+                     elapsed.count() / kLookups);
+        const auto first = catalog.getComponentAt(0);
+        spdlog::info("- {}: {} ({} releases)", first->id, first->name, first->releases.size());
+    }
+    spdlog::info("Peak RSS {} KB", getPeakResidentSet());
+}
+
+/**
+ * @brief Queries a CatalogHandle from reader threads while it is reloaded.
+ *
+ * Reports the number of queries served and the worst query latency observed,
+ * which should stay at plain query cost while new generations are parsed and
+ * published in the background.
+ *
+ * @param filename The catalog to load and reload.
+ * @param language The language passed to the parser.
+ * @param options The parser options.
+ * @param reloads The number of reloads to perform.
+ */
+void runReloadBenchmark(const std::string &filename, const std::string &language,
+                        const AppStreamParser::Options &options, const int reloads) {
+    CatalogHandle handle(filename, language, options);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> queries{0};
+    std::atomic<long> worstMicros{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                const auto start = std::chrono::steady_clock::now();
+                const auto snapshot = handle.acquire();
+                const auto result = snapshot->searchByKeyword("editor");
+                const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                long worst = worstMicros.load();
+                while (micros > worst && !worstMicros.compare_exchange_weak(worst, micros)) {
+                }
+                queries.fetch_add(1);
+            }
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reloads; ++i) {
+        const auto target = handle.generation() + 1;
+        handle.reload();
+        while (handle.generation() < target) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    done.store(true);
+    for (auto &reader: readers) {
+        reader.join();
+    }
+
+    spdlog::info("Reloaded {} times in {:.2f} s: {} queries served, worst query {} us, generation {}, {} retired",
+                 reloads, elapsed, queries.load(), worstMicros.load(), handle.generation(),
+                 handle.retiredGenerations());
+}
+
+/**
+ * @brief Runs ranked searches and reports latency and a relevance proxy.
+ *
+ * A hit counts as relevant when every query word occurs in its name or
+ * keywords. Precision of the ranked top 10 is compared with the first 10
+ * components of an exact keyword lookup, which come back in ID order.
+ *
+ * @param parser The parsed catalog.
+ * @param queries The queries to run.
+ */
+void runSearchBenchmark(const AppStreamParser &parser, const std::vector<std::string> &queries) {
+    const auto buildStart = std::chrono::steady_clock::now();
+    const auto &index = parser.getSearchIndex();
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    spdlog::info("Search index: {} terms, {} postings, {} KB, built in {:.1f} ms", index.termCount(),
+                 index.postingCount(), index.memoryUsage() / 1024, buildElapsed.count());
+
+    constexpr size_t kTop = 10;
+    constexpr int kRepeats = 200;
+    for (const auto &query: queries) {
+        std::vector<std::string> words;
+        std::string scratch;
+        SearchIndex::tokenize(query, false, scratch, [&](const std::string_view word) { words.emplace_back(word); });
+        const auto relevant = [&](const Component &component) {
+            return std::all_of(words.begin(), words.end(), [&](const std::string &word) {
+                std::string text = component.name;
+                for (const auto &keyword: component.keywords) {
+                    text += ' ' + keyword;
+                }
+                std::transform(text.begin(), text.end(), text.begin(), [](const unsigned char c) {
+                    return std::tolower(c);
+                });
+                return text.find(word) != std::string::npos;
+            });
+        };
+
+        std::vector<SearchIndex::Hit> hits;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRepeats; ++i) {
+            hits = parser.search(query, kTop);
+        }
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+        size_t ranked = 0;
+        for (const auto &hit: hits) {
+            ranked += relevant(*parser.getComponentAt(hit.ordinal));
+        }
+        size_t baseline = 0;
+        if (!words.empty()) {
+            const auto exact = parser.searchByKeyword(words.front());
+            for (size_t i = 0; i < std::min(kTop, exact.size()); ++i) {
+                baseline += relevant(*exact[i]);
+            }
+        }
+        spdlog::info("Search '{}': {:.1f} us/query, precision@{} {:.1f} (keyword lookup {:.1f})", query,
+                     elapsed.count() / kRepeats, kTop, static_cast<double>(ranked) / kTop,
+                     static_cast<double>(baseline) / kTop);
+        for (size_t i = 0; i < std::min<size_t>(3, hits.size()); ++i) {
+            const auto component = parser.getComponentAt(hits[i].ordinal);
+            spdlog::info("- {:.3f} {} ({})", hits[i].score, component->id, component->name);
+        }
+    }
+}
+
+/**
+ * @brief Replays typing each text one keystroke at a time against the autocomplete index.
+ *
+ * Reports the index size, the size of its serialized image, the mean latency per
+ * keystroke and the completions offered for each full text.
+ *
+ * @param parser The parsed catalog.
+ * @param texts The texts to type.
+ */
+void runCompletionBenchmark(const AppStreamParser &parser, const std::vector<std::string> &texts) {
+    const auto buildStart = std::chrono::steady_clock::now();
+    const auto &index = parser.getCompletionIndex();
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    std::string image;
+    index.serialize(image);
+    const auto reloaded = CompletionIndex::deserialize(reinterpret_cast<const uint8_t *>(image.data()), image.size());
+    spdlog::info("Completion index: {} nodes, {} KB, {} KB serialized, built in {:.1f} ms", index.nodeCount(),
+                 index.memoryUsage() / 1024, image.size() / 1024, buildElapsed.count());
+
+    constexpr int kRepeats = 1000;
+    for (const auto &text: texts) {
+        const auto start = std::chrono::steady_clock::now();
+        size_t found = 0;
+        for (int i = 0; i < kRepeats; ++i) {
+            for (size_t length = 1; length <= text.size(); ++length) {
+                found += reloaded.complete(std::string_view(text).substr(0, length), 8).size();
+            }
+        }
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        spdlog::info("Complete '{}': {:.2f} us/keystroke ({} completions)", text,
+                     text.empty() ? 0.0 : elapsed.count() / kRepeats / static_cast<double>(text.size()),
+                     found / kRepeats);
+        for (const auto &completion: parser.complete(text)) {
+            static constexpr const char *kKinds[] = {"name", "id", "keyword"};
+            spdlog::info("- {} [{}] ({})", completion.text, kKinds[static_cast<int>(completion.kind)],
+                         completion.weight);
+        }
+    }
+}
+
+/**
+ * @brief Prints the related components of each ID with the time per neighborhood query.
+ *
+ * @param parser The parsed catalog.
+ * @param ids The component IDs to look up.
+ */
+void runRelatedBenchmark(const AppStreamParser &parser, const std::vector<std::string> &ids) {
+    const auto buildStart = std::chrono::steady_clock::now();
+    const auto &relations = parser.getRelations();
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    spdlog::info("Relation graph: {} suggests edges, {} KB, built in {:.1f} ms", relations.edgeCount(),
+                 relations.memoryUsage() / 1024, buildElapsed.count());
+
+    for (const auto &id: ids) {
+        const auto ordinal = parser.findOrdinal(id);
+        if (!ordinal) {
+            spdlog::warn("Related '{}': no such component", id);
+            continue;
+        }
+        constexpr int kRepeats = 1000;
+        std::vector<RelationGraph::Neighbor> neighbors;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRepeats; ++i) {
+            neighbors = relations.neighbors(static_cast<uint32_t>(*ordinal), RelationGraph::ALL, 10);
+        }
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        spdlog::info("Related '{}': {} from the same developer, {:.2f} us/query", id,
+                     relations.sameDeveloper(static_cast<uint32_t>(*ordinal)).size(), elapsed.count() / kRepeats);
+        for (const auto &[neighbor, kinds]: neighbors) {
+            std::string labels;
+            for (const auto &[bit, label]: {std::pair{RelationGraph::SUGGESTS, "suggests"},
+                                            {RelationGraph::SUGGESTED_BY, "suggested-by"},
+                                            {RelationGraph::SAME_DEVELOPER, "developer"},
+                                            {RelationGraph::SAME_PROJECT_GROUP, "project-group"}}) {
+                if (kinds & bit) {
+                    labels += labels.empty() ? label : std::string(",") + label;
+                }
+            }
+            spdlog::info("- {} [{}]", parser.getComponentAt(neighbor)->id, labels);
+        }
+    }
+}
+
+/**
+ * @brief Prints similar components for each ID, then measures recall@10 of the LSH index against exact Jaccard.
+ *
+ * @param parser The parsed catalog.
+ * @param ids The component IDs to look up.
+ */
+void runSimilarityBenchmark(const AppStreamParser &parser, const std::vector<std::string> &ids) {
+    constexpr size_t kTop = 10;
+    const auto buildStart = std::chrono::steady_clock::now();
+    const auto &similarity = parser.getSimilarity();
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    spdlog::info("Similarity index: {} components, built in {:.1f} ms", similarity.size(), buildElapsed.count());
+
+    for (const auto &id: ids) {
+        const auto ordinal = parser.findOrdinal(id);
+        if (!ordinal) {
+            spdlog::warn("Similar '{}': no such component", id);
+            continue;
+        }
+        spdlog::info("Similar to '{}':", id);
+        for (const auto &[other, score]: parser.findSimilar(static_cast<uint32_t>(*ordinal), kTop)) {
+            spdlog::info("- {} ({:.2f})", parser.getComponentAt(other)->id, score);
+        }
+    }
+
+    // Exact Jaccard over the same term sets, categories and keywords kept apart
+    const auto count = parser.getTotalComponentCount();
+    std::vector<std::vector<std::string> > sets(count);
+    for (size_t ordinal = 0; ordinal < count; ++ordinal) {
+        const auto component = parser.getComponentAt(ordinal);
+        for (const auto &category: component->categories) {
+            sets[ordinal].push_back("c" + category);
+        }
+        for (const auto &keyword: component->keywords) {
+            sets[ordinal].push_back("k" + keyword);
+        }
+        std::sort(sets[ordinal].begin(), sets[ordinal].end());
+        sets[ordinal].erase(std::unique(sets[ordinal].begin(), sets[ordinal].end()), sets[ordinal].end());
+    }
+    const auto jaccard = [&](const size_t a, const size_t b) {
+        std::vector<std::string> common;
+        std::set_intersection(sets[a].begin(), sets[a].end(), sets[b].begin(), sets[b].end(),
+                              std::back_inserter(common));
+        const auto united = sets[a].size() + sets[b].size() - common.size();
+        return united ? static_cast<double>(common.size()) / static_cast<double>(united) : 0.0;
+    };
+
+    const size_t samples = std::min<size_t>(count, 200);
+    size_t found = 0;
+    size_t wanted = 0;
+    double approximateMicros = 0;
+    double exactMicros = 0;
+    for (size_t sample = 0; sample < samples; ++sample) {
+        const auto ordinal = static_cast<uint32_t>(sample * count / samples);
+        auto start = std::chrono::steady_clock::now();
+        const auto approximate = parser.findSimilar(ordinal, kTop);
+        approximateMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).
+                count();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<double> scores;
+        for (size_t other = 0; other < count; ++other) {
+            if (other != ordinal) {
+                scores.push_back(jaccard(ordinal, other));
+            }
+        }
+        std::sort(scores.begin(), scores.end(), std::greater<>());
+        exactMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        // Ties at the cut-off make any of them a correct answer
+        const auto cutoff = scores.size() >= kTop ? scores[kTop - 1] : 0.0;
+        const auto relevant = static_cast<size_t>(std::count_if(scores.begin(), scores.end(), [&](const double s) {
+            return s > 0 && s >= cutoff;
+        }));
+        wanted += std::min(kTop, relevant);
+        for (const auto &similar: approximate) {
+            const auto score = jaccard(ordinal, similar.ordinal);
+            found += score > 0 && score >= cutoff;
+        }
+    }
+    spdlog::info("Similarity: recall@{} {:.1f}% over {} components, LSH {:.1f} us/query, exact scan {:.1f} us/query",
+                 kTop, wanted ? 100.0 * static_cast<double>(found) / static_cast<double>(wanted) : 100.0, samples,
+                 samples ? approximateMicros / static_cast<double>(samples) : 0.0,
+                 samples ? exactMicros / static_cast<double>(samples) : 0.0);
+}
+
+/**
+ * @brief Writes query results to stdout as JSON.
+ *
+ * @param parser The parsed catalog.
+ * @param ordinals Ordinals of the components to print.
+ */
+void printComponents(const AppStreamParser &parser, const std::vector<uint32_t> &ordinals) {
+    // Log lines go through stdio; keep them ahead of the exporter's direct writes
+    std::fflush(stdout);
+    CatalogExporter exporter(STDOUT_FILENO, CatalogExporter::Format::JSON);
+    parser.exportComponents(exporter, ordinals);
+    exporter.finish();
+}
+
+/**
+ * @brief Exports the whole catalog and reports the throughput next to the parse rate.
+ *
+ * @param parser The parsed catalog.
+ * @param path The output file.
+ * @param format The output format.
+ * @param parseMBps Parse throughput of the input, for comparison.
+ */
+void runExport(const AppStreamParser &parser, const std::string &path, const CatalogExporter::Format format,
+               const double parseMBps) {
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        spdlog::error("Cannot open '{}' for writing", path);
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    try {
+        CatalogExporter exporter(fd, format);
+        parser.exportCatalog(exporter);
+        exporter.finish();
+        bytes = exporter.bytesWritten();
+    } catch (const std::exception &e) {
+        spdlog::error("Export to '{}' failed: {}", path, e.what());
+    }
+    close(fd);
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Exported {} as {}: {:.2f} MiB in {:.1f} ms, {:.0f} MB/s (parse {:.0f} MB/s)", path,
+                 format == CatalogExporter::Format::JSON ? "JSON" : "binary",
+                 static_cast<double>(bytes) / (1024.0 * 1024.0), seconds * 1000.0,
+                 seconds > 0 ? static_cast<double>(bytes) / 1e6 / seconds : 0.0, parseMBps);
+}
+
+/**
+ * @brief Verifies release artifacts against a local mirror and reports hashing throughput.
+ *
+ * @param parser The parsed catalog.
+ * @param options Mirror root and worker count.
+ */
+void runMirrorVerification(const AppStreamParser &parser, const ArtifactVerifier::Options &options) {
+    const ArtifactVerifier verifier(options);
+    const auto report = verifier.verify(parser);
+    spdlog::info("Verified {} of {} artifacts under '{}': {:.1f} MiB hashed in {:.1f} ms, {:.0f} MB/s, {} steals",
+                 report.verified, report.artifacts, options.mirrorRoot,
+                 static_cast<double>(report.bytesHashed) / (1024.0 * 1024.0), report.seconds * 1000.0,
+                 report.seconds > 0 ? static_cast<double>(report.bytesHashed) / 1e6 / report.seconds : 0.0,
+                 report.steals);
+    constexpr size_t kShown = 20;
+    for (size_t i = 0; i < std::min(kShown, report.failures.size()); ++i) {
+        const auto &failure = report.failures[i];
+        spdlog::warn("- {} {}: {} {}", failure.componentId, failure.path.empty() ? failure.location : failure.path,
+                     ArtifactVerifier::statusToString(failure.status), failure.detail);
+    }
+    if (report.failures.size() > kShown) {
+        spdlog::warn("- ... and {} more", report.failures.size() - kShown);
+    }
+}
+
+/**
+ * @brief Checks a list of installed components for updates and compares with a per-component release scan.
+ *
+ * @param parser The parsed catalog.
+ * @param path File with one "<id> <installed version>" pair per line.
+ * @param threads Worker threads; 0 uses the number of hardware threads.
+ */
+void runUpdateCheck(const AppStreamParser &parser, const std::string &path, const size_t threads) {
+    std::ifstream file(path);
+    if (!file) {
+        spdlog::error("Cannot open installed list '{}'", path);
+        return;
+    }
+    std::vector<std::string> lines;
+    std::vector<UpdateChecker::Installed> installed;
+    for (std::string line; std::getline(file, line);) {
+        lines.push_back(std::move(line));
+    }
+    for (const std::string_view line: lines) {
+        const auto space = line.find(' ');
+        if (space != std::string_view::npos) {
+            installed.push_back({line.substr(0, space), line.substr(space + 1)});
+        }
+    }
+
+    const auto buildStart = std::chrono::steady_clock::now();
+    const UpdateChecker checker(parser, threads);
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+
+    for (const bool includeDevelopment: {false, true}) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto updates = checker.check(installed, includeDevelopment);
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+        // Look each component up and compare every release version
+        const auto scanStart = std::chrono::steady_clock::now();
+        size_t scanned = 0;
+        for (const auto &[id, version]: installed) {
+            const auto ordinal = parser.findOrdinal(id);
+            if (!ordinal) {
+                continue;
+            }
+            const auto component = parser.getComponentAt(*ordinal);
+            for (const auto &release: AppStreamParser::getReleases(*component)) {
+                if ((includeDevelopment || (release.type() != Component::ReleaseType::DEVELOPMENT &&
+                                            release.type() != Component::ReleaseType::SNAPSHOT)) &&
+                    UpdateChecker::compareVersions(release.version(), version) > 0) {
+                    ++scanned;
+                    break;
+                }
+            }
+        }
+        const auto scanElapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - scanStart);
+
+        size_t urgent = 0;
+        for (const auto &update: updates) {
+            urgent += update.release.urgency() >= Component::ReleaseUrgency::HIGH;
+        }
+        spdlog::info("Updates{}: {} of {} installed ({} high or critical) in {:.2f} ms, release scan {:.2f} ms{}",
+                     includeDevelopment ? " including development" : "", updates.size(), installed.size(), urgent,
+                     elapsed.count(), scanElapsed.count(), updates.size() == scanned ? "" : " (MISMATCH)");
+        for (size_t i = 0; i < std::min<size_t>(3, updates.size()); ++i) {
+            const auto &update = updates[i];
+            spdlog::info("- {} {} -> {} ({})", installed[update.index].id, installed[update.index].version,
+                         update.release.version(), Component::releaseUrgencyToString(update.release.urgency()));
+        }
+    }
+    spdlog::info("Update checker built in {:.1f} ms", buildElapsed.count());
+}
+
+/**
+ * @brief Parses a catalog in time-sliced steps, as a single-threaded event loop would between frames.
+ *
+ * @param filename The catalog file.
+ * @param language The catalog language.
+ * @param options Parser options.
+ * @param frameMillis Parse time allowed per frame.
+ * @return The parsed catalog.
+ */
+std::unique_ptr<AppStreamParser> parseInFrames(const std::string &filename, const std::string &language,
+                                               const AppStreamParser::Options &options, const double frameMillis) {
+    auto parser = std::make_unique<AppStreamParser>(filename, language, options, AppStreamParser::Deferred());
+    const AppStreamParser::ParseBudget budget{
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(frameMillis))
+    };
+    std::vector<double> steps;
+    AppStreamParser::ParseProgress progress;
+    int reported = 0;
+    while (!progress.done) {
+        const auto start = std::chrono::steady_clock::now();
+        progress = parser->parseStep(budget);
+        steps.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (const auto percent = static_cast<int>(progress.fraction() * 100); percent >= reported + 25) {
+            reported = percent / 25 * 25;
+            spdlog::info("Parse progress: {}% ({} of {} KB, {} components)", percent, progress.bytesParsed / 1024,
+                         progress.totalBytes / 1024, progress.components);
+        }
+    }
+    const auto total = std::accumulate(steps.begin(), steps.end(), 0.0);
+    std::sort(steps.begin(), steps.end());
+    spdlog::info("Parsed in {} frames of {:.1f} ms: {:.1f} ms of parsing, step p50 {:.2f} ms, p99 {:.2f} ms, "
+                 "max {:.2f} ms", steps.size(), frameMillis, total, steps[steps.size() / 2],
+                 steps[std::min(steps.size() - 1, steps.size() * 99 / 100)], steps.back());
+    return parser;
+}
+
+/**
+ * @brief Answers newline-delimited queries from a file or stdin and reports throughput.
+ *
+ * Results go to stdout, one JSON line per query in input order; QPS and
+ * latency percentiles are logged.
+ *
+ * @param parser The parsed catalog.
+ * @param path The query file, or "-" for stdin.
+ * @param threads Worker threads; 0 uses the number of hardware threads.
+ */
+void runBatchQueries(const AppStreamParser &parser, const std::string &path, const size_t threads) {
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            spdlog::error("Cannot open query file '{}'", path);
+            return;
+        }
+    }
+    // Build the search index up front so it does not skew the latencies
+    const auto buildStart = std::chrono::steady_clock::now();
+    parser.getSearchIndex();
+    const auto buildElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    spdlog::info("Search index built in {:.1f} ms", buildElapsed.count());
+
+    const QueryRunner runner(parser, threads);
+    const auto stats = runner.run(path == "-" ? std::cin : file, std::cout);
+    spdlog::info("Answered {} queries ({} errors) in {:.1f} ms: {:.0f} QPS, latency p50 {:.1f} us, p90 {:.1f} us, "
+                 "p99 {:.1f} us, max {:.1f} us", stats.queries, stats.errors, stats.seconds * 1000.0,
+                 stats.seconds > 0 ? static_cast<double>(stats.queries) / stats.seconds : 0.0, stats.p50, stats.p90,
+                 stats.p99, stats.max);
+}
+
+/**
+ * @brief Replays a home page worth of queries and reports what the query result cache saves.
+ *
+ * Each round asks for the eight largest categories, the four most common
+ * keywords and both sorted lists; the first round fills the cache.
+ *
+ * @param parser The parsed catalog.
+ * @param rounds Number of times the query set is replayed.
+ */
+void runQueryCacheBenchmark(const AppStreamParser &parser, const int rounds) {
+    const auto &categories = parser.getFacetCounts(AppStreamParser::Facet::CATEGORY);
+    const auto &keywords = parser.getFacetCounts(AppStreamParser::Facet::KEYWORD);
+    std::vector<double> roundMicros;
+    size_t results = 0;
+    for (int round = 0; round < rounds; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < std::min<size_t>(8, categories.size()); ++i) {
+            results += parser.findByCategory(parser.getTerm(categories[i].term))->size();
+        }
+        for (size_t i = 0; i < std::min<size_t>(4, keywords.size()); ++i) {
+            results += parser.findByKeyword(parser.getTerm(keywords[i].term))->size();
+        }
+        results += parser.findSorted(AppStreamParser::SortOption::BY_NAME)->size();
+        results += parser.findSorted(AppStreamParser::SortOption::BY_ID)->size();
+        roundMicros.push_back(
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    if (roundMicros.empty()) {
+        return;
+    }
+    double warm = 0;
+    for (size_t i = 1; i < roundMicros.size(); ++i) {
+        warm += roundMicros[i];
+    }
+    const auto stats = parser.getQueryCacheStats();
+    spdlog::info("Query cache: {} rounds, first {:.1f} us, then {:.1f} us per round ({} results)", rounds,
+                 roundMicros[0], roundMicros.size() > 1 ? warm / static_cast<double>(roundMicros.size() - 1) : 0.0,
+                 results);
+    spdlog::info("Query cache: {:.1f}% hits ({} hits, {} misses, {} evictions), {} entries in {} of {} KB, "
+                 "{:.2f} ms saved", stats.hitRate() * 100.0, stats.hits, stats.misses, stats.evictions,
+                 stats.entries, stats.bytes / 1024, stats.budgetBytes / 1024, stats.savedSeconds * 1000.0);
+}
+
+/**
+ * @brief Filters the catalog by an OARS limit and compares the packed pass with a per-attribute scan.
+ *
+ * @param parser The parsed catalog.
+ * @param limit Highest allowed intensity per attribute.
+ */
+void runContentRatingFilter(const AppStreamParser &parser, const ContentRating &limit) {
+    constexpr int kRepeats = 100;
+    const auto &ratings = parser.getContentRatings();
+    size_t rated = 0;
+    for (const auto bits: ratings) {
+        rated += ContentRating::fromBits(bits).rated();
+    }
+
+    std::vector<uint32_t> packed;
+    const auto packedStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeats; ++i) {
+        packed = parser.filterByContentRating(limit);
+    }
+    const auto packedElapsed = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - packedStart);
+
+    // The same check one attribute at a time
+    std::vector<uint32_t> scalar;
+    const auto scalarStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeats; ++i) {
+        scalar.clear();
+        for (size_t ordinal = 0; ordinal < ratings.size(); ++ordinal) {
+            const auto rating = ContentRating::fromBits(ratings[ordinal]);
+            bool allowed = rating.rated();
+            for (size_t attribute = 0; allowed && attribute < ContentRating::kAttributeCount; ++attribute) {
+                allowed = rating.get(attribute) <= limit.get(attribute);
+            }
+            if (allowed) {
+                scalar.push_back(static_cast<uint32_t>(ordinal));
+            }
+        }
+    }
+    const auto scalarElapsed = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - scalarStart);
+
+    spdlog::info("Content rating filter: {} of {} rated components pass ({} total), packed {:.2f} us, "
+                 "per-attribute {:.2f} us per catalog pass{}", packed.size(), rated, ratings.size(),
+                 packedElapsed.count() / kRepeats, scalarElapsed.count() / kRepeats,
+                 packed == scalar ? "" : " (MISMATCH)");
+    for (size_t i = 0; i < std::min<size_t>(5, packed.size()); ++i) {
+        spdlog::info("- {}", parser.getComponentAt(packed[i])->id);
+    }
+}
+
+/**
+ * @brief Times substring search over names and summaries: per-component find, vector scan, and threaded scan.
+ *
+ * @param parser The parsed catalog.
+ * @param queries Substrings to look for.
+ */
+void runSubstringBenchmark(const AppStreamParser &parser, const std::vector<std::string> &queries) {
+    constexpr int kRepeats = 100;
+    const auto &substrings = parser.getSubstringSearch();
+    ThreadPool pool;
+    spdlog::info("Substring search: {} components, {} KB of text, {} threads", substrings.size(),
+                 substrings.bytes() / 1024, pool.size());
+    for (const auto &query: queries) {
+        const auto time = [&](const auto &run) {
+            std::vector<uint32_t> result;
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kRepeats; ++i) {
+                result = run();
+            }
+            return std::make_pair(result, std::chrono::duration<double, std::micro>(
+                                      std::chrono::steady_clock::now() - start).count() / kRepeats);
+        };
+        const auto needle = SubstringSearch::fold(query);
+        const auto [scalar, scalarMicros] = time([&] {
+            std::vector<uint32_t> ordinals;
+            for (uint32_t ordinal = 0; ordinal < substrings.size(); ++ordinal) {
+                if (substrings.text(ordinal).find(needle) != std::string_view::npos) {
+                    ordinals.push_back(ordinal);
+                }
+            }
+            return ordinals;
+        });
+        const auto [vector, vectorMicros] = time([&] { return parser.searchSubstring(query); });
+        const auto [threaded, threadedMicros] = time([&] { return parser.searchSubstring(query, &pool); });
+        spdlog::info("Substring '{}': {} components, find {:.1f} us, vector scan {:.1f} us, {} threads {:.1f} us{}",
+                     query, vector.size(), scalarMicros, vectorMicros, pool.size(), threadedMicros,
+                     vector == scalar && threaded == scalar ? "" : " (MISMATCH)");
+        for (size_t i = 0; i < std::min<size_t>(3, vector.size()); ++i) {
+            const auto component = parser.getComponentAt(vector[i]);
+            spdlog::info("- {}: {}", component->name, component->summary);
+        }
+    }
+}
+
+/**
+ * @brief Resolves aliases to components, then times a batch of every catalog alias of each kind against scanning.
+ *
+ * @param parser The parsed catalog.
+ * @param aliases "<kind>:<alias>" pairs, e.g. "desktop-id:org.gnome.Maps.desktop".
+ */
+void runAliasResolution(const AppStreamParser &parser, const std::vector<std::string> &aliases) {
+    const auto &index = parser.getAliases();
+    std::vector<AliasIndex::Kind> kinds;
+    for (const auto &entry: aliases) {
+        const auto colon = entry.find(':');
+        const auto kind = AliasIndex::stringToKind(std::string_view(entry).substr(0, colon));
+        if (!kind || colon == std::string::npos) {
+            spdlog::error("Invalid alias '{}', expected <desktop-id|pkgname|source-pkgname|bundle>:<alias>", entry);
+            continue;
+        }
+        if (std::find(kinds.begin(), kinds.end(), *kind) == kinds.end()) {
+            kinds.push_back(*kind);
+        }
+        const auto ordinals = index.find(*kind, std::string_view(entry).substr(colon + 1));
+        spdlog::info("Alias '{}': {} components", entry, ordinals.size());
+        for (const auto ordinal: ordinals) {
+            spdlog::info("- {}", parser.getComponentAt(ordinal)->id);
+        }
+    }
+
+    const auto aliasOf = [](const Component &component, const AliasIndex::Kind kind) -> std::string_view {
+        switch (kind) {
+            case AliasIndex::Kind::DESKTOP_ID: return component.launchable.desktop_id;
+            case AliasIndex::Kind::PKGNAME: return component.pkgname;
+            case AliasIndex::Kind::SOURCE_PKGNAME: return component.source_pkgname;
+            case AliasIndex::Kind::BUNDLE: return component.bundle.id;
+        }
+        return {};
+    };
+    std::vector<std::shared_ptr<Component> > components;
+    for (size_t ordinal = 0; ordinal < parser.getTotalComponentCount(); ++ordinal) {
+        components.push_back(parser.getComponentAt(ordinal));
+    }
+    for (const auto kind: kinds) {
+        std::vector<std::string_view> batch;
+        for (const auto &component: components) {
+            if (const auto alias = aliasOf(*component, kind); !alias.empty()) {
+                batch.push_back(alias);
+            }
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const auto resolved = index.resolve(kind, batch);
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+        // A scan per alias, on a sample so it finishes on large catalogs
+        const auto sample = std::min<size_t>(batch.size(), 100);
+        size_t mismatches = 0;
+        const auto scanStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < sample; ++i) {
+            const auto wanted = AliasIndex::normalize(kind, batch[i]);
+            size_t found = 0;
+            for (const auto &component: components) {
+                found += AliasIndex::normalize(kind, aliasOf(*component, kind)) == wanted;
+            }
+            mismatches += found > resolved[i].size();
+        }
+        const auto scanElapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - scanStart);
+        spdlog::info("Resolved {} {} aliases in {:.1f} us ({:.3f} us each), scanning takes {:.1f} us each{}",
+                     batch.size(), AliasIndex::kindToString(kind), elapsed.count(),
+                     batch.empty() ? 0.0 : elapsed.count() / static_cast<double>(batch.size()),
+                     sample ? scanElapsed.count() / static_cast<double>(sample) : 0.0,
+                     mismatches ? " (MISMATCH)" : "");
+    }
+}
+
+/**
+ * @brief Looks up publishers in the publisher index and compares with a scan of every component.
+ *
+ * @param parser The parsed catalog.
+ * @param publishers Developer IDs, developer names or project groups.
+ */
+void runPublisherQueries(const AppStreamParser &parser, const std::vector<std::string> &publishers) {
+    for (const auto &publisher: publishers) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto ordinals = parser.findPublisher(publisher);
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+        const auto key = AppStreamParser::publisherKey(publisher);
+        const auto scanStart = std::chrono::steady_clock::now();
+        size_t scanned = 0;
+        for (size_t ordinal = 0; ordinal < parser.getTotalComponentCount(); ++ordinal) {
+            const auto component = parser.getComponentAt(ordinal);
+            scanned += AppStreamParser::publisherKey(component->developer.id) == key ||
+                    AppStreamParser::publisherKey(component->developer.name) == key ||
+                    AppStreamParser::publisherKey(component->project_group) == key;
+        }
+        const auto scanElapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - scanStart);
+
+        spdlog::info("Publisher '{}' (key '{}'): {} components in {:.2f} us, scan {:.1f} us{}", publisher, key,
+                     ordinals.size(), elapsed.count(), scanElapsed.count(),
+                     ordinals.size() == scanned ? "" : " (MISMATCH)");
+        for (size_t i = 0; i < std::min<size_t>(5, ordinals.size()); ++i) {
+            spdlog::info("- {}", parser.getComponentAt(ordinals.begin()[i])->id);
+        }
+    }
+}
+
+/**
+ * @brief Lists the reverse-DNS segments below each prefix with their component counts.
+ *
+ * @param parser The parsed catalog.
+ * @param prefixes ID prefixes such as "org." or "org.kde.".
+ */
+void runIdBrowse(const AppStreamParser &parser, const std::vector<std::string> &prefixes) {
+    for (const auto &prefix: prefixes) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto range = parser.findIdPrefix(prefix);
+        const auto segments = parser.getIdSegments(prefix);
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        spdlog::info("ID prefix '{}': {} components in {} segments ({:.2f} us)", prefix, range.size(),
+                     segments.size(), elapsed.count());
+        for (size_t i = 0; i < std::min<size_t>(10, segments.size()); ++i) {
+            spdlog::info("- {} ({})", segments[i].prefix, segments[i].ordinals.size());
+        }
+    }
+}
+
+/**
+ * @brief Runs license filters on the compiled license bitsets and compares with re-parsing every expression.
+ *
+ * @param parser The parsed catalog.
+ * @param filters Filters as accepted by LicenseIndex::filter(), e.g. "copyleft" or "!proprietary".
+ */
+void runLicenseFilter(const AppStreamParser &parser, const std::vector<std::string> &filters) {
+    constexpr int kRepeats = 100;
+    const auto &licenses = parser.getLicenses();
+    spdlog::info("Licenses: {} distinct IDs over {} components", licenses.licenseCount(), licenses.size());
+    for (const auto &filter: filters) {
+        std::vector<uint32_t> compiled;
+        const auto compiledStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRepeats; ++i) {
+            compiled = licenses.filter(filter);
+        }
+        const auto compiledElapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - compiledStart);
+
+        // What a filter costs when every expression is parsed again for each query
+        std::vector<uint32_t> reparsed;
+        const auto reparseStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRepeats / 10; ++i) {
+            LicenseIndex index;
+            for (size_t ordinal = 0; ordinal < parser.getTotalComponentCount(); ++ordinal) {
+                index.add(parser.getComponentAt(ordinal)->projectLicense);
+            }
+            index.finish();
+            reparsed = index.filter(filter);
+        }
+        const auto reparseElapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - reparseStart);
+
+        spdlog::info("License filter '{}': {} components, bitset scan {:.2f} us, re-parse {:.1f} us per query{}",
+                     filter, compiled.size(), compiledElapsed.count() / kRepeats,
+                     reparseElapsed.count() / (kRepeats / 10), compiled == reparsed ? "" : " (MISMATCH)");
+        for (size_t i = 0; i < std::min<size_t>(3, compiled.size()); ++i) {
+            const auto component = parser.getComponentAt(compiled[i]);
+            spdlog::info("- {}: {}", component->id, component->projectLicense);
+        }
+    }
+}
+
+/// Parses "attribute=intensity[,...]" into limit; returns false on an unknown attribute or intensity.
+bool parseRatingLimit(const std::string &spec, ContentRating &limit) {
+    size_t start = 0;
+    while (start <= spec.size()) {
+        const auto end = std::min(spec.find(',', start), spec.size());
+        const std::string_view entry(spec.data() + start, end - start);
+        const auto equals = entry.find('=');
+        if (equals == std::string_view::npos || !limit.set(entry.substr(0, equals), entry.substr(equals + 1))) {
+            spdlog::error("Invalid rating limit '{}'", entry);
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
 int main(const int argc, char *argv[]) {
-    if (argc < 2) {
-        spdlog::error("Usage: {} <filename> [language]", argv[0]);
+    AppStreamParser::Options options;
+    int reloads = 0;
+    int queryRounds = 0;
+    double frameMillis = 0;
+    std::vector<std::string> queries;
+    std::vector<std::string> prefixes;
+    std::vector<std::string> related;
+    std::vector<std::string> publishers;
+    std::vector<std::string> browse;
+    std::vector<std::string> licenseFilters;
+    std::vector<std::string> substrings;
+    std::vector<std::string> aliases;
+    std::vector<std::string> similar;
+    std::string exportJson;
+    std::string exportBinary;
+    std::string batch;
+    std::string diskCatalog;
+    std::string installedList;
+    std::optional<ContentRating> ratingLimit;
+    ArtifactVerifier::Options verifyOptions;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (const std::string arg = argv[i]; arg == "--compress-text") {
+            options.compressDescriptions = true;
+        } else if (arg == "--reload" && i + 1 < argc) {
+            reloads = std::stoi(argv[++i]);
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            options.memoryBudget = std::stoul(argv[++i]) * 1024;
+        } else if (arg == "--frame-budget" && i + 1 < argc) {
+            frameMillis = std::stod(argv[++i]);
+        } else if (arg == "--repeat-queries" && i + 1 < argc) {
+            queryRounds = std::stoi(argv[++i]);
+        } else if (arg == "--search" && i + 1 < argc) {
+            queries.emplace_back(argv[++i]);
+        } else if (arg == "--substring" && i + 1 < argc) {
+            substrings.emplace_back(argv[++i]);
+        } else if (arg == "--complete" && i + 1 < argc) {
+            prefixes.emplace_back(argv[++i]);
+        } else if (arg == "--related" && i + 1 < argc) {
+            related.emplace_back(argv[++i]);
+        } else if (arg == "--similar" && i + 1 < argc) {
+            similar.emplace_back(argv[++i]);
+        } else if (arg == "--publisher" && i + 1 < argc) {
+            publishers.emplace_back(argv[++i]);
+        } else if (arg == "--resolve" && i + 1 < argc) {
+            aliases.emplace_back(argv[++i]);
+        } else if (arg == "--browse" && i + 1 < argc) {
+            browse.emplace_back(argv[++i]);
+        } else if (arg == "--license" && i + 1 < argc) {
+            licenseFilters.emplace_back(argv[++i]);
+        } else if (arg == "--export-json" && i + 1 < argc) {
+            exportJson = argv[++i];
+        } else if (arg == "--export-binary" && i + 1 < argc) {
+            exportBinary = argv[++i];
+        } else if (arg == "--disk-catalog" && i + 1 < argc) {
+            diskCatalog = argv[++i];
+        } else if (arg == "--check-updates" && i + 1 < argc) {
+            installedList = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = argv[++i];
+        } else if (arg == "--max-rating" && i + 1 < argc) {
+            ratingLimit = ContentRating::uniform(ContentRating::Intensity::INTENSE);
+            if (!parseRatingLimit(argv[++i], *ratingLimit)) {
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--verify-mirror" && i + 1 < argc) {
+            verifyOptions.mirrorRoot = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            verifyOptions.threads = std::stoul(argv[++i]);
+        } else if (arg == "--type" && i + 1 < argc) {
+            options.filter.types.push_back(Component::stringToComponentType(argv[++i]));
+        } else if (arg == "--bundle" && i + 1 < argc) {
+            options.filter.bundleTypes.push_back(Component::stringToBundleType(argv[++i]));
+        } else if (arg == "--arch" && i + 1 < argc) {
+            options.filter.architectures.emplace_back(argv[++i]);
+        } else if (arg == "--id-prefix" && i + 1 < argc) {
+            options.filter.idPrefixes.emplace_back(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            spdlog::error("Unknown option: {}", arg);
+            return EXIT_FAILURE;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty()) {
+        spdlog::error("Usage: {} [--compress-text] [--memory-budget <KB>] [--reload <count>] [--frame-budget <ms>] "
+                      "[--type <type>] [--bundle <type>] [--arch <arch>] [--id-prefix <prefix>] "
+                      "[--repeat-queries <rounds>] [--search <query>] [--substring <text>] [--complete <prefix>] "
+                      "[--related <id>] [--similar <id>] "
+                      "[--publisher <name>] [--browse <id-prefix>] [--resolve <kind>:<alias>] "
+                      "[--license <filter>] "
+                      "[--export-json <path>] [--export-binary <path>] [--max-rating <attr=intensity,...>] "
+                      "[--verify-mirror <dir>] [--disk-catalog <dir>] [--check-updates <file>] [--batch <file|->] "
+                      "[--threads <n>] "
+                      "<filename> [language]", argv[0]);
         return EXIT_FAILURE;
     }
 
-    std::string filename = argv[1];
-    std::string language = (argc >= 3) ? argv[2] : "";
+    if (!batch.empty()) {
+        // stdout carries the query results
+        spdlog::set_default_logger(spdlog::stderr_color_mt("stderr"));
+    }
+
+    std::string filename = args[0];
+    std::string language = (args.size() >= 2) ? args[1] : "";
 
     // Check if the file exists and get file size
     const long filesize = getFileSize(filename);
@@ -95,9 +1093,24 @@ int main(const int argc, char *argv[]) {
     spdlog::info("Before parser allocation - Virtual Memory: {} KB, Resident set size: {} KB", vm_usage, resident_set);
 
     try {
+        if (reloads > 0) {
+            runReloadBenchmark(filename, language, options, reloads);
+            return EXIT_SUCCESS;
+        }
+        if (!diskCatalog.empty()) {
+            runDiskCatalog(filename, language, options, diskCatalog);
+            return EXIT_SUCCESS;
+        }
+
         spdlog::info("Initializing AppStreamParser with file: '{}' and language: '{}'", filename, language);
 
-        auto parser = std::make_unique<AppStreamParser>(filename, language);
+        const auto parseStart = std::chrono::steady_clock::now();
+        auto parser = frameMillis > 0
+                          ? parseInFrames(filename, language, options, frameMillis)
+                          : std::make_unique<AppStreamParser>(filename, language, options);
+        const auto parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parseStart).count();
+        const double parseMBps = parseSeconds > 0 ? static_cast<double>(filesize) / 1e6 / parseSeconds : 0.0;
+        spdlog::info("Parsed in {:.1f} ms, {:.0f} MB/s", parseSeconds * 1000.0, parseMBps);
 
         // After parser allocation
         getMemoryUsage(vm_usage, resident_set);
@@ -105,15 +1118,73 @@ int main(const int argc, char *argv[]) {
                      resident_set);
 
         spdlog::info("Parsing completed. Total components: {}", parser->getTotalComponentCount());
+        if (!options.filter.empty()) {
+            spdlog::info("Filter skipped {} components", parser->getSkippedComponentCount());
+        }
 
         // After parsing
         getMemoryUsage(vm_usage, resident_set);
         spdlog::info("After parsing - Virtual Memory: {} KB, Resident set size: {} KB", vm_usage, resident_set);
 
-        const auto categories = parser->getUniqueCategories();
+        if (const auto releaseStats = parser->getReleaseStats(); releaseStats.releases) {
+            spdlog::info("Releases: {} releases, {} issues, {} artifacts, {} checksums in {} KB "
+                         "({} bytes per 1,000 releases)", releaseStats.releases, releaseStats.issues,
+                         releaseStats.artifacts, releaseStats.checksums, releaseStats.bytes / 1024,
+                         releaseStats.bytes * 1000 / releaseStats.releases);
+        }
+
+        if (!batch.empty()) {
+            runBatchQueries(*parser, batch, verifyOptions.threads);
+            return EXIT_SUCCESS;
+        }
+
+        if (options.compressDescriptions) {
+            const auto textStats = parser->getTextStoreStats();
+            spdlog::info("Compressed text: {} texts in {} blocks, {} KB raw, {} KB compressed ({:.1f}%)",
+                         textStats.texts, textStats.blocks, textStats.rawBytes / 1024,
+                         textStats.compressedBytes / 1024,
+                         textStats.rawBytes ? 100.0 * textStats.compressedBytes / textStats.rawBytes : 0.0);
+
+            // Sequential access shares inflated blocks; strided access defeats the block cache
+            const size_t count = parser->getTotalComponentCount();
+            for (const size_t stride: {size_t{1}, size_t{97}}) {
+                const auto start = std::chrono::steady_clock::now();
+                size_t bytes = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    bytes += parser->getDescription(*parser->getComponentAt(i * stride % count)).size();
+                }
+                const auto elapsed = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start);
+                spdlog::info("Description access (stride {}): {:.2f} us/access, {} KB", stride,
+                             count ? elapsed.count() / static_cast<double>(count) : 0.0, bytes / 1024);
+            }
+            const auto cacheStats = parser->getTextStoreStats();
+            spdlog::info("Text block cache: {} hits, {} misses", cacheStats.cacheHits, cacheStats.cacheMisses);
+        }
+
+        IconPolicy iconPolicy;
+        iconPolicy.size = 64;
+        iconPolicy.allowedTypes = IconPolicy::typeMask(Component::IconType::CACHED) |
+                                  IconPolicy::typeMask(Component::IconType::REMOTE);
+        auto iconStart = std::chrono::steady_clock::now();
+        const auto &bestIcons = parser->getBestIcons(iconPolicy);
+        auto iconElapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - iconStart);
+        size_t iconCount = 0;
+        for (size_t ordinal = 0; ordinal < bestIcons.size(); ++ordinal) {
+            if (bestIcons.iconIndex(ordinal) != IconIndex::kNoIcon) {
+                ++iconCount;
+            }
+        }
+        spdlog::info("Best icons for {}px: {} of {} components in {:.3f} ms (icons dir: {})", iconPolicy.size,
+                     iconCount, bestIcons.size(), iconElapsed.count(), parser->getIconsDirectory());
+        if (bestIcons.size()) {
+            spdlog::info("- {}: {}", parser->getComponentAt(0)->id, bestIcons.path(0));
+        }
+
+        const auto &categories = parser->getFacetCounts(AppStreamParser::Facet::CATEGORY);
         spdlog::info("Unique Categories:");
-        for (const auto &category: categories) {
-            spdlog::info("- {}", category);
+        for (const auto &[term, count]: categories) {
+            spdlog::info("- {} ({})", parser->getTerm(term), count);
         }
 
         // After getting unique categories
@@ -121,10 +1192,10 @@ int main(const int argc, char *argv[]) {
         spdlog::info("After getting unique categories - Virtual Memory: {} KB, Resident set size: {} KB", vm_usage,
                      resident_set);
 
-        const auto keywords = parser->getUniqueKeywords();
+        const auto &keywords = parser->getFacetCounts(AppStreamParser::Facet::KEYWORD);
         spdlog::info("Unique Keywords:");
-        for (const auto &keyword: keywords) {
-            spdlog::info("- {}", keyword);
+        for (const auto &[term, count]: keywords) {
+            spdlog::info("- {} ({})", parser->getTerm(term), count);
         }
 
         // After getting unique keywords
@@ -134,11 +1205,10 @@ int main(const int argc, char *argv[]) {
 
         // Example searches
         const std::string sampleCategory = "utility";
-        const auto componentsByCategory = parser->searchByCategory(sampleCategory);
-        spdlog::info("Components in category '{}', ({}):", sampleCategory, sampleCategory.size());
-        for (const auto &component: componentsByCategory) {
-            component->Dump();
-        }
+        // Ordinals rather than components, so that a memory budget also holds while querying
+        const auto byCategory = parser->findOrdinals(AppStreamParser::Facet::CATEGORY, sampleCategory);
+        spdlog::info("Components in category '{}', ({}):", sampleCategory, byCategory.size());
+        printComponents(*parser, {byCategory.begin(), byCategory.end()});
 
         // After searching by category
         getMemoryUsage(vm_usage, resident_set);
@@ -146,10 +1216,64 @@ int main(const int argc, char *argv[]) {
                      resident_set);
 
         const std::string sampleKeyword = "editor";
-        const auto componentsByKeyword = parser->searchByKeyword(sampleKeyword);
+        const auto byKeyword = parser->findOrdinals(AppStreamParser::Facet::KEYWORD, sampleKeyword);
+        const std::vector<uint32_t> componentsByKeyword(byKeyword.begin(), byKeyword.end());
         spdlog::info("Components with keyword '{}', ({}):", sampleKeyword, componentsByKeyword.size());
-        for (const auto &comp: componentsByKeyword) {
-            comp->Dump();
+        printComponents(*parser, componentsByKeyword);
+
+        const auto facetStart = std::chrono::steady_clock::now();
+        const auto keywordCategories = parser->getFacetCounts(AppStreamParser::Facet::CATEGORY, componentsByKeyword);
+        const auto facetElapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - facetStart);
+        spdlog::info("Categories of components with keyword '{}' ({:.1f} us):", sampleKeyword, facetElapsed.count());
+        for (const auto &[term, count]: keywordCategories) {
+            spdlog::info("- {} ({})", parser->getTerm(term), count);
+        }
+
+        if (queryRounds > 0) {
+            runQueryCacheBenchmark(*parser, queryRounds);
+        }
+        if (!queries.empty()) {
+            runSearchBenchmark(*parser, queries);
+        }
+        if (!substrings.empty()) {
+            runSubstringBenchmark(*parser, substrings);
+        }
+        if (!prefixes.empty()) {
+            runCompletionBenchmark(*parser, prefixes);
+        }
+        if (!related.empty()) {
+            runRelatedBenchmark(*parser, related);
+        }
+        if (!similar.empty()) {
+            runSimilarityBenchmark(*parser, similar);
+        }
+        if (!publishers.empty()) {
+            runPublisherQueries(*parser, publishers);
+        }
+        if (!browse.empty()) {
+            runIdBrowse(*parser, browse);
+        }
+        if (!aliases.empty()) {
+            runAliasResolution(*parser, aliases);
+        }
+        if (ratingLimit) {
+            runContentRatingFilter(*parser, *ratingLimit);
+        }
+        if (!licenseFilters.empty()) {
+            runLicenseFilter(*parser, licenseFilters);
+        }
+        if (!exportJson.empty()) {
+            runExport(*parser, exportJson, CatalogExporter::Format::JSON, parseMBps);
+        }
+        if (!exportBinary.empty()) {
+            runExport(*parser, exportBinary, CatalogExporter::Format::BINARY, parseMBps);
+        }
+        if (!verifyOptions.mirrorRoot.empty()) {
+            runMirrorVerification(*parser, verifyOptions);
+        }
+        if (!installedList.empty()) {
+            runUpdateCheck(*parser, installedList, verifyOptions.threads);
         }
 
         const auto components = parser->getComponents();
@@ -162,7 +1286,7 @@ int main(const int argc, char *argv[]) {
         getMemoryUsage(vm_usage, resident_set);
         spdlog::info("Before sorting - Virtual Memory: {} KB, Resident set size: {} KB", vm_usage,
                      resident_set);
-        const auto sortedById = parser->getSortedComponents(AppStreamParser::SortOption::BY_ID);
+        const auto sortedById = parser->getSortedOrdinals(AppStreamParser::SortOption::BY_ID);
         // After searching by keyword
         getMemoryUsage(vm_usage, resident_set);
         spdlog::info("After sorting - Virtual Memory: {} KB, Resident set size: {} KB", vm_usage,
@@ -173,6 +1297,17 @@ int main(const int argc, char *argv[]) {
         spdlog::info("After searching by keyword - Virtual Memory: {} KB, Resident set size: {} KB", vm_usage,
                      resident_set);
 
+        if (options.memoryBudget) {
+            const auto memoryStats = parser->getMemoryStats();
+            spdlog::info("Memory budget {} KB: {} components resident ({} KB), {} KB of catalog indexes and stores, "
+                         "{} KB spilled",
+                         memoryStats.budgetBytes / 1024, memoryStats.residentComponents,
+                         memoryStats.residentBytes / 1024, memoryStats.overheadBytes / 1024,
+                         memoryStats.spilledBytes / 1024);
+            spdlog::info("Spill cache: {} hits, {} misses, {} evictions, peak RSS {} KB", memoryStats.hits,
+                         memoryStats.misses, memoryStats.evictions, getPeakResidentSet());
+        }
+
         parser.reset();
 
         getMemoryUsage(vm_usage, resident_set);
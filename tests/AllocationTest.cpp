@@ -0,0 +1,114 @@
+/*
+ * Copyright 2024 Joel Winarske
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "AppStreamParser.h"
+
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <utility>
+
+// Counts every C++ heap allocation of the process
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(const std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Not inlined, so the compiler does not see free() on memory from operator new and warn about a mismatch
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+/**
+ * @brief Checks that elements retaining no data are parsed without heap allocations.
+ *
+ * Two catalogs are parsed whose single component repeats a block of elements
+ * that retain no data (overwritten fields, skipped translations, unknown
+ * elements, content attributes) 1000 and 2000 times; any allocation in the
+ * difference is parser overhead per element. Given a catalog, the
+ * allocations of parsing it are also reported per component.
+ *
+ * Usage: allocation_test [<filename> [language]]
+ */
+int main(const int argc, char *argv[]) {
+    constexpr size_t kBlockElements = 11;
+    const auto parseAllocations = [](const std::string &path, const std::string &language) {
+        const auto before = allocationCount.load();
+        const AppStreamParser parser(path, language);
+        return std::make_pair(allocationCount.load() - before, parser.getTotalComponentCount());
+    };
+    const auto writeCatalog = [](const std::string &path, const size_t repeats) {
+        std::ofstream out(path);
+        out << "<components version=\"1.0\"><component type=\"desktop-application\">"
+               "<id>org.example.Allocations</id>";
+        for (size_t i = 0; i < repeats; ++i) {
+            out << "<name>Allocation Counting Example</name>"
+                   "<name xml:lang=\"de\">Beispiel zum Zählen von Allokationen</name>"
+                   "<summary>Repeats elements that retain no data</summary>"
+                   "<url type=\"homepage\">https://example.org/allocations/homepage</url>"
+                   "<content_attribute id=\"violence-cartoon\">mild</content_attribute>"
+                   "<x-unknown-element-with-long-name>ignored text</x-unknown-element-with-long-name>"
+                   "<description xml:lang=\"de\"><p>Eine Beschreibung</p></description>"
+                   "<developer id=\"org.example\"><name>Example Developer Collective</name></developer>"
+                   "<project_license>GPL-3.0-or-later AND LicenseRef-proprietary</project_license>\n";
+        }
+        out << "</component></components>\n";
+    };
+
+    try {
+        const auto directory = std::filesystem::temp_directory_path();
+        const auto small = (directory / "appstream-allocations-1.xml").string();
+        const auto large = (directory / "appstream-allocations-2.xml").string();
+        writeCatalog(small, 1000);
+        writeCatalog(large, 2000);
+        const auto smallAllocations = parseAllocations(small, "en").first;
+        const auto largeAllocations = parseAllocations(large, "en").first;
+        std::filesystem::remove(small);
+        std::filesystem::remove(large);
+        const auto extra = largeAllocations > smallAllocations ? largeAllocations - smallAllocations : 0;
+        spdlog::info("Steady-state elements: {} allocations for {} extra elements ({:.3f} per element)", extra,
+                     1000 * kBlockElements, static_cast<double>(extra) / (1000 * kBlockElements));
+
+        if (argc > 1) {
+            const std::string filename = argv[1];
+            const auto [allocations, components] = parseAllocations(filename, argc > 2 ? argv[2] : "");
+            spdlog::info("Parsing '{}': {} allocations, {:.1f} per component", filename, allocations,
+                         components ? static_cast<double>(allocations) / static_cast<double>(components) : 0.0);
+        }
+        if (extra) {
+            spdlog::error("Parser allocates in steady state");
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &e) {
+        spdlog::error("Exception occurred: {}", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}